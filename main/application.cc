@@ -11,11 +11,15 @@
 #include "assets/lang_config.h"
 #include "mcp_server.h"
 #include "audio_debugger.h"
+#include "audio_trace.h"
+#include "settings.h"
 #include <esp_system.h>
 #include <esp_sleep.h>
 
 #if CONFIG_USE_AUDIO_PROCESSOR
 #include "afe_audio_processor.h"
+#elif CONFIG_USE_NLMS_AEC
+#include "nlms_audio_processor.h"
 #else
 #include "no_audio_processor.h"
 #endif
@@ -29,8 +33,10 @@
 #endif
 
 #include <cstring>
+#include <algorithm>
 #include <esp_log.h>
 #include <esp_system.h>
+#include <esp_heap_caps.h>
 #include <cJSON.h>
 #include <driver/gpio.h>
 #include <arpa/inet.h>
@@ -55,16 +61,16 @@ static const char* const STATE_STRINGS[] = {
 
 Application::Application() {
     event_group_ = xEventGroupCreate();
-    // 创建n个高优先级BackgroundTask线程，专门处理音频解码等实时任务(第二个参数)
+    // 下行解码使用独立的线程池，上行编码（包括音频测试模式）使用独立的编码任务（见 AudioEncodeLoop），互不阻塞
     // 优先级5：项目初始默认任务优先级2；可适当提升
-    // 栈大小：解码最小需要4KB*7;音频播放和解码已经完成解耦，使用独立任务播放队列。
-    background_task_ = std::make_unique<BackgroundTask>(4096 * 7, 1, 5);
+    // 栈大小：固定为 AUDIO_DECODE_TASK_STACK_SIZE，需覆盖所有解码路径，每次说话结束打印剩余最小值供核对
+    decode_task_ = std::make_unique<BackgroundTask>(AUDIO_DECODE_TASK_STACK_SIZE, AUDIO_DECODE_WORKERS, 5);
 
     ////初始化OTA相关参数
     ota_.SetCheckVersionUrl(CONFIG_OTA_URL);
     ota_.SetHeader("Device-Id", SystemInfo::GetMacAddress().c_str());
 
-#if CONFIG_USE_DEVICE_AEC
+#if CONFIG_USE_DEVICE_AEC || CONFIG_USE_NLMS_AEC
     aec_mode_ = kAecOnDeviceSide;
 #elif CONFIG_USE_SERVER_AEC
     aec_mode_ = kAecOnServerSide;
@@ -74,6 +80,8 @@ Application::Application() {
 
 #if CONFIG_USE_AUDIO_PROCESSOR
     audio_processor_ = std::make_unique<AfeAudioProcessor>();
+#elif CONFIG_USE_NLMS_AEC
+    audio_processor_ = std::make_unique<NlmsAudioProcessor>();
 #else
     audio_processor_ = std::make_unique<NoAudioProcessor>();
 #endif
@@ -104,7 +112,7 @@ Application::~Application() {
         esp_timer_stop(clock_timer_handle_);
         esp_timer_delete(clock_timer_handle_);
     }
-    // background_task_ 智能指针会自动释放
+    // decode_task_ 智能指针会自动释放
     vEventGroupDelete(event_group_);
 }
 
@@ -150,15 +158,13 @@ void Application::CheckNewVersion() {
           codec->EnableInput(false);  // 关闭麦克风输入
 
           // 清空音频队列并通知等待的线程
-          {
-            std::lock_guard<std::mutex> lock(mutex_);
-            audio_decode_queue_.clear();
-            audio_send_queue_.clear();
-            audio_decode_cv_.notify_all();
-          }
+          audio_decode_queue_.Clear();
+          audio_decode_cv_.notify_all();
+          uplink_pcm_ring_.Clear();
+          uplink_opus_ring_.Clear();
 
-          // 停止正在进行的背景任务
-          background_task_->WaitForCompletion();
+          // 停止正在进行的解码任务
+          decode_task_->WaitForCompletion();
 
           // 停止音频处理器和唤醒词检测
           audio_processor_->Stop();
@@ -212,6 +218,7 @@ void Application::CheckNewVersion() {
             // 重新启动音频处理器和唤醒词检测
             audio_processor_->Start();
             wake_word_->StartDetection();
+            WakeAudioLoop();
 
             ESP_LOGI(TAG, "Audio system recovery attempted");
           } catch (...) {
@@ -308,29 +315,32 @@ void Application::DismissAlert() {
 void Application::PlaySound(const std::string_view& sound) {
     // Wait for the previous sound to finish
     {
-        std::unique_lock<std::mutex> lock(mutex_);
-        audio_decode_cv_.wait(lock, [this]() {
-            return audio_decode_queue_.empty();
-        });
+        // 消费者通知时不持锁，用超时等待兜底，避免错过唤醒
+        std::unique_lock<std::mutex> lock(audio_decode_wait_mutex_);
+        while (!audio_decode_queue_.Empty() || prompt_source_.Active()) {
+            audio_decode_cv_.wait_for(lock, std::chrono::milliseconds(OPUS_FRAME_DURATION_MS));
+        }
     }
 
-    background_task_->WaitForCompletion();
-
-    const char* data = sound.data();
-    size_t size = sound.size();
-    for (const char* p = data; p < data + size; ) {
-        auto p3 = (BinaryProtocol3*)p;
-        p += sizeof(BinaryProtocol3);
+    decode_task_->WaitForCompletion();
 
-        auto payload_size = ntohs(p3->payload_size);
-        // 优化：直接提取原始音频数据，避免AudioStreamPacket封装
-        std::vector<uint8_t> raw_data(payload_size);
-        memcpy(raw_data.data(), p3->payload, payload_size);
-        p += payload_size;
-
-        std::lock_guard<std::mutex> lock(mutex_);
-        audio_decode_queue_.emplace_back(std::move(raw_data));
+    // 提示音在 flash 中原地引用，OnAudioOutput 逐包取出直接解码，不拷贝也不分配
+    if (!prompt_source_.Start(sound)) {
+        ESP_LOGE(TAG, "Invalid pre-decoded sound header, skip playing");
+        return;
     }
+    // 预解码提示音跳过解码和重采样，采样率和块大小必须匹配输出
+    if (prompt_source_.format() != PromptSource::kFormatOpus) {
+        auto codec = Board::GetInstance().GetAudioCodec();
+        if (prompt_source_.sample_rate() != codec->output_sample_rate() ||
+                prompt_source_.block_samples() > pcm_pool_->block_samples()) {
+            ESP_LOGE(TAG, "Pre-decoded sound (%d Hz, %u samples/block) does not match output (%d Hz, %u samples/block), skip playing",
+                prompt_source_.sample_rate(), (unsigned)prompt_source_.block_samples(),
+                codec->output_sample_rate(), (unsigned)pcm_pool_->block_samples());
+            prompt_source_.Stop();
+        }
+    }
+    WakeAudioLoop();
 }
 
 void Application::EnterAudioTestingMode() {
@@ -342,13 +352,13 @@ void Application::EnterAudioTestingMode() {
 void Application::ExitAudioTestingMode() {
     ESP_LOGI(TAG, "Exiting audio testing mode");
     SetDeviceState(kDeviceStateWifiConfiguring);
-    // 优化：将audio_testing_queue_转换为原始数据格式
-    std::lock_guard<std::mutex> lock(mutex_);
-    for (auto& packet : audio_testing_queue_) {
-        audio_decode_queue_.emplace_back(std::move(packet.payload));
+    // 录制的 Opus 包由 OnAudioOutput 像提示音一样逐包回放，不写入解码环形队列（它只有协议回调一个生产者）
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        audio_testing_replay_.splice(audio_testing_replay_.end(), audio_testing_queue_);
+        audio_testing_replaying_ = !audio_testing_replay_.empty();
     }
-    audio_testing_queue_.clear();
-    audio_decode_cv_.notify_all();
+    WakeAudioLoop();
 }
 
 void Application::ToggleChatState() {
@@ -456,23 +466,47 @@ void Application::Start() {
 
     /* Setup the audio codec */
     auto codec = board.GetAudioCodec();
-    opus_decoder_ = std::make_unique<OpusDecoderWrapper>(codec->output_sample_rate(), 1, OPUS_FRAME_DURATION_MS);
-    opus_encoder_ = std::make_unique<OpusEncoderWrapper>(16000, 1, OPUS_FRAME_DURATION_MS);
-    if (aec_mode_ != kAecOff) {
-        ESP_LOGI(TAG, "AEC mode: %d, setting opus encoder complexity to 0", aec_mode_);
-        opus_encoder_->SetComplexity(0);
-    } else if (board.GetBoardType() == "ml307") {
-        ESP_LOGI(TAG, "ML307 board detected, setting opus encoder complexity to 5");
-        opus_encoder_->SetComplexity(5);
-    } else {
-        ESP_LOGI(TAG, "WiFi board detected, setting opus encoder complexity to 0");
-        opus_encoder_->SetComplexity(0);
+    int pool_sample_rate = std::max(codec->output_sample_rate(), AUDIO_PCM_POOL_MIN_SAMPLE_RATE);
+    pcm_pool_ = std::make_unique<PcmPool>(AUDIO_PCM_POOL_BLOCKS, pool_sample_rate / 1000 * OPUS_FRAME_DURATION_MS);
+    // 服务端 hello 之前先按默认下行采样率选择解码采样率，协商后由 SetDecodeSampleRate 重建
+    opus_decoder_ = std::make_unique<OpusPlcDecoder>(ChooseDecodeSampleRate(AUDIO_DEFAULT_SERVER_SAMPLE_RATE), 1, OPUS_FRAME_DURATION_MS);
+    if (opus_decoder_->sample_rate() != codec->output_sample_rate()) {
+        ESP_LOGI(TAG, "Resampling audio from %d to %d", opus_decoder_->sample_rate(), codec->output_sample_rate());
+        output_resampler_.Configure(opus_decoder_->sample_rate(), codec->output_sample_rate());
     }
+    // 帧时长偏好：写入 hello，服务端回复的帧时长生效之前上下行都使用它
+    {
+        Settings settings("audio", false);
+        int frame_duration = settings.GetInt("frame_duration", OPUS_FRAME_DURATION_MS);
+        preferred_frame_duration_ = IsSupportedFrameDuration(frame_duration) ? frame_duration : OPUS_FRAME_DURATION_MS;
+        // 上行静音抑制：有音频处理器或本地 VAD 时按 VAD 门控，否则使用编码器 DTX
+#if CONFIG_USE_AUDIO_PROCESSOR || CONFIG_USE_LOCAL_VAD
+        int gate_mode = settings.GetInt("uplink_gate", UplinkGate::kModeVad);
+#else
+        int gate_mode = settings.GetInt("uplink_gate", UplinkGate::kModeDtx);
+#endif
+        if (gate_mode < UplinkGate::kModeOff || gate_mode > UplinkGate::kModeVad) {
+            gate_mode = UplinkGate::kModeOff;
+        }
+        uplink_router_.Configure((UplinkGate::Mode)gate_mode, AUDIO_UPLINK_HANGOVER_MS, AUDIO_UPLINK_KEEPALIVE_MS,
+            AUDIO_UPLINK_LOOKBACK_MS, AUDIO_CAPTURE_MAX_READ_MS);
+        uplink_preroll_ms_ = std::max(0, settings.GetInt("preroll_ms", AUDIO_UPLINK_PREROLL_MS));
+    }
+    CreateOpusEncoder(preferred_frame_duration_);
+    SetFrameDuration(preferred_frame_duration_);
 
     if (codec->input_sample_rate() != 16000) {
         input_resampler_.Configure(codec->input_sample_rate(), 16000);
         reference_resampler_.Configure(codec->input_sample_rate(), 16000);
     }
+    capture_frontend_.Configure(codec->input_channels(), codec->input_sample_rate(), 16000,
+        AUDIO_CAPTURE_MAX_READ_MS * 16000 / 1000 * codec->input_channels(),
+        [this](int channel, const int16_t* src, size_t samples, int16_t* dst) -> size_t {
+            auto& resampler = channel == 0 ? input_resampler_ : reference_resampler_;
+            resampler.Process(src, samples, dst);
+            return resampler.GetOutputSamples(samples);
+        });
+    capture_buffer_.reserve(AUDIO_CAPTURE_MAX_READ_MS * 16000 / 1000 * codec->input_channels());
     codec->Start();
 
 #if CONFIG_USE_AUDIO_PROCESSOR
@@ -488,51 +522,64 @@ void Application::Start() {
         vTaskDelete(NULL);
     }, "audio_loop", 4096 * 2, this, 8, &audio_loop_task_handle_);
 #endif
-    // 启动独立的播放任务：消费 PCM 播放队列并输出到 I2S
-#if CONFIG_USE_AUDIO_PROCESSOR
+    // 上行编码任务：与下行解码的线程池分开，长时间的解码不会推迟编码
+    uplink_staging_.reserve(sizeof(UplinkFrameHeader) + 1000);
     xTaskCreatePinnedToCore([](void* arg) {
         Application* app = (Application*)arg;
-        auto codec = Board::GetInstance().GetAudioCodec();
-        for (;;) {
-            std::unique_lock<std::mutex> lock(app->playback_mutex_);
-            app->playback_cv_.wait(lock, [app]() { return !app->audio_playback_queue_.empty(); });
-            auto pcm = std::move(app->audio_playback_queue_.front());
-            app->audio_playback_queue_.pop_front();
-            bool now_empty = app->audio_playback_queue_.empty();
-            lock.unlock();
-            auto t0 = std::chrono::steady_clock::now();
-            codec->OutputData(pcm);
-            auto ms = (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
-            ESP_LOGI(TAG, "[AUDIO-PLAYBACK] 🎧 output=%dms, queue=%u", ms, (unsigned)app->audio_playback_queue_.size());
-            if (now_empty) {
-                // 通知 STOP 等待者：队列可能已清空
-                app->playback_cv_.notify_all();
-            }
-        }
+        app->AudioEncodeLoop();
         vTaskDelete(NULL);
-    }, "audio_playback", 8192, this, 6, nullptr, 1);
+    }, "audio_encode", AUDIO_ENCODE_TASK_STACK_SIZE, this, AUDIO_ENCODE_TASK_PRIORITY,
+        &audio_encode_task_handle_, AUDIO_ENCODE_TASK_CORE);
+    // 启动独立的播放任务：消费 PCM 播放队列并输出到 I2S
+    // DMA 回调播放的编解码器由 I2S 发送回调取数据，解码结果直接写入编解码器，不需要播放任务
+    if (!codec->dma_playback()) {
+#if CONFIG_USE_AUDIO_PROCESSOR
+        xTaskCreatePinnedToCore([](void* arg) {
+            Application* app = (Application*)arg;
+            auto codec = Board::GetInstance().GetAudioCodec();
+            for (;;) {
+                std::unique_lock<std::mutex> lock(app->playback_mutex_);
+                app->playback_cv_.wait(lock, [app]() { return !app->audio_playback_queue_.empty(); });
+                auto pcm = std::move(app->audio_playback_queue_.front());
+                app->audio_playback_queue_.pop_front();
+                bool now_empty = app->audio_playback_queue_.empty();
+                lock.unlock();
+                auto& trace = AudioTrace::GetInstance();
+                trace.Record(AudioTrace::kOutputStart, pcm.trace_id());
+                codec->OutputData(pcm.data(), pcm.size());
+                trace.Record(AudioTrace::kOutputEnd, pcm.trace_id(), pcm.size());
+                app->RecordPlayback(pcm);
+                if (now_empty) {
+                    // 通知 STOP 等待者：队列可能已清空
+                    app->playback_cv_.notify_all();
+                }
+            }
+            vTaskDelete(NULL);
+        }, "audio_playback", 8192, this, 6, nullptr, 1);
 #else
-    xTaskCreate([](void* arg) {
-        Application* app = (Application*)arg;
-        auto codec = Board::GetInstance().GetAudioCodec();
-        for (;;) {
-            std::unique_lock<std::mutex> lock(app->playback_mutex_);
-            app->playback_cv_.wait(lock, [app]() { return !app->audio_playback_queue_.empty(); });
-            auto pcm = std::move(app->audio_playback_queue_.front());
-            app->audio_playback_queue_.pop_front();
-            bool now_empty = app->audio_playback_queue_.empty();
-            lock.unlock();
-            auto t0 = std::chrono::steady_clock::now();
-            codec->OutputData(pcm);
-            auto ms = (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
-            ESP_LOGI(TAG, "[AUDIO-PLAYBACK] 🎧 output=%dms, queue=%u", ms, (unsigned)app->audio_playback_queue_.size());
-            if (now_empty) {
-                app->playback_cv_.notify_all();
+        xTaskCreate([](void* arg) {
+            Application* app = (Application*)arg;
+            auto codec = Board::GetInstance().GetAudioCodec();
+            for (;;) {
+                std::unique_lock<std::mutex> lock(app->playback_mutex_);
+                app->playback_cv_.wait(lock, [app]() { return !app->audio_playback_queue_.empty(); });
+                auto pcm = std::move(app->audio_playback_queue_.front());
+                app->audio_playback_queue_.pop_front();
+                bool now_empty = app->audio_playback_queue_.empty();
+                lock.unlock();
+                auto& trace = AudioTrace::GetInstance();
+                trace.Record(AudioTrace::kOutputStart, pcm.trace_id());
+                codec->OutputData(pcm.data(), pcm.size());
+                trace.Record(AudioTrace::kOutputEnd, pcm.trace_id(), pcm.size());
+                app->RecordPlayback(pcm);
+                if (now_empty) {
+                    app->playback_cv_.notify_all();
+                }
             }
-        }
-        vTaskDelete(NULL);
-    }, "audio_playback", 8192, this, 6, nullptr);
+            vTaskDelete(NULL);
+        }, "audio_playback", 8192, this, 6, nullptr);
 #endif
+    }
 
 
     /* Start the clock timer to update the status bar */
@@ -586,6 +633,8 @@ void Application::Start() {
             }
 
             ESP_LOGI(TAG, "[Server-VAD] END received, transitioning to Speaking state");
+            // 传输层攒着的尾帧先于状态切换发出
+            protocol_->FlushAudio();
 
             // 直接转换到Speaking状态
             SetDeviceState(kDeviceStateSpeaking);
@@ -594,72 +643,52 @@ void Application::Start() {
     });
 
 
-    protocol_->OnIncomingAudio([this](std::vector<uint8_t>&& raw_data) {
-        // 统计信息（如需调试可开启）
-        // static uint32_t packet_counter = 0;
-        // static auto last_packet_time = std::chrono::steady_clock::now();
-        // auto current_time = std::chrono::steady_clock::now();
-        // auto interval_ms = std::chrono::duration_cast<std::chrono::milliseconds>(current_time - last_packet_time).count();
-        // last_packet_time = current_time;
-
-        std::lock_guard<std::mutex> lock(mutex_);
-        
+    protocol_->OnIncomingAudio([this](const uint8_t* data, size_t size, uint32_t timestamp) {
         // 检查是否应该接收音频数据
-        if (!aborted_ && device_state_ == kDeviceStateSpeaking) {
-            // 若未满，直接入队
-            if (audio_decode_queue_.size() < MAX_AUDIO_PACKETS_IN_QUEUE) {
-                audio_decode_queue_.emplace_back(std::move(raw_data));
-                ESP_LOGI(TAG, "[AUDIO-RX] 🔊 Added packet to queue, 📦NEW_SIZE=[%u/%d]",
-                         (unsigned)audio_decode_queue_.size(), MAX_AUDIO_PACKETS_IN_QUEUE);
-            } else {
-                // 队列已满：采用“间隔抽帧”策略，减少连续丢帧的可感知度
-                // 目标：抽走若干旧帧（每 AUDIO_THINNING_STRIDE 抽 1 帧），为新帧腾出空间
-                int removed = 0;
-                if (!audio_decode_queue_.empty()) {
-                    // 使用一次线性扫描实现间隔抽取：保留大多数旧帧，稀疏移除
-                    std::list<std::vector<uint8_t>> kept;
-                    size_t idx = 0;
-                    for (auto it = audio_decode_queue_.begin(); it != audio_decode_queue_.end(); ++it, ++idx) {
-                        bool should_remove = (idx % AUDIO_THINNING_STRIDE == (AUDIO_THINNING_STRIDE - 1))
-                                             && (removed < AUDIO_THINNING_MAX_REMOVE);
-                        if (should_remove) {
-                            removed++;
-                        } else {
-                            kept.emplace_back(std::move(*it));
-                        }
-                    }
-                    audio_decode_queue_.swap(kept);
-                }
+        if (aborted_ || device_state_ != kDeviceStateSpeaking) {
+            ESP_LOGW(TAG, "[AUDIO-RX] ❌ DROPPED packet - reason:%s, aborted:%d state:%d 📦QUEUE=[%u/%d] 🔧TASKS=%d",
+                     aborted_ ? "aborted" : "wrong_state", aborted_ ? 1 : 0, device_state_,
+                     (unsigned)audio_decode_queue_.Size(), MAX_AUDIO_PACKETS_IN_QUEUE, (int)decode_slots_.in_use());
+            return;
+        }
 
-                // 若通过抽帧成功释放了空间，则插入当前新帧；否则丢弃当前帧
-                if (audio_decode_queue_.size() < MAX_AUDIO_PACKETS_IN_QUEUE) {
-                    audio_decode_queue_.emplace_back(std::move(raw_data));
-                    ESP_LOGW(TAG, "[AUDIO-RX] ⚖️ thinning applied: removed=%d, new_size=%u/%d",
-                             removed, (unsigned)audio_decode_queue_.size(), MAX_AUDIO_PACKETS_IN_QUEUE);
-                } else {
-                    ESP_LOGW(TAG, "[AUDIO-RX] ❌ DROP new (queue_full even after thinning), kept=%u/%d",
-                             (unsigned)audio_decode_queue_.size(), MAX_AUDIO_PACKETS_IN_QUEUE);
-                }
-            }
+        // 无锁环形队列：不再与主循环共用 mutex_，也不再为每帧分配链表节点和 vector
+        // 每帧分配追踪 ID，随包经过解码、重采样直到 I2S 写入
+        auto& trace = AudioTrace::GetInstance();
+        uint32_t trace_id = trace.NewId();
+        // 协议回调是解码环形队列唯一的生产者，不需要加锁
+        if (audio_decode_queue_.Push(data, size, jitter_buffer_.StampPacket(timestamp), trace_id)) {
+            jitter_buffer_.OnPacketArrived(esp_timer_get_time(), audio_decode_queue_.Size());
+            trace.Record(AudioTrace::kRx, trace_id, size);
+            WakeAudioLoop();
         } else {
-            // 详细记录丢包原因
-            const char* drop_reason = "unknown";
-            if (aborted_) drop_reason = "aborted";
-            else if (device_state_ != kDeviceStateSpeaking) drop_reason = "wrong_state";
-            else drop_reason = "queue_full";
-
-            ESP_LOGW(TAG, "[AUDIO-RX] ❌ DROPPED packet - reason:%s, aborted:%d state:%d 📦QUEUE=[%u/%d] 🔧TASKS=%d",
-                     drop_reason, aborted_ ? 1 : 0, device_state_, (unsigned)audio_decode_queue_.size(),
-                     MAX_AUDIO_PACKETS_IN_QUEUE, active_decode_tasks_.load());
+            jitter_buffer_.OnPacketDropped();
+            trace.Record(AudioTrace::kRxDrop, trace_id, size);
+            ESP_LOGW(TAG, "[AUDIO-RX] ❌ DROP new (queue_full), 📦QUEUE=[%u/%d]",
+                     (unsigned)audio_decode_queue_.Size(), MAX_AUDIO_PACKETS_IN_QUEUE);
         }
     });
 
 
+    // 服务端在 hello 中选定下行采样率/帧长后重建解码器；按输出采样率解码时跳过重采样
+    // 回调在协议线程上：帧时长切换（重置抖动缓冲、调整流控）交给主循环，与其他调用方在同一线程
+    protocol_->OnServerAudioParams([this](int sample_rate, int frame_duration) {
+        // 上下行使用同一个帧时长；服务端给出不支持的帧时长时保持本端偏好
+        if (!IsSupportedFrameDuration(frame_duration)) {
+            ESP_LOGW(TAG, "Server frame duration %dms not supported, using %dms", frame_duration, preferred_frame_duration_);
+            frame_duration = preferred_frame_duration_;
+        }
+        Schedule([this, sample_rate, frame_duration]() {
+            SetFrameDuration(frame_duration);
+            SetDecodeSampleRate(ChooseDecodeSampleRate(sample_rate), frame_duration);
+        });
+    });
+
     protocol_->OnAudioChannelOpened([this, codec, &board]() {
         board.SetPowerSaveMode(false);
         if (protocol_->server_sample_rate() != codec->output_sample_rate()) {
-            ESP_LOGW(TAG, "Server sample rate %d does not match device output sample rate %d, resampling may cause distortion",
-                protocol_->server_sample_rate(), codec->output_sample_rate());
+            ESP_LOGI(TAG, "Server sample rate %d, device output sample rate %d, decoding at %d",
+                protocol_->server_sample_rate(), codec->output_sample_rate(), ChooseDecodeSampleRate(protocol_->server_sample_rate()));
         }
 
 #if CONFIG_IOT_PROTOCOL_XIAOZHI
@@ -694,9 +723,32 @@ void Application::Start() {
                 }
             } else if (strcmp(state->valuestring, "stop") == 0) {
                 ESP_LOGW(TAG, "--------------------GET STOP----------------------");
+                // 服务器已发送完毕：抖动缓冲不再等待预缓冲，剩余帧直接播放
+                jitter_buffer_.Drain();
                 Schedule([this]() {
+                    // 等待解码队列中剩余的帧和待补的丢失帧被取走
+                    while ((!audio_decode_queue_.Empty() || downlink_scheduler_.pending()) && !aborted_ &&
+                        device_state_ == kDeviceStateSpeaking) {
+                        vTaskDelay(pdMS_TO_TICKS(OPUS_FRAME_DURATION_MS));
+                    }
+
                     // 等待解码任务完成
-                    background_task_->WaitForCompletion();
+                    decode_task_->WaitForCompletion();
+
+                    auto jitter_stats = jitter_buffer_.GetStats();
+                    ESP_LOGI(TAG, "[JITTER] received=%u late=%u early=%u dropped=%u underruns=%u compressed=%u lost=%u concealed=%u jitter=%dms target=%dms",
+                             (unsigned)jitter_stats.received, (unsigned)jitter_stats.late, (unsigned)jitter_stats.early,
+                             (unsigned)jitter_stats.dropped, (unsigned)jitter_stats.underruns, (unsigned)jitter_stats.compressed,
+                             (unsigned)jitter_stats.lost, (unsigned)jitter_stats.concealed,
+                             jitter_stats.jitter_ms, jitter_stats.target_ms);
+                    auto pool_stats = pcm_pool_->GetStats();
+                    ESP_LOGI(TAG, "[PCM-POOL] blocks=%u in_use=%u high_water=%u exhausted=%u timeouts=%u",
+                             (unsigned)pool_stats.blocks, (unsigned)pool_stats.in_use, (unsigned)pool_stats.high_water,
+                             (unsigned)pool_stats.exhausted, (unsigned)pool_stats.timeouts);
+                    auto flow_stats = playback_flow_control_.GetStats();
+                    ESP_LOGI(TAG, "[FLOW] backpressure_events=%u throttled=%u play_q_high_water=%u",
+                             (unsigned)flow_stats.backpressure_events, (unsigned)flow_stats.throttled,
+                             (unsigned)flow_stats.queue_high_water);
 
                     // 等待播放队列清空：让已解码的PCM播放完毕，避免音频突然截断
                     ESP_LOGI(TAG, "[AUDIO-STOP] Waiting for playback queue to drain (no timeout)...");
@@ -704,6 +756,14 @@ void Application::Start() {
                     playback_cv_.wait(plock, [this]() { return audio_playback_queue_.empty(); });
                     plock.unlock();
                     ESP_LOGI(TAG, "[AUDIO-STOP] Playback queue drained, final size: %u", (unsigned)audio_playback_queue_.size());
+                    // DMA 回调播放：再等待编解码器环形缓冲中的样本送完
+                    auto codec = Board::GetInstance().GetAudioCodec();
+                    while (codec->OutputBufferedSamples() > 0 && !aborted_) {
+                        vTaskDelay(pdMS_TO_TICKS(10));
+                    }
+                    if (codec->dma_playback()) {
+                        ESP_LOGI(TAG, "[PLAYBACK] DMA underruns=%u", (unsigned)codec->OutputUnderruns());
+                    }
 
                     // Always honor stop even if speaking flag was not set due to ordering
                     aborted_ = false; // clear abort flag to allow next round
@@ -824,55 +884,45 @@ void Application::Start() {
             ESP_LOGW(TAG, "Unknown message type: %s", type->valuestring);
         }
     });
+    protocol_->SetPreferredFrameDuration(preferred_frame_duration_, OPUS_FRAME_DURATION_MS);
     bool protocol_started = protocol_->Start();
 
     audio_debugger_ = std::make_unique<AudioDebugger>();
     audio_processor_->Initialize(codec);
     audio_processor_->OnOutput([this](std::vector<int16_t>&& data) {
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            if (audio_send_queue_.size() >= MAX_AUDIO_PACKETS_IN_QUEUE) {
-                ESP_LOGW(TAG, "Too many audio packets in queue, drop the newest packet");
-                return;
-            }
+        // 只拷贝进 PCM 环，静音抑制和编码都在编码任务中进行
+        auto& trace = AudioTrace::GetInstance();
+        uint32_t trace_id = trace.NewId();
+        trace.Record(AudioTrace::kUplinkCapture, trace_id, data.size());
+        if (!uplink_pcm_ring_.Push((const uint8_t*)data.data(), data.size() * sizeof(int16_t),
+                (uint32_t)esp_timer_get_time(), trace_id)) {
+            ESP_LOGW(TAG, "Uplink PCM ring is full, drop the newest chunk");
+            encoder_controller_.OnDropped();
+            return;
         }
-        background_task_->Schedule([this, data = std::move(data)]() mutable {
-            opus_encoder_->Encode(std::move(data), [this](std::vector<uint8_t>&& opus) {
-                AudioStreamPacket packet;
-                packet.payload = std::move(opus);
-#ifdef CONFIG_USE_SERVER_AEC
-                {
-                    std::lock_guard<std::mutex> lock(timestamp_mutex_);
-                    if (!timestamp_queue_.empty()) {
-                        packet.timestamp = timestamp_queue_.front();
-                        timestamp_queue_.pop_front();
-                    } else {
-                        packet.timestamp = 0;
-                    }
-
-                    if (timestamp_queue_.size() > 3) { // 限制队列长度3
-                        timestamp_queue_.pop_front(); // 该包发送前先出队保持队列长度
-                        return;
-                    }
-                }
-#endif
-                std::lock_guard<std::mutex> lock(mutex_);
-                if (audio_send_queue_.size() >= MAX_AUDIO_PACKETS_IN_QUEUE) {
-                    ESP_LOGW(TAG, "Too many audio packets in queue, drop the oldest packet");
-                    audio_send_queue_.pop_front();
-                }
-                audio_send_queue_.emplace_back(std::move(packet));
-                xEventGroupSetBits(event_group_, SEND_AUDIO_EVENT);
-            });
-        });
+        xTaskNotifyGive(audio_encode_task_handle_);
     });
     audio_processor_->OnVadStateChange([this](bool speaking) {
+        // 上行门控在编码任务中直接读取，不经过主循环
+        uplink_vad_speaking_ = speaking;
         if (device_state_ == kDeviceStateListening) {
             Schedule([this, speaking]() {
                 if (speaking) {
                     voice_detected_ = true;
                 } else {
                     voice_detected_ = false;
+                    // 说话结束：立即发出传输层攒着的尾帧，不等延迟预算
+                    if (protocol_) {
+                        protocol_->FlushAudio();
+                    }
+#if CONFIG_LOCAL_VAD_AUTO_STOP
+                    // 本地端点：不等服务端 VAD 的 END，直接结束本轮，与收到 END 时一样进入等待回复
+                    if (listening_mode_ == kListeningModeAutoStop && device_state_ == kDeviceStateListening && protocol_) {
+                        ESP_LOGI(TAG, "[Local-VAD] end of speech, stop listening");
+                        protocol_->SendStopListening();
+                        SetDeviceState(kDeviceStateSpeaking);
+                    }
+#endif
                 }
                 auto led = Board::GetInstance().GetLed();
                 led->OnStateChanged();
@@ -895,6 +945,7 @@ void Application::Start() {
                     SetDeviceState(kDeviceStateConnecting);
                     if (!protocol_->OpenAudioChannel()) {
                         wake_word_->StartDetection();
+                        WakeAudioLoop();
                         return;
                     }
                 }
@@ -924,6 +975,7 @@ void Application::Start() {
         });
     });
     wake_word_->StartDetection();
+    WakeAudioLoop();
 
     // Wait for the new version check to finish
     xEventGroupWaitBits(event_group_, CHECK_NEW_VERSION_DONE_EVENT, pdTRUE, pdFALSE, portMAX_DELAY);
@@ -993,13 +1045,10 @@ void Application::MainEventLoop() {
         auto bits = xEventGroupWaitBits(event_group_, SCHEDULE_EVENT | SEND_AUDIO_EVENT, pdTRUE, pdFALSE, portMAX_DELAY);
 
         if (bits & SEND_AUDIO_EVENT) {
-            std::unique_lock<std::mutex> lock(mutex_);
-            auto packets = std::move(audio_send_queue_);
-            lock.unlock();
-            for (auto& packet : packets) {
-                if (!protocol_->SendAudio(packet)) {
-                    break;
-                }
+            SendUplinkFrames();
+            // 静音抑制期间不会再有新帧，尾帧不必等传输层的攒包延迟
+            if (uplink_router_.gate().idle()) {
+                protocol_->FlushAudio();
             }
         }
 
@@ -1019,45 +1068,39 @@ void Application::AudioLoop() {
     //ESP_LOGW(TAG, "=====================  AudioLoop  ======================");
     auto codec = Board::GetInstance().GetAudioCodec();
     while (true) {
-        OnAudioInput();
+        bool captured = OnAudioInput();
         if (codec->output_enabled()) {
             OnAudioOutput();
         }
+        if (captured) {
+            // 采集由 I2S 读取节拍驱动；记录状态变化后第一次读到音频的延迟
+            int64_t wake_time = audio_loop_wake_time_.exchange(0);
+            if (wake_time != 0) {
+                ESP_LOGI(TAG, "Capture started %ldus after state change", (long)(esp_timer_get_time() - wake_time));
+            }
+            continue;
+        }
+        // 没有需要采集的音频：输出开启时按半帧时长轮询播放，否则一直阻塞到 WakeAudioLoop
+        audio_loop_wake_time_ = 0;
+        TickType_t timeout = codec->output_enabled() ? pdMS_TO_TICKS(OPUS_FRAME_DURATION_MS / 2) : portMAX_DELAY;
+        ulTaskNotifyTake(pdTRUE, timeout);
+    }
+}
+
+void Application::WakeAudioLoop() {
+    if (audio_loop_task_handle_ != nullptr) {
+        xTaskNotifyGive(audio_loop_task_handle_);
     }
 }
 
 void Application::OnAudioOutput() {
-    // 修复：检查并发解码任务数，但允许一定的队列积压处理
     // 解码并发限制 & 播放队列背压：当播放队列达到高水位时，暂停新的解码调度
-    int current_tasks = active_decode_tasks_.load();
-    bool prev_bp = playback_backpressure_.load();
-    unsigned play_q_size = 0;
+    size_t play_q_size;
     {
         std::lock_guard<std::mutex> plock(playback_mutex_);
-        play_q_size = (unsigned)audio_playback_queue_.size();
-        bool new_bp = prev_bp;
-        if ((int)play_q_size >= PLAYBACK_HIGH_WATERMARK) new_bp = true;
-        else if ((int)play_q_size <= PLAYBACK_LOW_WATERMARK) new_bp = false;
-        if (new_bp != prev_bp) {
-            playback_backpressure_.store(new_bp);
-            if (new_bp) {
-                // ESP_LOGW(TAG, "[BACKPRESSURE] 🔴 ENTER backpressure: 📦PLAY_Q=[%u/%u], HIGH=%d, LOW=%d",
-                //          play_q_size, (unsigned)MAX_PLAYBACK_TASKS_IN_QUEUE,
-                //          PLAYBACK_HIGH_WATERMARK, PLAYBACK_LOW_WATERMARK);
-            } else {
-                // ESP_LOGI(TAG, "[BACKPRESSURE] 🟢 EXIT backpressure: 📦PLAY_Q=[%u/%u], HIGH=%d, LOW=%d",
-                //          play_q_size, (unsigned)MAX_PLAYBACK_TASKS_IN_QUEUE,
-                //          PLAYBACK_HIGH_WATERMARK, PLAYBACK_LOW_WATERMARK);
-            }
-        } else {
-            playback_backpressure_.store(new_bp);
-        }
-    }
-    if (playback_backpressure_.load()) {
-        // 背压生效：不再调度新的解码任务，让 OPUS 帧先积压在解码队列（内存小）
-        return;
+        play_q_size = audio_playback_queue_.size();
     }
-    if (current_tasks >= MAX_CONCURRENT_DECODE_TASKS) {
+    if (!playback_flow_control_.Admit(play_q_size, (int)decode_slots_.in_use())) {
         return;
     }
 
@@ -1065,8 +1108,60 @@ void Application::OnAudioOutput() {
     auto codec = Board::GetInstance().GetAudioCodec();
     const int max_silence_seconds = 10;
 
-    std::unique_lock<std::mutex> lock(mutex_);
-    if (audio_decode_queue_.empty()) {
+    // 准入已按在途上限放行，槽的数量与之相同
+    DecodeSlot* slot = decode_slots_.Acquire();
+    if (slot == nullptr) {
+        return;
+    }
+    auto& job = slot->job;
+
+    // 内置提示音优先：载荷直接引用 flash，无需抖动缓冲
+    PromptSource::Chunk prompt;
+    if (prompt_source_.Active()) {
+        if (prompt_source_.Next(prompt)) {
+            slot->mode = prompt.format == PromptSource::kFormatPcm16 ? kDecodePcm16
+                : prompt.format == PromptSource::kFormatAdpcm ? kDecodeAdpcm : kDecodeNormal;
+            job.sequence = decode_sequencer_.Next();
+            job.data = prompt.data;
+            job.size = prompt.size;
+            job.compress = false;
+            job.timestamp = 0;
+            job.trace_id = AudioTrace::GetInstance().NewId();
+            ScheduleDecode(slot);
+            return;
+        }
+        // 提示音播放完毕，唤醒等待下一段提示音的 PlaySound
+        audio_decode_cv_.notify_all();
+    }
+
+    // 测试模式的录音回放：同样不经过抖动缓冲，载荷拷贝到槽内
+    if (audio_testing_replaying_) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!audio_testing_replay_.empty()) {
+            auto packet = std::move(audio_testing_replay_.front());
+            audio_testing_replay_.pop_front();
+            if (packet.payload.size() > sizeof(job.buffer)) {
+                continue;
+            }
+            audio_testing_replaying_ = !audio_testing_replay_.empty();
+            lock.unlock();
+            slot->mode = kDecodeNormal;
+            memcpy(job.buffer, packet.payload.data(), packet.payload.size());
+            job.data = job.buffer;
+            job.size = packet.payload.size();
+            job.sequence = decode_sequencer_.Next();
+            job.compress = false;
+            job.timestamp = 0;
+            job.trace_id = AudioTrace::GetInstance().NewId();
+            ScheduleDecode(slot);
+            return;
+        }
+        audio_testing_replaying_ = false;
+    }
+
+    // 抖动缓冲决定本次是否取帧（预缓冲未满或欠载重缓冲时等待），丢失的帧每次只补一帧
+    if (!downlink_scheduler_.Next(job)) {
+        decode_slots_.Release(slot);
         // Disable the output if there is no audio data for a long time
         if (device_state_ == kDeviceStateIdle) {
             auto duration = std::chrono::duration_cast<std::chrono::seconds>(now - last_output_time_).count();
@@ -1076,116 +1171,155 @@ void Application::OnAudioOutput() {
         }
         return;
     }
+    if (job.released) {
+        audio_decode_cv_.notify_all();
+    }
+    if (job.lost_frames > 0) {
+        ESP_LOGW(TAG, "[AUDIO-OUT] Concealing %d lost frame(s)", job.lost_frames);
+    }
+    slot->mode = (DecodeMode)job.mode;
+    ScheduleDecode(slot);
+}
 
-    // 优化：直接处理原始音频数据，避免packet解包开销
-    auto raw_data = std::move(audio_decode_queue_.front());
-    audio_decode_queue_.pop_front();
-    // size_t remaining_queue_size = audio_decode_queue_.size(); // unused
-    lock.unlock();
-    audio_decode_cv_.notify_all();
-
-    // ESP_LOGI(TAG, "[AUDIO-OUT] 🎵 Processing packet: size=%u bytes, 📦REMAINING=[%u], 🔧TASKS=%d",
-    //          (unsigned)raw_data.size(), (unsigned)remaining_queue_size, active_decode_tasks_.load());
-
-    auto decode_start_time = std::chrono::steady_clock::now();
-    // ESP_LOGI(TAG, "[AUDIO-OUT] 🚀 Starting decode task, 📦QUEUE=[%u]",
-    //          (unsigned)remaining_queue_size);
-
-    background_task_->Schedule([this, codec, raw_data = std::move(raw_data), decode_start_time]() mutable {
-        auto decode_task_start = std::chrono::steady_clock::now();
-        auto schedule_delay_ms = std::chrono::duration_cast<std::chrono::milliseconds>(decode_task_start - decode_start_time).count();
+void Application::ScheduleDecode(DecodeSlot* slot) {
+    // 序号在调度时分配，占用的槽即在途帧，解码/重采样按序号依次执行，结果经重排后按序进入播放队列
+    // 只捕获两个指针：放得进 std::function 的内联存储，BackgroundTask 的环形队列也是预分配的，调度不分配内存
+    decode_task_->Schedule([this, slot]() {
+        DecodeFrame(slot);
+    });
+}
 
-        // 修复：在任务真正开始执行时才管理计数器
-        active_decode_tasks_.fetch_add(1);
-        int current_tasks = active_decode_tasks_.load();
-        if (aborted_) {
-            active_decode_tasks_.fetch_sub(1);
-            ESP_LOGW(TAG, "[AUDIO-OUT] Decode task aborted, remaining tasks: %d", current_tasks - 1);
-            return;
+void Application::DecodeFrame(DecodeSlot* slot) {
+    auto codec = Board::GetInstance().GetAudioCodec();
+    const auto mode = slot->mode;
+    const auto& job = slot->job;
+    const uint32_t sequence = job.sequence;
+    const uint32_t trace_id = job.trace_id;
+    auto& trace = AudioTrace::GetInstance();
+    PcmPool::Block pcm;
+    // 解码器可能在本帧解码之后被后续帧重建，重采样阶段使用本帧解码时的采样率
+    int decoded_sample_rate = codec->output_sample_rate();
+
+    // 阶段一：有状态的 Opus 解码，严格按序号执行
+    decode_sequencer_.BeginTurn(DecodeSequencer::kStageDecode, sequence);
+    // 中止或解码器已重置的帧仍然要走完各阶段，保证后续帧不被阻塞
+    bool skip = aborted_ || decode_sequencer_.IsStale(sequence);
+    if (!skip) {
+        trace.Record(AudioTrace::kDecodeStart, trace_id, mode);
+        decoded_sample_rate = opus_decoder_->sample_rate();
+        pcm = pcm_pool_->Acquire(OPUS_FRAME_DURATION_MS);
+        if (!pcm) {
+            ESP_LOGW(TAG, "[AUDIO-OUT] PCM pool exhausted, drop frame #%u", (unsigned)sequence);
+        } else {
+            const uint8_t* data = job.data;
+            size_t data_size = job.size;
+            int samples;
+            if (mode == kDecodePcm16 || mode == kDecodeAdpcm) {
+                // 预解码提示音：直接展开，不经过 Opus 解码器
+                PromptSource::Chunk chunk;
+                chunk.format = mode == kDecodePcm16 ? PromptSource::kFormatPcm16 : PromptSource::kFormatAdpcm;
+                chunk.data = data;
+                chunk.size = data_size;
+                samples = PromptSource::DecodePcm(chunk, pcm.data(), pcm.capacity());
+            } else if (mode == kDecodeConceal) {
+                samples = opus_decoder_->Conceal(pcm.data(), pcm.capacity());
+            } else if (mode == kDecodeFec) {
+                samples = opus_decoder_->DecodeFec(data, data_size, pcm.data(), pcm.capacity());
+            } else {
+                samples = opus_decoder_->Decode(data, data_size, pcm.data(), pcm.capacity());
+            }
+            if (samples < 0) {
+                ESP_LOGE(TAG, "[AUDIO-OUT] OPUS decode failed, mode=%d", (int)mode);
+                pcm.reset();
+            } else {
+                pcm.resize(samples);
+            }
         }
+        trace.Record(AudioTrace::kDecodeEnd, trace_id, pcm.size());
+    }
+    decode_sequencer_.EndTurn(DecodeSequencer::kStageDecode, sequence);
 
-        auto opus_decode_start = std::chrono::steady_clock::now();
-        std::vector<int16_t> pcm;
-        // 直接解码原始数据，固定参数：16000Hz, 60ms, 1通道
-        if (!opus_decoder_->Decode(std::move(raw_data), pcm)) {
-            ESP_LOGE(TAG, "[AUDIO-OUT] OPUS decode failed");
-            active_decode_tasks_.fetch_sub(1);
-            return;
-        }
-        auto opus_decode_end = std::chrono::steady_clock::now();
-        auto opus_decode_ms = std::chrono::duration_cast<std::chrono::milliseconds>(opus_decode_end - opus_decode_start).count();
-
-        // Resample if the sample rate is different
-        auto resample_start = std::chrono::steady_clock::now();
-        if (opus_decoder_->sample_rate() != codec->output_sample_rate()) {
-            int target_size = output_resampler_.GetOutputSamples(pcm.size());
-            std::vector<int16_t> resampled(target_size);
+    if (job.compress && !pcm.empty()) {
+        // 缓冲高于目标：移除约 10% 的样本，逐步收缩延迟（无状态，不占用解码顺序）
+        pcm.resize(JitterBuffer::CompressPcm(pcm.data(), pcm.size(), pcm.size() / 10));
+    }
+
+    // 阶段二：有状态的重采样，同样按序号执行，此时下一帧已经可以开始解码
+    decode_sequencer_.BeginTurn(DecodeSequencer::kStageResample, sequence);
+    bool predecoded = mode == kDecodePcm16 || mode == kDecodeAdpcm;
+    if (!pcm.empty() && !predecoded && decoded_sample_rate != codec->output_sample_rate()) {
+        auto resampled = pcm_pool_->Acquire(OPUS_FRAME_DURATION_MS);
+        size_t target_size = output_resampler_.GetOutputSamples(pcm.size());
+        if (resampled && target_size <= resampled.capacity()) {
             output_resampler_.Process(pcm.data(), pcm.size(), resampled.data());
+            resampled.resize(target_size);
             pcm = std::move(resampled);
-        }
-        auto resample_end = std::chrono::steady_clock::now();
-        auto resample_ms = std::chrono::duration_cast<std::chrono::milliseconds>(resample_end - resample_start).count();
-
-        // 改造：将 PCM 放入播放队列，交由独立播放任务处理，避免在解码线程阻塞
-        // 重要：只有解码成功且PCM非空时才入队
-        if (!pcm.empty()) {
-            std::lock_guard<std::mutex> plock(playback_mutex_);
-            // 只做硬上限保护，不丢帧：当超过硬上限时，不入队（回退由背压控制），避免OOM
-            if ((int)audio_playback_queue_.size() >= MAX_PLAYBACK_TASKS_IN_QUEUE) {
-                ESP_LOGW(TAG, "[AUDIO-PLAYBACK] ⏸️ playback queue at hard limit (%u/%u), skip enqueue; backpressure=%d",
-                         (unsigned)audio_playback_queue_.size(), (unsigned)MAX_PLAYBACK_TASKS_IN_QUEUE,
-                         (int)playback_backpressure_.load());
-            } else {
-                audio_playback_queue_.emplace_back(std::move(pcm));
-                playback_cv_.notify_one();
-            }
         } else {
-            ESP_LOGE(TAG, "[AUDIO-OUT] ❌ Decoded PCM is empty, skipping playback queue");
+            ESP_LOGW(TAG, "[AUDIO-OUT] No PCM block for resampling, drop frame #%u", (unsigned)sequence);
+            pcm.reset();
         }
+        trace.Record(AudioTrace::kResampleEnd, trace_id, pcm.size());
+    }
+    decode_sequencer_.EndTurn(DecodeSequencer::kStageResample, sequence);
+
+    // 阶段三：重排后按序号进入播放队列；空结果只占位不入队
+    pcm.set_trace_id(trace_id);
+    pcm.set_timestamp(job.timestamp);
+    // sink 只捕获 this，同样放得进 std::function 的内联存储
+    decode_sequencer_.Complete(sequence, std::move(pcm), [this](PcmPool::Block&& frame) {
+        OutputDecodedFrame(std::move(frame));
+    });
+    // 提交之后才归还槽：在途帧数（占用的槽）不超过保序器的重排深度
+    decode_slots_.Release(slot);
 
-        auto total_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - decode_start_time).count();
+    if (skip) {
+        ESP_LOGW(TAG, "[AUDIO-OUT] Decode task #%u skipped, in flight: %u", (unsigned)sequence, (unsigned)decode_slots_.in_use());
+        return;
+    }
 
-        // 任务完成，减少计数器
-        int remaining_tasks = active_decode_tasks_.fetch_sub(1) - 1;
-        ESP_LOGI(TAG, "[AUDIO-OUT] ✅ Decode complete: schedule_delay=%dms, opus=%dms, resample=%dms, enq_play=%dms, pcm_samples=%u, 📦PLAY_Q=[%u], 🔧REMAINING_TASKS=[%d]",
-                 (int)schedule_delay_ms, (int)opus_decode_ms, (int)resample_ms, (int)total_ms, (unsigned)pcm.size(), (unsigned)audio_playback_queue_.size(), remaining_tasks);
+    last_output_time_ = std::chrono::steady_clock::now();
+}
 
-#ifdef CONFIG_USE_SERVER_AEC
-        // 原始数据没有时间戳，使用当前时间
-        std::lock_guard<std::mutex> lock(timestamp_mutex_);
-        timestamp_queue_.push_back(0);
-#endif
-        last_output_time_ = std::chrono::steady_clock::now();
-    });
+void Application::OutputDecodedFrame(PcmPool::Block&& frame) {
+    auto codec = Board::GetInstance().GetAudioCodec();
+    auto& trace = AudioTrace::GetInstance();
+    if (codec->dma_playback()) {
+        // 写入编解码器的 DMA 环形缓冲，只在环满时等待；sink 在保序器的锁外执行，等待时其他解码线程不受影响
+        trace.Record(AudioTrace::kOutputStart, frame.trace_id());
+        codec->OutputData(frame.data(), frame.size());
+        trace.Record(AudioTrace::kOutputEnd, frame.trace_id(), frame.size());
+        RecordPlayback(frame);
+        return;
+    }
+    std::lock_guard<std::mutex> plock(playback_mutex_);
+    audio_playback_queue_.emplace_back(std::move(frame));
+    trace.Record(AudioTrace::kEnqueue, audio_playback_queue_.back().trace_id(), audio_playback_queue_.size());
+    playback_cv_.notify_one();
 }
 
-void Application::OnAudioInput() {
+bool Application::OnAudioInput() {
     //ESP_LOGW(TAG, "=====================  OnAudioInput  ======================");
 
     if (device_state_ == kDeviceStateAudioTesting) {
-        if (audio_testing_queue_.size() >= AUDIO_TESTING_MAX_DURATION_MS / OPUS_FRAME_DURATION_MS) {
+        int frame_duration = frame_duration_.load();
+        if (audio_testing_queue_.size() >= (size_t)(AUDIO_TESTING_MAX_DURATION_MS / frame_duration)) {
             ExitAudioTestingMode();
-            return;
+            return false;
         }
-        std::vector<int16_t> data;
-        int samples = OPUS_FRAME_DURATION_MS * 16000 / 1000;
-        if (ReadAudio(data, 16000, samples)) {
-            background_task_->Schedule([this, data = std::move(data)]() mutable {
-                opus_encoder_->Encode(std::move(data), [this](std::vector<uint8_t>&& opus) {
-                    AudioStreamPacket packet;
-                    packet.payload = std::move(opus);
-                    packet.frame_duration = OPUS_FRAME_DURATION_MS;
-                    packet.sample_rate = 16000;
-                    std::lock_guard<std::mutex> lock(mutex_);
-                    audio_testing_queue_.push_back(std::move(packet));
-                });
-            });
-            return;
+        int samples = frame_duration * 16000 / 1000;
+        if (ReadAudio(capture_buffer_, 16000, samples)) {
+            // 测试模式下的编码也在编码任务中进行，编码器只在编码任务中访问
+            if (!uplink_pcm_ring_.Push((const uint8_t*)capture_buffer_.data(), capture_buffer_.size() * sizeof(int16_t),
+                    (uint32_t)esp_timer_get_time())) {
+                ESP_LOGW(TAG, "Uplink PCM ring is full, drop the newest test chunk");
+                return true;
+            }
+            xTaskNotifyGive(audio_encode_task_handle_);
+            return true;
         }
     }
 
     if (wake_word_->IsDetectionRunning()) {
-        std::vector<int16_t> data;
         int mono_samples = wake_word_->GetFeedSize();
         if (mono_samples > 0) {
             // Ensure input is enabled in case some board/power path disabled it
@@ -1196,35 +1330,43 @@ void Application::OnAudioInput() {
 
             int input_channels = codec->input_channels();
             int capture_samples = mono_samples * (input_channels > 1 ? input_channels : 1);
-            if (ReadAudio(data, 16000, capture_samples)) {
+            if (ReadAudio(capture_buffer_, 16000, capture_samples)) {
                 if (input_channels > 1) {
                     // Down-mix to mono: pick MIC channel from interleaved data
-                    std::vector<int16_t> mono;
-                    mono.reserve(mono_samples);
-                    for (int i = 0; i < mono_samples; ++i) {
-                        mono.push_back(data[i * input_channels]);
-                    }
-                    wake_word_->Feed(mono);
+                    capture_mono_buffer_.resize(mono_samples);
+                    CaptureDeinterleave(capture_buffer_.data(), mono_samples, input_channels, 0, capture_mono_buffer_.data());
+                    wake_word_->Feed(capture_mono_buffer_);
                 } else {
-                    wake_word_->Feed(data);
+                    wake_word_->Feed(capture_buffer_);
                 }
-                return;
+                return true;
             }
         }
     }
 
     if (audio_processor_->IsRunning()) {
-        std::vector<int16_t> data;
         int samples = audio_processor_->GetFeedSize();
         if (samples > 0) {
-            if (ReadAudio(data, 16000, samples)) {
-                audio_processor_->Feed(data);
-                return;
+            auto codec = Board::GetInstance().GetAudioCodec();
+            if (!codec->input_enabled()) {
+                codec->EnableInput(true);
+            }
+            if (ReadAudio(capture_buffer_, 16000, samples)) {
+                audio_processor_->Feed(capture_buffer_);
+                return true;
             }
         }
     }
 
-    vTaskDelay(pdMS_TO_TICKS(OPUS_FRAME_DURATION_MS / 2));
+    // 唤醒词、音频处理器和测试模式都不需要音频：关闭麦克风输入，省去空闲时的 I2S 接收
+    // 空闲电流的收益尚未实测；重新开启输入的延迟见 AudioLoop 中的 "Capture started" 日志
+    if (device_state_ != kDeviceStateAudioTesting && !wake_word_->IsDetectionRunning() && !audio_processor_->IsRunning()) {
+        auto codec = Board::GetInstance().GetAudioCodec();
+        if (codec->input_enabled()) {
+            codec->EnableInput(false);
+        }
+    }
+    return false;
 }
 
 bool Application::ReadAudio(std::vector<int16_t>& data, int sample_rate, int samples) {
@@ -1234,38 +1376,19 @@ bool Application::ReadAudio(std::vector<int16_t>& data, int sample_rate, int sam
     }
 
     if (codec->input_sample_rate() != sample_rate) {
-        data.resize(samples * codec->input_sample_rate() / sample_rate);
-        if (!codec->InputData(data)) {
+        // 解交织、逐声道重采样和交织都在 capture_frontend_ 的预分配缓冲中完成
+        size_t raw_samples;
+        int16_t* raw = capture_frontend_.PrepareRead(samples, raw_samples);
+        if (!codec->InputData(raw, raw_samples)) {
             return false;
         }
-        if (codec->input_channels() == 2) {
-            auto mic_channel = std::vector<int16_t>(data.size() / 2);
-            auto reference_channel = std::vector<int16_t>(data.size() / 2);
-            for (size_t i = 0, j = 0; i < mic_channel.size(); ++i, j += 2) {
-                mic_channel[i] = data[j];
-                reference_channel[i] = data[j + 1];
-            }
-            auto resampled_mic = std::vector<int16_t>(input_resampler_.GetOutputSamples(mic_channel.size()));
-            auto resampled_reference = std::vector<int16_t>(reference_resampler_.GetOutputSamples(reference_channel.size()));
-            input_resampler_.Process(mic_channel.data(), mic_channel.size(), resampled_mic.data());
-            reference_resampler_.Process(reference_channel.data(), reference_channel.size(), resampled_reference.data());
-            data.resize(resampled_mic.size() + resampled_reference.size());
-            for (size_t i = 0, j = 0; i < resampled_mic.size(); ++i, j += 2) {
-                data[j] = resampled_mic[i];
-                data[j + 1] = resampled_reference[i];
-            }
-        } else {
-            auto resampled = std::vector<int16_t>(input_resampler_.GetOutputSamples(data.size()));
-            input_resampler_.Process(data.data(), data.size(), resampled.data());
-            data = std::move(resampled);
-        }
+        capture_frontend_.Process(raw_samples, data);
     } else {
         data.resize(samples);
         if (!codec->InputData(data)) {
             return false;
         }
     }
-
     // 音频调试：发送原始音频数据
     if (audio_debugger_) {
         audio_debugger_->Feed(data);
@@ -1303,8 +1426,50 @@ void Application::SetDeviceState(DeviceState state) {
     auto previous_state = device_state_;
     device_state_ = state;
     ESP_LOGI(TAG, "STATE CHANGE: %s -> %s", STATE_STRINGS[previous_state], STATE_STRINGS[device_state_]);
-    // The state is changed, wait for all background tasks to finish
-    background_task_->WaitForCompletion();
+    if (previous_state == kDeviceStateListening && uplink_router_.gate().mode() != UplinkGate::kModeOff) {
+        auto stats = uplink_router_.gate().GetStats();
+        int frame_duration = frame_duration_.load();
+        ESP_LOGI(TAG, "Uplink gate: captured %ums, suppressed %u frames (vad %ums, dtx %u), markers %u",
+            (unsigned)stats.captured_ms, (unsigned)(stats.suppressed_ms / frame_duration + stats.dtx_dropped),
+            (unsigned)stats.suppressed_ms, (unsigned)stats.dtx_dropped, (unsigned)stats.markers);
+    }
+    if (previous_state == kDeviceStateListening) {
+        auto wait_encode = uplink_latency_.capture_to_encode.Get();
+        auto encode = uplink_latency_.encode.Get();
+        auto wait_send = uplink_latency_.encode_to_send.Get();
+        auto send = uplink_latency_.send.Get();
+        auto end_to_end = uplink_latency_.end_to_end.Get();
+        ESP_LOGI(TAG, "Uplink latency (mean/max us): wait_encode %u/%u, encode %u/%u, wait_send %u/%u, send %u/%u, end_to_end %u/%u over %u frames",
+            (unsigned)wait_encode.mean_us, (unsigned)wait_encode.max_us, (unsigned)encode.mean_us, (unsigned)encode.max_us,
+            (unsigned)wait_send.mean_us, (unsigned)wait_send.max_us, (unsigned)send.mean_us, (unsigned)send.max_us,
+            (unsigned)end_to_end.mean_us, (unsigned)end_to_end.max_us, (unsigned)end_to_end.count);
+        // 编码任务栈的剩余最小值（字节），AUDIO_ENCODE_TASK_STACK_SIZE 按各板子上测得的值加余量确定
+        ESP_LOGI(TAG, "Encode task stack: %u of %u bytes never used", (unsigned)uxTaskGetStackHighWaterMark(audio_encode_task_handle_),
+            (unsigned)AUDIO_ENCODE_TASK_STACK_SIZE);
+#ifdef CONFIG_USE_SERVER_AEC
+        auto clock = playback_clock_.GetStats();
+        ESP_LOGI(TAG, "AEC reference: %u/%u frames matched, %u playback frames, %u resyncs, last correction %ldus",
+            (unsigned)clock.hits, (unsigned)(clock.hits + clock.misses), (unsigned)clock.frames,
+            (unsigned)clock.resyncs, (long)clock.last_correction_us);
+#endif
+    }
+    if (state == kDeviceStateAudioTesting) {
+        ResetUplink();
+        uplink_session_.fetch_or(kUplinkTesting);
+    } else if (previous_state == kDeviceStateAudioTesting) {
+        // 先清除标志，ExitAudioTestingMode 随后在 mutex_ 内取走录音，编码任务之后编出的帧不再加入
+        uplink_session_.fetch_and(~(uint32_t)kUplinkTesting);
+    }
+    if (previous_state == kDeviceStateConnecting && state != kDeviceStateListening &&
+        (uplink_session_.load() & kUplinkPreroll)) {
+        // 通道没有建立起来：请求重置和结束预录一次写入，编码任务不会把预录的音频补发出去
+        uplink_session_.store(kUplinkReset);
+    }
+    // The state is changed, wait for all decode tasks to finish
+    decode_task_->WaitForCompletion();
+    if (previous_state == kDeviceStateSpeaking) {
+        LogDecodeStackUsage();
+    }
 
     auto& board = Board::GetInstance();
     auto display = board.GetDisplay();
@@ -1327,7 +1492,14 @@ void Application::SetDeviceState(DeviceState state) {
             display->SetStatus(Lang::Strings::CONNECTING);
             display->SetEmotion("neutral");
             display->SetChatMessage("system", "");
-            timestamp_queue_.clear();
+            playback_clock_.Clear();
+            // 建立通道可能阻塞数秒：提前开始采集，唤醒词之后马上说的话先存入预录环
+            if (uplink_preroll_ms_ > 0 && !audio_processor_->IsRunning()) {
+                ResetUplink();
+                uplink_session_.fetch_or(kUplinkPreroll);
+                audio_processor_->Start();
+                wake_word_->StopDetection();
+            }
             break;
         case kDeviceStateListening:
         ESP_LOGW(TAG, "=====================  Listening  ======================");
@@ -1345,15 +1517,19 @@ void Application::SetDeviceState(DeviceState state) {
                 // Send the start listening command
                 //protocol_->SendStartListening(listening_mode_);
                 if (previous_state == kDeviceStateSpeaking) {
-                    audio_decode_queue_.clear();
+                    audio_decode_queue_.Clear();
                     audio_decode_cv_.notify_all();
                     // FIXME: Wait for the speaker to empty the buffer
                     vTaskDelay(pdMS_TO_TICKS(120));
                 }
-                opus_encoder_->ResetState();
+                ResetUplink();
                 audio_processor_->Start();
                 wake_word_->StopDetection();
             }
+            if (uplink_session_.fetch_and(~(uint32_t)kUplinkPreroll) & kUplinkPreroll) {
+                // 通道已就绪：通知编码任务补发预录的音频
+                xTaskNotifyGive(audio_encode_task_handle_);
+            }
             break;
         case kDeviceStateSpeaking:
         ESP_LOGW(TAG, "=====================  Speaking  ======================");
@@ -1375,37 +1551,439 @@ void Application::SetDeviceState(DeviceState state) {
             // Do nothing
             break;
     }
+    // 采集循环空闲时阻塞等待，状态变化后立即重新判断是否需要采集
+    audio_loop_wake_time_ = esp_timer_get_time();
+    WakeAudioLoop();
 }
 
 void Application::ResetDecoder() {
-    std::lock_guard<std::mutex> lock(mutex_);
     opus_decoder_->ResetState();
-    // 优化：清理原始音频数据队列
-    size_t cleared_packets = audio_decode_queue_.size();
-    audio_decode_queue_.clear();
+    // 清理解码环形队列：Clear 可在任意线程调用，由消费者在下一次取包时生效
+    size_t cleared_packets = audio_decode_queue_.Size();
+    audio_decode_queue_.Clear();
+    prompt_source_.Stop();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        audio_testing_replay_.clear();
+        audio_testing_replaying_ = false;
+    }
+    jitter_buffer_.Reset();
+    decode_sequencer_.Reset();
     audio_decode_cv_.notify_all();
     last_output_time_ = std::chrono::steady_clock::now();
     auto codec = Board::GetInstance().GetAudioCodec();
+    // DMA 回调播放：环形缓冲里最多还有 AUDIO_CODEC_DMA_RING_MS 的旧音频，打断时不再放完
+    codec->FlushOutput();
     codec->EnableOutput(true);
+    WakeAudioLoop();
 
     ESP_LOGI(TAG, "[AUDIO-RESET] 🔄 Decoder reset, 📦CLEARED=[%u] packets, output enabled", (unsigned)cleared_packets);
 }
 
-void Application::SetDecodeSampleRate(int sample_rate, int frame_duration) {
-    if (opus_decoder_->sample_rate() == sample_rate && opus_decoder_->duration_ms() == frame_duration) {
+bool Application::IsSupportedFrameDuration(int frame_duration) {
+    // 不超过 OPUS_FRAME_DURATION_MS：PCM 块按它分配
+    return (frame_duration == 20 || frame_duration == 40 || frame_duration == 60) &&
+        frame_duration <= OPUS_FRAME_DURATION_MS;
+}
+
+void Application::CreateOpusEncoder(int frame_duration) {
+    auto& board = Board::GetInstance();
+    opus_encoder_ = std::make_unique<OpusUplinkEncoder>(16000, 1, frame_duration);
+    encoder_frame_duration_ = frame_duration;
+
+    // 起始复杂度与原先固定的取值相同，之后由 encoder_controller_ 在范围内调整
+    EncoderController::Limits limits;
+    int complexity;
+    if (board.GetBoardType() == "ml307") {
+        limits.max_complexity = AUDIO_ENCODER_4G_MAX_COMPLEXITY;
+        limits.min_bitrate = AUDIO_ENCODER_4G_MIN_BITRATE;
+        limits.max_bitrate = AUDIO_ENCODER_4G_MAX_BITRATE;
+        complexity = 5;
+    } else {
+        limits.max_complexity = AUDIO_ENCODER_WIFI_MAX_COMPLEXITY;
+        limits.min_bitrate = AUDIO_ENCODER_WIFI_MIN_BITRATE;
+        limits.max_bitrate = AUDIO_ENCODER_WIFI_MAX_BITRATE;
+        complexity = 0;
+    }
+    if (aec_mode_ != kAecOff) {
+        limits.max_complexity = AUDIO_ENCODER_AEC_MAX_COMPLEXITY;
+        complexity = 0;
+    }
+    encoder_controller_.Configure(limits, complexity, frame_duration);
+    ESP_LOGI(TAG, "Opus encoder: %dms, complexity %d..%d, bitrate %d..%d", frame_duration,
+        limits.min_complexity, limits.max_complexity, limits.min_bitrate, limits.max_bitrate);
+    ApplyEncoderSettings(encoder_controller_.settings());
+}
+
+void Application::AudioEncodeLoop() {
+    PacketRing::Packet chunk;
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        UpdateUplinkSession();
+        while (uplink_pcm_ring_.Acquire(chunk)) {
+            uint32_t now = (uint32_t)esp_timer_get_time();
+            AudioTrace::GetInstance().Record(AudioTrace::kUplinkEncodeStart, chunk.trace_id);
+            uplink_latency_.capture_to_encode.Add(now - chunk.timestamp);
+
+            uint32_t session = UpdateUplinkSession();
+            if (session & kUplinkTesting) {
+                RecordTestingChunk((const int16_t*)chunk.data, chunk.size / sizeof(int16_t));
+            } else if (session & kUplinkPreroll) {
+                HoldPreroll(chunk);
+            } else {
+                ProcessUplinkChunk((const int16_t*)chunk.data, chunk.size / sizeof(int16_t), chunk.timestamp, chunk.trace_id);
+            }
+            uplink_pcm_ring_.Release();
+        }
+    }
+}
+
+uint32_t Application::UpdateUplinkSession() {
+    // 帧时长变化后的第一个采集块：按新时长重建编码器
+    int frame_duration = frame_duration_.load();
+    if (encoder_frame_duration_ != frame_duration) {
+        CreateOpusEncoder(frame_duration);
+    }
+    uint32_t session = uplink_session_.fetch_and(~(uint32_t)kUplinkReset);
+    bool preroll = session & kUplinkPreroll;
+    if (session & kUplinkReset) {
+        opus_encoder_->ResetState();
+        uplink_router_.Reset();
+        uplink_preroll_ring_.reset();
+        uplink_preroll_skipped_ = false;
+    }
+    if (preroll) {
+        if (!uplink_preroll_ring_ && !uplink_preroll_skipped_) {
+            // 预录环按 16kHz 单声道 PCM 的字节数分配，采集块不短于 16ms
+            size_t slab_size = uplink_preroll_ms_ * 16 * sizeof(int16_t);
+            size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+            if (largest >= slab_size + AUDIO_UPLINK_PREROLL_HEAP_RESERVE) {
+                uplink_preroll_ring_ = std::make_unique<PacketRing>(uplink_preroll_ms_ / 16 + 4, slab_size);
+            } else {
+                ESP_LOGW(TAG, "Pre-roll: skipped, largest free block %u bytes", (unsigned)largest);
+                uplink_preroll_skipped_ = true;
+            }
+        }
+    } else if (uplink_preroll_ring_) {
+        if (!uplink_preroll_ring_->Empty()) {
+            FlushPreroll();
+        }
+        // 预录环只在建立通道期间占用内存
+        uplink_preroll_ring_.reset();
+    }
+    return session & ~(uint32_t)kUplinkReset;
+}
+
+void Application::RecordTestingChunk(const int16_t* pcm, size_t samples) {
+    opus_encoder_->Encode(pcm, samples, [this](const uint8_t* opus, size_t size) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!(uplink_session_.load() & kUplinkTesting)) {
+            return;
+        }
+        AudioStreamPacket packet;
+        packet.payload.assign(opus, opus + size);
+        packet.frame_duration = encoder_frame_duration_;
+        packet.sample_rate = 16000;
+        audio_testing_queue_.push_back(std::move(packet));
+    });
+}
+
+void Application::HoldPreroll(const PacketRing::Packet& chunk) {
+    if (!uplink_preroll_ring_) {
+        return;
+    }
+    // 预录环的生产者和消费者都是编码任务，满了就从消费端丢弃最旧的块
+    PacketRing::Packet oldest;
+    while (!uplink_preroll_ring_->Push(chunk.data, chunk.size, chunk.timestamp, chunk.trace_id)) {
+        if (!uplink_preroll_ring_->Acquire(oldest)) {
+            break;
+        }
+        uplink_preroll_ring_->Release();
+    }
+}
+
+void Application::FlushPreroll() {
+    // 按编码速度一次性补发，不经过静音抑制：预录期间的 VAD 状态已经过时，说的话应当全部送达
+    int64_t start_time = esp_timer_get_time();
+    size_t samples = 0;
+    PacketRing::Packet chunk;
+    while (uplink_preroll_ring_->Acquire(chunk)) {
+        EncodeUplink((const int16_t*)chunk.data, chunk.size / sizeof(int16_t), chunk.timestamp, chunk.trace_id);
+        samples += chunk.size / sizeof(int16_t);
+        uplink_preroll_ring_->Release();
+    }
+    // 静音抑制从通道就绪的这一刻开始计时，门控处于打开状态
+    uplink_router_.Reset();
+    ESP_LOGI(TAG, "Pre-roll: flushed %ums of audio in %ums", (unsigned)(samples / 16),
+        (unsigned)((esp_timer_get_time() - start_time) / 1000));
+}
+
+void Application::ProcessUplinkChunk(const int16_t* pcm, size_t samples, uint32_t capture_us, uint32_t trace_id) {
+    // 静音抑制：没人说话时不编码，只保留最近 AUDIO_UPLINK_LOOKBACK_MS 的音频
+    auto action = uplink_router_.OnCapture(uplink_vad_speaking_.load(), pcm, samples);
+    if (action == UplinkGate::kMarker) {
+        uint8_t marker = UplinkGate::DtxMarker(encoder_frame_duration_);
+        PushUplinkFrame(&marker, 1, 0, capture_us, trace_id);
+        return;
+    }
+    if (action == UplinkGate::kEnterSilence) {
+        // 唤醒主循环，让传输层发出攒着的尾帧
+        xEventGroupSetBits(event_group_, SEND_AUDIO_EVENT);
+        return;
+    }
+    if (action == UplinkGate::kSuppress) {
         return;
     }
+    if (action == UplinkGate::kResume) {
+        // 补发 VAD 判定前的音频，避免截掉词首
+        opus_encoder_->ResetState();
+        auto& lookback = uplink_router_.lookback();
+        EncodeUplink(lookback.data(), lookback.size(), capture_us, trace_id);
+    }
+    EncodeUplink(pcm, samples, capture_us, trace_id);
+}
 
-    opus_decoder_.reset();
-    opus_decoder_ = std::make_unique<OpusDecoderWrapper>(sample_rate, 1, frame_duration);
+void Application::EncodeUplink(const int16_t* pcm, size_t samples, uint32_t capture_us, uint32_t trace_id) {
+    // 回调只捕获 this，放得进 std::function 的内联存储；本次的采集时间和追踪 ID 经成员传给回调
+    encode_capture_us_ = capture_us;
+    encode_trace_id_ = trace_id;
+    opus_encoder_->Encode(pcm, samples, [this](const uint8_t* opus, size_t size) {
+        uint32_t encode_us = opus_encoder_->last_encode_us();
+        encoder_controller_.OnFrameEncoded(encode_us);
+        uplink_latency_.encode.Add(encode_us);
+
+        auto action = uplink_router_.gate().OnEncoded(size, encoder_frame_duration_);
+        if (action == UplinkGate::kEnterSilence) {
+            xEventGroupSetBits(event_group_, SEND_AUDIO_EVENT);
+        }
+        if (action != UplinkGate::kPass && action != UplinkGate::kMarker) {
+            return;
+        }
+        uint32_t timestamp = 0;
+#ifdef CONFIG_USE_SERVER_AEC
+        // 回声参考：本帧第一个样本被采集时扬声器正在放出的下行音频的时间戳，没有下行在播放时为 0
+        timestamp = playback_clock_.Lookup(encode_capture_us_ - encoder_frame_duration_ * 1000);
+#endif
+        PushUplinkFrame(opus, size, timestamp, encode_capture_us_, encode_trace_id_);
+    });
+    EncoderController::Settings settings;
+    if (encoder_controller_.Evaluate(settings)) {
+        ApplyEncoderSettings(settings);
+        auto stats = encoder_controller_.GetStats();
+        ESP_LOGI(TAG, "Opus encoder: complexity=%d bitrate=%d vbr=%d%s dtx=%d (down/up: complexity %u/%u, bitrate %u/%u)",
+            settings.complexity, settings.bitrate, settings.vbr, settings.constrained_vbr ? "(constrained)" : "",
+            settings.dtx, (unsigned)stats.complexity_down, (unsigned)stats.complexity_up,
+            (unsigned)stats.bitrate_down, (unsigned)stats.bitrate_up);
+    }
+}
+
+void Application::PushUplinkFrame(const uint8_t* opus, size_t size, uint32_t timestamp, uint32_t capture_us, uint32_t trace_id) {
+    UplinkFrameHeader header;
+    header.capture_us = capture_us;
+    header.encoded_us = (uint32_t)esp_timer_get_time();
+    header.frame_duration = (uint16_t)encoder_frame_duration_;
+    header.reserved = 0;
+    AudioTrace::GetInstance().Record(AudioTrace::kUplinkEncodeEnd, trace_id, size);
+
+    uplink_staging_.resize(sizeof(header) + size);
+    memcpy(uplink_staging_.data(), &header, sizeof(header));
+    memcpy(uplink_staging_.data() + sizeof(header), opus, size);
+    if (!uplink_opus_ring_.Push(uplink_staging_.data(), uplink_staging_.size(), timestamp, trace_id)) {
+        // 单生产者环形队列不能从生产端丢弃最旧的帧，改为丢弃最新一帧
+        ESP_LOGW(TAG, "Too many audio packets in queue, drop the newest packet");
+        encoder_controller_.OnDropped();
+    }
+    xEventGroupSetBits(event_group_, SEND_AUDIO_EVENT);
+}
+
+void Application::SendUplinkFrames() {
+    auto& trace = AudioTrace::GetInstance();
+    PacketRing::Packet frame;
+    while (uplink_opus_ring_.Acquire(frame)) {
+        UplinkFrameHeader header;
+        memcpy(&header, frame.data, sizeof(header));
+        uplink_packet_.frame_duration = header.frame_duration;
+        uplink_packet_.timestamp = frame.timestamp;
+        uplink_packet_.payload.assign(frame.data + sizeof(header), frame.data + frame.size);
+        uint32_t trace_id = frame.trace_id;
+        uplink_opus_ring_.Release();
+
+        uint32_t send_start = (uint32_t)esp_timer_get_time();
+        trace.Record(AudioTrace::kUplinkSendStart, trace_id);
+        bool success = protocol_->SendAudio(uplink_packet_);
+        uint32_t send_end = (uint32_t)esp_timer_get_time();
+        trace.Record(AudioTrace::kUplinkSendEnd, trace_id, success ? 1 : 0);
+        uplink_latency_.encode_to_send.Add(send_start - header.encoded_us);
+        uplink_latency_.send.Add(send_end - send_start);
+        uplink_latency_.end_to_end.Add(send_end - header.capture_us);
+
+        // 发送时的积压深度反映链路（阻塞发布）跟不上采集的程度
+        encoder_controller_.OnSend(uplink_opus_ring_.Size() + 1, success);
+        if (!success) {
+            // 与原先一致：发送失败时丢弃积压的帧，不在下一次唤醒时重试
+            uplink_opus_ring_.Clear();
+            break;
+        }
+    }
+}
 
+void Application::RecordPlayback(const PcmPool::Block& pcm) {
+#ifdef CONFIG_USE_SERVER_AEC
     auto codec = Board::GetInstance().GetAudioCodec();
-    if (opus_decoder_->sample_rate() != codec->output_sample_rate()) {
-        ESP_LOGI(TAG, "Resampling audio from %d to %d", opus_decoder_->sample_rate(), codec->output_sample_rate());
-        output_resampler_.Configure(opus_decoder_->sample_rate(), codec->output_sample_rate());
+    // 写入返回时本帧排在输出缓冲的末尾，之前还有 DMA 回调环（如有）和 I2S DMA 描述符中的样本；
+    // 阻塞写入在描述符写满后才返回，因此按描述符总容量计
+    size_t pending = codec->OutputBufferedSamples() + AUDIO_CODEC_DMA_DESC_NUM * AUDIO_CODEC_DMA_FRAME_NUM;
+    playback_clock_.OnFrameWritten(pcm.timestamp(), pcm.size(), pending, codec->output_sample_rate(),
+        (uint32_t)esp_timer_get_time());
+#endif
+}
+
+void Application::LogDecodeStackUsage() {
+    ESP_LOGI(TAG, "Decode task stack: %u of %u bytes never used", (unsigned)decode_task_->GetStackHighWaterMark(),
+        (unsigned)AUDIO_DECODE_TASK_STACK_SIZE);
+}
+
+void Application::ResetUplink() {
+    // 丢弃上一次会话残留的采集块，编码器、静音抑制和预录环由编码任务在下一个采集块前重置
+    uplink_pcm_ring_.Clear();
+    uplink_session_.fetch_or(kUplinkReset);
+    uplink_latency_.capture_to_encode.Reset();
+    uplink_latency_.encode.Reset();
+    uplink_latency_.encode_to_send.Reset();
+    uplink_latency_.send.Reset();
+    uplink_latency_.end_to_end.Reset();
+}
+
+std::string Application::GetUplinkStatsJson() {
+    cJSON* root = cJSON_CreateObject();
+    auto add_stage = [root](const char* name, const LatencyStat& stat) {
+        auto snapshot = stat.Get();
+        cJSON* stage = cJSON_CreateObject();
+        cJSON_AddNumberToObject(stage, "count", snapshot.count);
+        cJSON_AddNumberToObject(stage, "mean_us", snapshot.mean_us);
+        cJSON_AddNumberToObject(stage, "max_us", snapshot.max_us);
+        cJSON_AddItemToObject(root, name, stage);
+    };
+    add_stage("capture_to_encode", uplink_latency_.capture_to_encode);
+    add_stage("encode", uplink_latency_.encode);
+    add_stage("encode_to_send", uplink_latency_.encode_to_send);
+    add_stage("send", uplink_latency_.send);
+    add_stage("end_to_end", uplink_latency_.end_to_end);
+    cJSON_AddNumberToObject(root, "pcm_ring_depth", uplink_pcm_ring_.Size());
+    cJSON_AddNumberToObject(root, "opus_ring_depth", uplink_opus_ring_.Size());
+#ifdef CONFIG_USE_SERVER_AEC
+    auto clock = playback_clock_.GetStats();
+    cJSON* aec = cJSON_CreateObject();
+    cJSON_AddNumberToObject(aec, "matched", clock.hits);
+    cJSON_AddNumberToObject(aec, "unmatched", clock.misses);
+    cJSON_AddNumberToObject(aec, "playback_frames", clock.frames);
+    cJSON_AddNumberToObject(aec, "resyncs", clock.resyncs);
+    cJSON_AddNumberToObject(aec, "last_correction_us", clock.last_correction_us);
+    cJSON_AddItemToObject(root, "aec_reference", aec);
+#endif
+    char* json = cJSON_PrintUnformatted(root);
+    std::string result(json);
+    cJSON_free(json);
+    cJSON_Delete(root);
+    return result;
+}
+
+void Application::ApplyEncoderSettings(const EncoderController::Settings& settings) {
+    opus_encoder_->SetComplexity(settings.complexity);
+    opus_encoder_->SetBitrate(settings.bitrate);
+    opus_encoder_->SetVbr(settings.vbr, settings.constrained_vbr);
+    opus_encoder_->SetDtx(settings.dtx);
+}
+
+void Application::SetFrameDuration(int frame_duration) {
+    frame_duration_ = frame_duration;
+
+    // 下行：抖动缓冲按帧计算深度；播放队列的上限和水位换算成相同时长的帧数，
+    // 但受 PCM 块池限制（在途帧 + 播放队列 + 正在播放 + 重采样临时块不超过块数）
+    jitter_buffer_.SetFrameDuration(frame_duration);
+    playback_flow_control_.SetFrameDuration(frame_duration, OPUS_FRAME_DURATION_MS, AUDIO_PCM_POOL_BLOCKS - 2);
+
+    // 上行：编码器只在编码任务中使用，由它在处理下一个采集块前按新时长重建
+    ESP_LOGI(TAG, "Frame duration %dms", frame_duration);
+}
+
+void Application::SetPreferredFrameDuration(int frame_duration) {
+    if (!IsSupportedFrameDuration(frame_duration)) {
+        return;
+    }
+    preferred_frame_duration_ = frame_duration;
+    // hello 在主循环中构造，协议层的偏好也在主循环中更新
+    Schedule([this, frame_duration]() {
+        if (protocol_) {
+            protocol_->SetPreferredFrameDuration(frame_duration, OPUS_FRAME_DURATION_MS);
+        }
+    });
+    Settings settings("audio", true);
+    settings.SetInt("frame_duration", frame_duration);
+    // 下次打开音频通道时在 hello 中提出；通道已打开时等服务端重新协商
+    if (protocol_ == nullptr || !protocol_->IsAudioChannelOpened()) {
+        Schedule([this, frame_duration]() {
+            SetFrameDuration(frame_duration);
+            SetDecodeSampleRate(ChooseDecodeSampleRate(protocol_ ? protocol_->server_sample_rate() : AUDIO_DEFAULT_SERVER_SAMPLE_RATE), frame_duration);
+        });
     }
 }
 
+int Application::ChooseDecodeSampleRate(int server_sample_rate) {
+    // Opus 可以把任意码流直接解码到这些采样率之一
+    static const int kOpusSampleRates[] = {48000, 24000, 16000, 12000, 8000};
+    auto codec = Board::GetInstance().GetAudioCodec();
+    int output_sample_rate = codec->output_sample_rate();
+    for (int rate : kOpusSampleRates) {
+        if (rate == output_sample_rate) {
+            // 直接解码到输出采样率，不需要重采样
+            return rate;
+        }
+    }
+    // 输出采样率不是 Opus 采样率（如 44100）：取不超过服务端和输出采样率的最大 Opus 采样率解码，再重采样
+    int limit = std::min(server_sample_rate, output_sample_rate);
+    for (int rate : kOpusSampleRates) {
+        if (rate <= limit) {
+            return rate;
+        }
+    }
+    return 8000;
+}
+
+void Application::SetDecodeSampleRate(int sample_rate, int frame_duration) {
+    auto codec = Board::GetInstance().GetAudioCodec();
+    // 解码帧和重采样后的帧都必须放得进 PCM 块，否则保持原帧长
+    size_t max_rate = std::max(sample_rate, codec->output_sample_rate());
+    if (frame_duration <= 0 || max_rate * frame_duration / 1000 > pcm_pool_->block_samples()) {
+        ESP_LOGW(TAG, "Frame duration %dms does not fit PCM block (%u samples), using %dms",
+            frame_duration, (unsigned)pcm_pool_->block_samples(), OPUS_FRAME_DURATION_MS);
+        frame_duration = OPUS_FRAME_DURATION_MS;
+    }
+
+    // 解码器和重采样器都有状态，并且正被在途帧使用：作为解码流水线中的一帧调度，
+    // 在解码阶段的轮次内重建解码器、在重采样阶段的轮次内重配重采样器，之前的帧仍按旧参数处理
+    uint32_t sequence = decode_sequencer_.Next();
+    decode_task_->Schedule([this, codec, sequence, sample_rate, frame_duration]() {
+        decode_sequencer_.BeginTurn(DecodeSequencer::kStageDecode, sequence);
+        bool changed = opus_decoder_->sample_rate() != sample_rate || opus_decoder_->duration_ms() != frame_duration;
+        if (changed) {
+            opus_decoder_.reset();
+            opus_decoder_ = std::make_unique<OpusPlcDecoder>(sample_rate, 1, frame_duration);
+            ESP_LOGI(TAG, "Decoder reconfigured: %dHz, %dms", sample_rate, frame_duration);
+        }
+        decode_sequencer_.EndTurn(DecodeSequencer::kStageDecode, sequence);
+
+        decode_sequencer_.BeginTurn(DecodeSequencer::kStageResample, sequence);
+        if (changed && sample_rate != codec->output_sample_rate()) {
+            ESP_LOGI(TAG, "Resampling audio from %d to %d", sample_rate, codec->output_sample_rate());
+            output_resampler_.Configure(sample_rate, codec->output_sample_rate());
+        }
+        decode_sequencer_.EndTurn(DecodeSequencer::kStageResample, sequence);
+
+        decode_sequencer_.Complete(sequence, PcmPool::Block(), [](PcmPool::Block&&) {});
+    });
+}
+
 void Application::UpdateIotStates() {
 #if CONFIG_IOT_PROTOCOL_XIAOZHI
     auto& thing_manager = iot::ThingManager::GetInstance();
@@ -15,7 +15,6 @@
 #include <memory>
 
 #include <opus_encoder.h>
-#include <opus_decoder.h>
 #include <opus_resampler.h>
 
 #include "protocol.h"
@@ -24,6 +23,21 @@
 #include "audio_processor.h"
 #include "wake_word.h"
 #include "audio_debugger.h"
+#include "packet_ring.h"
+#include "jitter_buffer.h"
+#include "opus_plc_decoder.h"
+#include "opus_uplink_encoder.h"
+#include "encoder_controller.h"
+#include "uplink_router.h"
+#include "latency_stat.h"
+#include "decode_sequencer.h"
+#include "pcm_pool.h"
+#include "prompt_source.h"
+#include "playback_flow_control.h"
+#include "downlink_scheduler.h"
+#include "job_slots.h"
+#include "capture_frontend.h"
+#include "playback_clock.h"
 
 #define SCHEDULE_EVENT (1 << 0)
 #define SEND_AUDIO_EVENT (1 << 1)
@@ -51,11 +65,40 @@ enum DeviceState {
 
 #define OPUS_FRAME_DURATION_MS 60
 #define MAX_AUDIO_PACKETS_IN_QUEUE 200  // 缓冲区解码音频
+#define AUDIO_DECODE_SLAB_SIZE (24 * 1024)  // 解码环形队列的载荷内存，约 200 帧 60ms/24kbps 的 Opus
+#define AUDIO_DECODE_WORKERS 1  // 下行解码线程数：解码按序号保序，>1 时下一帧的解码与上一帧的重采样/入队重叠
+#define AUDIO_DECODE_MAX_IN_FLIGHT 4  // 同时在途（已调度、尚未交给播放）的下行帧数上限，也是解码任务槽的数量
+#define AUDIO_DECODE_TASK_STACK_SIZE (4096 * 7)  // 解码最小需要 4KB*7（含 PLC/FEC、重采样和提示音展开），说话结束时打印剩余最小值
+#define AUDIO_PCM_POOL_BLOCKS 8  // 下行 PCM 块池的块数：播放队列 + 正在播放 + 在途解码/重采样
+#define AUDIO_PCM_POOL_MIN_SAMPLE_RATE 24000  // 块按一帧在该采样率与输出采样率中较大者下的样本数分配，覆盖解码与重采样两端
+#define AUDIO_JITTER_MIN_PREBUFFER_MS 120  // 抖动缓冲最小预缓冲深度
+#define AUDIO_JITTER_MAX_PREBUFFER_MS 600  // 抖动缓冲最大预缓冲深度
 #define AUDIO_TESTING_MAX_DURATION_MS 10000
-// 当解码队列达到上限时的“间隔抽帧”策略参数
-// 每 AUDIO_THINNING_STRIDE 帧抽走 1 帧；一次最多抽走 AUDIO_THINNING_MAX_REMOVE 帧
-#define AUDIO_THINNING_STRIDE 10
-#define AUDIO_THINNING_MAX_REMOVE 20
+#define AUDIO_DEFAULT_SERVER_SAMPLE_RATE 24000  // 服务端 hello 之前假定的下行采样率
+#define AUDIO_CAPTURE_MAX_READ_MS 64  // 采集前端按单次读取的最大时长预分配缓冲，覆盖 60ms 测试帧和 AFE 喂数据块
+// 上行编码器自适应范围（EncoderController）：4G 省流量；WiFi 起始复杂度 0，CPU 空闲时再提高
+#define AUDIO_ENCODER_WIFI_MAX_COMPLEXITY 3
+#define AUDIO_ENCODER_WIFI_MIN_BITRATE 12000
+#define AUDIO_ENCODER_WIFI_MAX_BITRATE 24000
+#define AUDIO_ENCODER_4G_MAX_COMPLEXITY 5
+#define AUDIO_ENCODER_4G_MIN_BITRATE 10000
+#define AUDIO_ENCODER_4G_MAX_BITRATE 16000
+#define AUDIO_ENCODER_AEC_MAX_COMPLEXITY 2  // AEC 本身占用较多 CPU，起始复杂度 0
+// 上行静音抑制（UplinkGate），模式可由设置项 audio.uplink_gate 覆盖（0 关闭，1 编码器 DTX，2 本地 VAD）
+#define AUDIO_UPLINK_HANGOVER_MS 600   // 说话结束后继续发送的时长，防止截掉词尾
+#define AUDIO_UPLINK_KEEPALIVE_MS 1000 // 静音期间舒适噪声标记的间隔，0 表示静音期间完全不发
+#define AUDIO_UPLINK_LOOKBACK_MS 120   // 静音期间保留的最近音频，恢复发送时先补发，覆盖 VAD 的判定延迟
+// 上行编码任务：采集回调把处理后的 PCM 写入 PCM 环，编码任务编码后写入 Opus 环，由主循环发送
+#define AUDIO_UPLINK_PCM_RING_PACKETS 32
+#define AUDIO_UPLINK_PCM_RING_SIZE (16 * 1024)   // 约 500ms 的 16kHz 单声道 PCM
+#define AUDIO_UPLINK_OPUS_RING_SIZE (16 * 1024)  // 包数上限为 MAX_AUDIO_PACKETS_IN_QUEUE
+#define AUDIO_ENCODE_TASK_STACK_SIZE (4096 * 7)  // Opus 编码（SILK）需要约 24KB，监听结束时打印剩余最小值
+#define AUDIO_ENCODE_TASK_PRIORITY 5
+#define AUDIO_ENCODE_TASK_CORE tskNO_AFFINITY    // 可设为 0/1 绑定到指定核
+// 上行预录：建立音频通道期间保留的最近音频，通道就绪后补发；可由设置项 audio.preroll_ms 覆盖，0 关闭
+// 预录环（1500ms 约 48KB）只在建立通道期间分配，分配后剩余的最大空闲块不足 AUDIO_UPLINK_PREROLL_HEAP_RESERVE 时本次不预录
+#define AUDIO_UPLINK_PREROLL_MS 1500
+#define AUDIO_UPLINK_PREROLL_HEAP_RESERVE (24 * 1024)
 
 
 class Application {
@@ -87,7 +130,11 @@ public:
     void SendMcpMessage(const std::string& payload);
     void SetAecMode(AecMode mode);
     AecMode GetAecMode() const { return aec_mode_; }
-    BackgroundTask* GetBackgroundTask() const { return background_task_.get(); }
+    // 上下行 Opus 帧时长偏好（20/40/60ms），持久保存，在下一次 hello 中与服务端协商
+    int GetPreferredFrameDuration() const { return preferred_frame_duration_; }
+    void SetPreferredFrameDuration(int frame_duration);
+    // 上行各阶段的延迟统计（本次或上一次监听会话），JSON 格式
+    std::string GetUplinkStatsJson();
 
 private:
     Application();
@@ -109,52 +156,167 @@ private:
     bool has_server_time_ = false;
     bool aborted_ = false;
     bool voice_detected_ = false;
-    // 移除：bool busy_decoding_audio_ = false;  // 已用active_decode_tasks_替代
     int clock_ticks_ = 0;
     TaskHandle_t check_new_version_task_handle_ = nullptr;
 
     // Audio encode / decode
     TaskHandle_t audio_loop_task_handle_ = nullptr;
-    std::unique_ptr<BackgroundTask> background_task_;
+    // 最近一次状态变化的时刻（esp_timer 微秒），采集循环用它统计状态变化到开始采集的延迟
+    std::atomic<int64_t> audio_loop_wake_time_{0};
+    TaskHandle_t audio_encode_task_handle_ = nullptr;
+    std::unique_ptr<BackgroundTask> decode_task_;
     std::chrono::steady_clock::time_point last_output_time_;
-    std::list<AudioStreamPacket> audio_send_queue_;
-    // 优化：使用原始数据队列，避免AudioStreamPacket封装开销
-    std::list<std::vector<uint8_t>> audio_decode_queue_;
+    // 上行：采集回调 -> uplink_pcm_ring_ -> 编码任务 -> uplink_opus_ring_ -> 主循环发送
+    // PCM 环的时间戳为采集时刻（esp_timer 微秒的低 32 位）；Opus 环的时间戳为服务端 AEC 时间戳，
+    // 载荷以 UplinkFrameHeader 开头
+    PacketRing uplink_pcm_ring_{AUDIO_UPLINK_PCM_RING_PACKETS, AUDIO_UPLINK_PCM_RING_SIZE};
+    PacketRing uplink_opus_ring_{MAX_AUDIO_PACKETS_IN_QUEUE, AUDIO_UPLINK_OPUS_RING_SIZE};
+    struct UplinkFrameHeader {
+        uint32_t capture_us;      // 完成该帧的采集块的采集时刻
+        uint32_t encoded_us;
+        uint16_t frame_duration;
+        uint16_t reserved;
+    };
+    // 上行会话控制字，主循环写、编码任务读，各标志放在同一个原子变量里，编码任务一次读出一致的组合：
+    // - kUplinkReset：新的监听会话，编码任务在处理下一个采集块前重置编码器状态、静音抑制并丢弃预录环
+    // - kUplinkPreroll：建立音频通道期间（Connecting）音频处理器已经启动，编码任务把采集块暂存到预录环
+    //   （满后丢弃最旧的块），不编码；通道就绪后清除该标志，编码任务一次性编码补发，帧头保留原始采集时刻
+    // - kUplinkTesting：音频测试模式，编码任务把编码结果存入 audio_testing_queue_，不上传
+    enum UplinkSessionFlag : uint32_t {
+        kUplinkReset = 1 << 0,
+        kUplinkPreroll = 1 << 1,
+        kUplinkTesting = 1 << 2,
+    };
+    std::atomic<uint32_t> uplink_session_{0};
+    int uplink_preroll_ms_ = 0;
+    // 预录环只在编码任务中使用：进入预录时分配，补发或重置后释放
+    std::unique_ptr<PacketRing> uplink_preroll_ring_;
+    bool uplink_preroll_skipped_ = false;    // 本次预录因内存不足放弃，只在编码任务中使用
+    std::vector<uint8_t> uplink_staging_;    // 只在编码任务中使用：帧头 + Opus
+    uint32_t encode_capture_us_ = 0;         // 只在编码任务中使用：当前 Encode 调用的采集时间
+    uint32_t encode_trace_id_ = 0;           // 只在编码任务中使用：当前 Encode 调用的追踪 ID
+    AudioStreamPacket uplink_packet_;        // 只在主循环中使用，载荷容量复用
+    struct UplinkLatency {
+        LatencyStat capture_to_encode;   // 写入 PCM 环 -> 编码任务取出
+        LatencyStat encode;              // 单帧 opus_encode 耗时
+        LatencyStat encode_to_send;      // 编码完成 -> 主循环开始发送
+        LatencyStat send;                // SendAudio 耗时
+        LatencyStat end_to_end;          // 采集 -> 发送返回
+    } uplink_latency_;
+    // 下行 Opus 帧：单生产者/单消费者无锁环形队列，载荷内存预分配
+    // 生产者只有协议回调（测试回放由 OnAudioOutput 直接从 audio_testing_replay_ 取包），消费者为 OnAudioOutput
+    PacketRing audio_decode_queue_{MAX_AUDIO_PACKETS_IN_QUEUE, AUDIO_DECODE_SLAB_SIZE};
+    std::mutex audio_decode_wait_mutex_;
     std::condition_variable audio_decode_cv_;
+    // 自适应抖动缓冲：决定何时从 audio_decode_queue_ 取帧
+    JitterBuffer jitter_buffer_{OPUS_FRAME_DURATION_MS, AUDIO_JITTER_MIN_PREBUFFER_MS, AUDIO_JITTER_MAX_PREBUFFER_MS};
     std::list<AudioStreamPacket> audio_testing_queue_;
+    // 退出测试模式时录音移到这里，由 OnAudioOutput 逐包回放；与 audio_testing_queue_ 一样由 mutex_ 保护
+    std::list<AudioStreamPacket> audio_testing_replay_;
+    std::atomic<bool> audio_testing_replaying_{false};
+    // 内置提示音：OnAudioOutput 直接从 flash 取包解码，不经过环形队列和抖动缓冲
+    PromptSource prompt_source_;
 
     // 新增：播放队列（PCM），用于解码/输出解耦
+    // 以下按 OPUS_FRAME_DURATION_MS 的帧计，帧时长变化时换算成相同时长的帧数
     static constexpr int MAX_PLAYBACK_TASKS_IN_QUEUE = 3;   // 队列上限=3
     static constexpr int PLAYBACK_HIGH_WATERMARK = 2;       // 到2停止解码
     static constexpr int PLAYBACK_LOW_WATERMARK  = 1;       // 回落到1恢复解码
-    std::deque<std::vector<int16_t>> audio_playback_queue_;
+    // 解码和重采样输出的预分配 PCM 块，替代每帧分配的 vector
+    // 需先于播放队列和重排缓冲声明，保证块在池之前析构
+    std::unique_ptr<PcmPool> pcm_pool_;
+    std::deque<PcmPool::Block> audio_playback_queue_;   // 块由播放任务输出后自动归还 pcm_pool_
     std::mutex playback_mutex_;
     std::condition_variable playback_cv_;
-    std::atomic<bool> playback_backpressure_{false};         // 播放队列背压开关
 
-    // 改进：并发解码控制，允许多个包同时处理
-    std::atomic<int> active_decode_tasks_{0};  // 当前活跃的解码任务数
-    static constexpr int MAX_CONCURRENT_DECODE_TASKS = 4;  // 最大并发解码任务数
+    // 解码保序：序号、有状态阶段的轮次和重排缓冲；解码器重配（SetDecodeSampleRate）也占一个序号
+    DecodeSequencer decode_sequencer_{AUDIO_DECODE_MAX_IN_FLIGHT + 1};
+    // 播放队列背压与在途帧上限，决定 OnAudioOutput 是否继续调度解码；在途帧数即 decode_slots_ 中占用的槽数
+    PlaybackFlowControl playback_flow_control_{AUDIO_DECODE_MAX_IN_FLIGHT, MAX_PLAYBACK_TASKS_IN_QUEUE,
+        PLAYBACK_HIGH_WATERMARK, PLAYBACK_LOW_WATERMARK};
+    // 取包与丢包补偿：抖动缓冲决定何时取包，丢失的帧分散到之后的各次准入中调度，
+    // 补出的帧与正常帧一样受 playback_flow_control_ 的在途上限和 PCM 块预算约束
+    DownlinkScheduler downlink_scheduler_{audio_decode_queue_, jitter_buffer_, decode_sequencer_};
+    enum DecodeMode {
+        kDecodeNormal = DownlinkScheduler::kNormal,
+        kDecodeFec = DownlinkScheduler::kFec,
+        kDecodeConceal = DownlinkScheduler::kConceal,
+        kDecodePcm16,    // 预解码提示音块，直接拷贝
+        kDecodeAdpcm,    // 预解码提示音块，IMA-ADPCM 展开
+    };
+    // 在途帧的解码任务：OnAudioOutput 取一个空槽填写（网络包的载荷拷贝到槽内，提示音直接引用 flash），
+    // 解码线程处理完归还；槽的数量等于在途上限，稳态下调度一帧不分配内存
+    struct DecodeSlot {
+        DecodeMode mode = kDecodeNormal;
+        DownlinkScheduler::Job job;
+    };
+    JobSlots<DecodeSlot> decode_slots_{AUDIO_DECODE_MAX_IN_FLIGHT};
 
+    // 下行各帧的实际放音时间，服务端 AEC 据此为上行帧附上对应的回声参考时间戳
+    PlaybackClock playback_clock_;
 
-
-    // 新增：用于维护音频包的timestamp队列
-    std::list<uint32_t> timestamp_queue_;
-    std::mutex timestamp_mutex_;
-
-    std::unique_ptr<OpusEncoderWrapper> opus_encoder_;
-    std::unique_ptr<OpusDecoderWrapper> opus_decoder_;
+    std::unique_ptr<OpusUplinkEncoder> opus_encoder_;
+    int encoder_frame_duration_ = OPUS_FRAME_DURATION_MS;   // 只在编码任务（和启动、音频测试时）访问
+    // 按编码耗时、发送队列积压和发送失败调整编码器的复杂度/码率/VBR/DTX
+    EncoderController encoder_controller_;
+    // 监听期间的上行静音抑制和词首回看；VAD 状态由音频处理器回调直接写入，编码任务读取
+    UplinkRouter uplink_router_;
+    std::atomic<bool> uplink_vad_speaking_{false};
+    // 上下行协商后的帧时长，以及写入 hello 的本端偏好
+    std::atomic<int> frame_duration_{OPUS_FRAME_DURATION_MS};
+    int preferred_frame_duration_ = OPUS_FRAME_DURATION_MS;
+    std::unique_ptr<OpusPlcDecoder> opus_decoder_;
 
     OpusResampler input_resampler_;
     OpusResampler reference_resampler_;
     OpusResampler output_resampler_;
 
+    // 上行采集：只在音频输入线程中使用，缓冲长期持有，稳态下不分配
+    CaptureFrontend capture_frontend_;
+    std::vector<int16_t> capture_buffer_;
+    std::vector<int16_t> capture_mono_buffer_;
+
     void MainEventLoop();
-    void OnAudioInput();
+    // 读取并分发一块采集音频；没有需要采集的消费者时关闭输入并返回 false
+    bool OnAudioInput();
     void OnAudioOutput();
+    // 唤醒空闲时阻塞等待的采集循环：状态变化、开始检测/处理、下行有新数据时调用，任意线程
+    void WakeAudioLoop();
+    // 把 decode_slots_ 中填好的一帧交给解码线程，处理完归还槽
+    // slot->job.sequence 为 decode_sequencer_ 分配的解码序号，trace_id 为 AudioTrace 追踪 ID，随结果一直传到 I2S 写入
+    void ScheduleDecode(DecodeSlot* slot);
+    void DecodeFrame(DecodeSlot* slot);
+    // 保序器按序号交出的帧：写入 DMA 环形缓冲或进入播放队列
+    void OutputDecodedFrame(PcmPool::Block&& frame);
+    void RecordPlayback(const PcmPool::Block& pcm);
+    // 说话结束：打印解码线程栈的剩余最小值，用于核对 AUDIO_DECODE_TASK_STACK_SIZE
+    void LogDecodeStackUsage();
     bool ReadAudio(std::vector<int16_t>& data, int sample_rate, int samples);
     void ResetDecoder();
+    // 解码器的重建与在途帧按序号串行，可在任意线程调用
     void SetDecodeSampleRate(int sample_rate, int frame_duration);
+    int ChooseDecodeSampleRate(int server_sample_rate);
+    static bool IsSupportedFrameDuration(int frame_duration);
+    void CreateOpusEncoder(int frame_duration);
+    // 编码任务：从 uplink_pcm_ring_ 取采集块，经静音抑制后编码
+    void AudioEncodeLoop();
+    // 编码任务：处理帧时长变化、会话重置和预录补发，返回当前的会话标志（kUplinkPreroll/kUplinkTesting）
+    uint32_t UpdateUplinkSession();
+    void HoldPreroll(const PacketRing::Packet& chunk);
+    void RecordTestingChunk(const int16_t* pcm, size_t samples);
+    void FlushPreroll();
+    // 主循环：新的上行会话，丢弃残留的采集块并清零延迟统计
+    void ResetUplink();
+    void ProcessUplinkChunk(const int16_t* pcm, size_t samples, uint32_t capture_us, uint32_t trace_id);
+    // 编码一段上行 PCM（编码任务中调用），每个窗口结束时按 encoder_controller_ 的结论调整编码器
+    void EncodeUplink(const int16_t* pcm, size_t samples, uint32_t capture_us, uint32_t trace_id);
+    void ApplyEncoderSettings(const EncoderController::Settings& settings);
+    // 编码任务：把一帧写入 uplink_opus_ring_ 并唤醒主循环
+    void PushUplinkFrame(const uint8_t* opus, size_t size, uint32_t timestamp, uint32_t capture_us, uint32_t trace_id);
+    // 主循环：发送 uplink_opus_ring_ 中的全部帧
+    void SendUplinkFrames();
+    // 切换上下行帧时长（20/40/60ms）：重建编码器，按时长换算抖动缓冲和播放队列的帧数；启动后只在主循环中调用
+    void SetFrameDuration(int frame_duration);
     void CheckNewVersion();
     void ShowActivationCode(const std::string& code, const std::string& message);
     void OnClockTimer();
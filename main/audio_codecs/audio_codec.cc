@@ -15,12 +15,19 @@ AudioCodec::~AudioCodec() {
 }
 
 void AudioCodec::OutputData(std::vector<int16_t>& data) {
-    Write(data.data(), data.size());
+    OutputData(data.data(), data.size());
+}
+
+void AudioCodec::OutputData(const int16_t* data, size_t samples) {
+    Write(data, samples);
 }
 
 bool AudioCodec::InputData(std::vector<int16_t>& data) {
-    int samples = Read(data.data(), data.size());
-    if (samples > 0) {
+    return InputData(data.data(), data.size());
+}
+
+bool AudioCodec::InputData(int16_t* data, size_t samples) {
+    if (Read(data, samples) > 0) {
         return true;
     }
     return false;
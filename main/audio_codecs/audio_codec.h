@@ -14,6 +14,7 @@
 #define AUDIO_CODEC_DMA_DESC_NUM 6
 #define AUDIO_CODEC_DMA_FRAME_NUM 240
 #define AUDIO_CODEC_DEFAULT_MIC_GAIN 30.0
+#define AUDIO_CODEC_DMA_RING_MS 120  // DMA 回调播放时，写入方与发送中断之间的环形缓冲时长
 
 class AudioCodec {
 public:
@@ -25,9 +26,18 @@ public:
     virtual void EnableOutput(bool enable);
 
     virtual void OutputData(std::vector<int16_t>& data);
+    virtual void OutputData(const int16_t* data, size_t samples);
     virtual bool InputData(std::vector<int16_t>& data);
+    virtual bool InputData(int16_t* data, size_t samples);
     virtual void Start();
 
+    // 已写入但尚未送到 I2S 的样本数（DMA 回调播放时为环形缓冲中的样本数）
+    virtual size_t OutputBufferedSamples() { return 0; }
+    // 播放中数据耗尽的次数（仅 DMA 回调播放时统计）
+    virtual uint32_t OutputUnderruns() { return 0; }
+    // 丢弃已写入但尚未送到 I2S 的样本（DMA 回调播放时清空环形缓冲），可在任意线程调用
+    virtual void FlushOutput() {}
+
     inline bool duplex() const { return duplex_; }
     inline bool input_reference() const { return input_reference_; }
     inline int input_sample_rate() const { return input_sample_rate_; }
@@ -37,6 +47,8 @@ public:
     inline int output_volume() const { return output_volume_; }
     inline bool input_enabled() const { return input_enabled_; }
     inline bool output_enabled() const { return output_enabled_; }
+    // 输出由 I2S 发送完成回调驱动：OutputData 只写入环形缓冲，不需要独立的播放任务
+    inline bool dma_playback() const { return dma_playback_; }
 
 protected:
     i2s_chan_handle_t tx_handle_ = nullptr;
@@ -46,6 +58,7 @@ protected:
     bool input_reference_ = false;
     bool input_enabled_ = false;
     bool output_enabled_ = false;
+    bool dma_playback_ = false;
     int input_sample_rate_ = 0;
     int output_sample_rate_ = 0;
     int input_channels_ = 1;
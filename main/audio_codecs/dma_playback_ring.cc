@@ -0,0 +1,94 @@
+#include "dma_playback_ring.h"
+
+#include <algorithm>
+#include <cstring>
+
+DmaPlaybackRing::DmaPlaybackRing(size_t capacity_words)
+    : capacity_(capacity_words),
+      buffer_(new int32_t[capacity_words]) {
+}
+
+int32_t* DmaPlaybackRing::PrepareWrite(size_t& contiguous) {
+    uint32_t write = write_.load(std::memory_order_relaxed);
+    uint32_t read = read_.load(std::memory_order_acquire);
+    size_t free_words = capacity_ - (write - read);
+    size_t index = write % capacity_;
+    contiguous = std::min(free_words, capacity_ - index);
+    return buffer_.get() + index;
+}
+
+void DmaPlaybackRing::CommitWrite(size_t words) {
+    write_.fetch_add(words, std::memory_order_release);
+}
+
+size_t DmaPlaybackRing::Fill(int32_t* dest, size_t words) {
+    uint32_t read = read_.load(std::memory_order_relaxed);
+    if (flush_.exchange(false, std::memory_order_acq_rel)) {
+        uint32_t flush_to = flush_to_.load(std::memory_order_acquire);
+        if ((int32_t)(flush_to - read) > 0) {
+            read = flush_to;
+        }
+        // 丢弃后的中断是有意的，不算欠载
+        playing_ = false;
+        gap_words_ = 0;
+    }
+    uint32_t write = write_.load(std::memory_order_acquire);
+    size_t available = std::min<size_t>(write - read, words);
+
+    size_t copied = 0;
+    while (copied < available) {
+        size_t index = (read + copied) % capacity_;
+        size_t chunk = std::min(available - copied, capacity_ - index);
+        memcpy(dest + copied, buffer_.get() + index, chunk * sizeof(int32_t));
+        copied += chunk;
+    }
+    read_.store(read + copied, std::memory_order_release);
+
+    if (copied < words) {
+        memset(dest + copied, 0, (words - copied) * sizeof(int32_t));
+    }
+
+    // 数据中断后在一个环长度内恢复，视为播放中欠载；更长的中断视为两段音频之间的间隔
+    if (copied > 0) {
+        if (gap_words_ > 0 && gap_words_ <= capacity_) {
+            underruns_.fetch_add(1, std::memory_order_relaxed);
+            silence_words_.fetch_add(gap_words_, std::memory_order_relaxed);
+        }
+        gap_words_ = 0;
+        playing_ = true;
+    }
+    if (playing_ && copied < words) {
+        gap_words_ += words - copied;
+        if (gap_words_ > capacity_) {
+            playing_ = false;
+            gap_words_ = 0;
+        }
+    }
+    played_words_.fetch_add(copied, std::memory_order_relaxed);
+    return copied;
+}
+
+void DmaPlaybackRing::Flush() {
+    flush_to_.store(write_.load(std::memory_order_acquire), std::memory_order_release);
+    flush_.store(true, std::memory_order_release);
+}
+
+size_t DmaPlaybackRing::Size() const {
+    uint32_t write = write_.load(std::memory_order_acquire);
+    uint32_t start = read_.load(std::memory_order_acquire);
+    if (flush_.load(std::memory_order_acquire)) {
+        uint32_t flush_to = flush_to_.load(std::memory_order_acquire);
+        if ((int32_t)(flush_to - start) > 0) {
+            start = flush_to;
+        }
+    }
+    return write - start;
+}
+
+DmaPlaybackRing::Stats DmaPlaybackRing::GetStats() const {
+    Stats stats;
+    stats.underruns = underruns_.load(std::memory_order_relaxed);
+    stats.silence_words = silence_words_.load(std::memory_order_relaxed);
+    stats.played_words = played_words_.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,60 @@
+#ifndef _DMA_PLAYBACK_RING_H
+#define _DMA_PLAYBACK_RING_H
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+// I2S 发送 DMA 回调使用的单生产者/单消费者样本环形缓冲
+// - 生产者（写音频的任务）通过 PrepareWrite/CommitWrite 直接把转换后的 DMA 字写入环中
+// - 消费者（I2S on_sent 中断回调）调用 Fill 把样本搬进刚发送完的 DMA 缓冲区，数据不足时补静音并计数欠载
+// - Flush 可在任意线程调用：丢弃调用时刻之前写入的所有样本，在消费者下一次 Fill 时生效
+// 不依赖 FreeRTOS/驱动，可以在主机上单独测试
+class DmaPlaybackRing {
+public:
+    struct Stats {
+        uint32_t underruns = 0;        // 播放中数据耗尽、随后又在一个环长度内恢复的次数
+        uint32_t silence_words = 0;    // 欠载期间补入的静音字数（不含两段音频之间的空闲）
+        uint32_t played_words = 0;
+    };
+
+    explicit DmaPlaybackRing(size_t capacity_words);
+    DmaPlaybackRing(const DmaPlaybackRing&) = delete;
+    DmaPlaybackRing& operator=(const DmaPlaybackRing&) = delete;
+
+    // 生产者：返回可连续写入的位置，contiguous 为可写字数（环满时为 0）
+    int32_t* PrepareWrite(size_t& contiguous);
+    void CommitWrite(size_t words);
+
+    // 消费者（中断上下文，无锁、无分配）：填满 dest，返回其中真实样本的字数
+    size_t Fill(int32_t* dest, size_t words);
+
+    void Flush();
+
+    // 尚未被消费者取走的字数（已请求 Flush 的部分不计入）
+    size_t Size() const;
+    size_t capacity() const { return capacity_; }
+    Stats GetStats() const;
+
+private:
+    const size_t capacity_;
+    std::unique_ptr<int32_t[]> buffer_;
+
+    // 单调递增的读写位置（字），取模 capacity_ 得到下标
+    std::atomic<uint32_t> write_{0};
+    std::atomic<uint32_t> read_{0};
+    // Flush 请求：消费者把读位置前移到 flush_to_
+    std::atomic<uint32_t> flush_to_{0};
+    std::atomic<bool> flush_{false};
+
+    // 消费者私有
+    bool playing_ = false;
+    size_t gap_words_ = 0;
+
+    std::atomic<uint32_t> underruns_{0};
+    std::atomic<uint32_t> silence_words_{0};
+    std::atomic<uint32_t> played_words_{0};
+};
+
+#endif // _DMA_PLAYBACK_RING_H
@@ -1,11 +1,20 @@
 #include "no_audio_codec.h"
 
 #include <esp_log.h>
-#include <cmath>
 #include <cstring>
+#include <algorithm>
 
 #define TAG "NoAudioCodec"
 
+// DMA 回调播放时由 on_sent 回调在发送前填充缓冲区：驱动需在回调前清零（欠载时输出静音），回调后不能再清零
+#if CONFIG_USE_DMA_CALLBACK_PLAYBACK
+#define TX_AUTO_CLEAR_AFTER_CB false
+#define TX_AUTO_CLEAR_BEFORE_CB true
+#else
+#define TX_AUTO_CLEAR_AFTER_CB true
+#define TX_AUTO_CLEAR_BEFORE_CB false
+#endif
+
 NoAudioCodec::~NoAudioCodec() {
     if (rx_handle_ != nullptr) {
         ESP_ERROR_CHECK(i2s_channel_disable(rx_handle_));
@@ -13,6 +22,64 @@ NoAudioCodec::~NoAudioCodec() {
     if (tx_handle_ != nullptr) {
         ESP_ERROR_CHECK(i2s_channel_disable(tx_handle_));
     }
+    if (tx_space_ != nullptr) {
+        vSemaphoreDelete(tx_space_);
+    }
+}
+
+void NoAudioCodec::InitPlayback() {
+    UpdateOutputGain();
+#if CONFIG_USE_DMA_CALLBACK_PLAYBACK
+    playback_ring_ = std::make_unique<DmaPlaybackRing>(output_sample_rate_ / 1000 * AUDIO_CODEC_DMA_RING_MS);
+    tx_space_ = xSemaphoreCreateBinary();
+
+    i2s_event_callbacks_t callbacks = {};
+    callbacks.on_sent = OnSent;
+    ESP_ERROR_CHECK(i2s_channel_register_event_callback(tx_handle_, &callbacks, this));
+    dma_playback_ = true;
+    ESP_LOGI(TAG, "DMA callback playback enabled, ring=%ums", (unsigned)AUDIO_CODEC_DMA_RING_MS);
+#else
+    tx_scratch_ = std::make_unique<int32_t[]>(AUDIO_CODEC_DMA_FRAME_NUM);
+#endif
+}
+
+void NoAudioCodec::Start() {
+    // 基类从设置中读取音量，需要重新计算增益
+    AudioCodec::Start();
+    UpdateOutputGain();
+}
+
+void NoAudioCodec::SetOutputVolume(int volume) {
+    AudioCodec::SetOutputVolume(volume);
+    UpdateOutputGain();
+}
+
+void NoAudioCodec::UpdateOutputGain() {
+    output_gain_ = OutputGain(output_volume_);
+}
+
+// 中断上下文：只做无锁拷贝。未开启 CONFIG_I2S_ISR_IRAM_SAFE 时回调可以放在 flash 中
+bool NoAudioCodec::OnSent(i2s_chan_handle_t handle, i2s_event_data_t* event, void* user_ctx) {
+    auto codec = static_cast<NoAudioCodec*>(user_ctx);
+    codec->playback_ring_->Fill(static_cast<int32_t*>(event->dma_buf), event->size / sizeof(int32_t));
+
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(codec->tx_space_, &woken);
+    return woken == pdTRUE;
+}
+
+size_t NoAudioCodec::OutputBufferedSamples() {
+    return playback_ring_ != nullptr ? playback_ring_->Size() : 0;
+}
+
+uint32_t NoAudioCodec::OutputUnderruns() {
+    return playback_ring_ != nullptr ? playback_ring_->GetStats().underruns : 0;
+}
+
+void NoAudioCodec::FlushOutput() {
+    if (playback_ring_ != nullptr) {
+        playback_ring_->Flush();
+    }
 }
 
 NoAudioCodecDuplex::NoAudioCodecDuplex(int input_sample_rate, int output_sample_rate, gpio_num_t bclk, gpio_num_t ws, gpio_num_t dout, gpio_num_t din) {
@@ -25,8 +92,8 @@ NoAudioCodecDuplex::NoAudioCodecDuplex(int input_sample_rate, int output_sample_
         .role = I2S_ROLE_MASTER,
         .dma_desc_num = AUDIO_CODEC_DMA_DESC_NUM,
         .dma_frame_num = AUDIO_CODEC_DMA_FRAME_NUM,
-        .auto_clear_after_cb = true,
-        .auto_clear_before_cb = false,
+        .auto_clear_after_cb = TX_AUTO_CLEAR_AFTER_CB,
+        .auto_clear_before_cb = TX_AUTO_CLEAR_BEFORE_CB,
         .intr_priority = 0,
     };
     ESP_ERROR_CHECK(i2s_new_channel(&chan_cfg, &tx_handle_, &rx_handle_));
@@ -71,6 +138,7 @@ NoAudioCodecDuplex::NoAudioCodecDuplex(int input_sample_rate, int output_sample_
     };
     ESP_ERROR_CHECK(i2s_channel_init_std_mode(tx_handle_, &std_cfg));
     ESP_ERROR_CHECK(i2s_channel_init_std_mode(rx_handle_, &std_cfg));
+    InitPlayback();
     ESP_LOGI(TAG, "Duplex channels created");
 }
 
@@ -84,8 +152,8 @@ ATK_NoAudioCodecDuplex::ATK_NoAudioCodecDuplex(int input_sample_rate, int output
         .role = I2S_ROLE_MASTER,
         .dma_desc_num = AUDIO_CODEC_DMA_DESC_NUM,
         .dma_frame_num = AUDIO_CODEC_DMA_FRAME_NUM,
-        .auto_clear_after_cb = true,
-        .auto_clear_before_cb = false,
+        .auto_clear_after_cb = TX_AUTO_CLEAR_AFTER_CB,
+        .auto_clear_before_cb = TX_AUTO_CLEAR_BEFORE_CB,
         .intr_priority = 0,
     };
     ESP_ERROR_CHECK(i2s_new_channel(&chan_cfg, &tx_handle_, &rx_handle_));
@@ -128,6 +196,7 @@ ATK_NoAudioCodecDuplex::ATK_NoAudioCodecDuplex(int input_sample_rate, int output
     };
     ESP_ERROR_CHECK(i2s_channel_init_std_mode(tx_handle_, &std_cfg));
     ESP_ERROR_CHECK(i2s_channel_init_std_mode(rx_handle_, &std_cfg));
+    InitPlayback();
     ESP_LOGI(TAG, "Duplex channels created");
 }
 
@@ -143,8 +212,8 @@ NoAudioCodecSimplex::NoAudioCodecSimplex(int input_sample_rate, int output_sampl
         .role = I2S_ROLE_MASTER,
         .dma_desc_num = AUDIO_CODEC_DMA_DESC_NUM,
         .dma_frame_num = AUDIO_CODEC_DMA_FRAME_NUM,
-        .auto_clear_after_cb = true,
-        .auto_clear_before_cb = false,
+        .auto_clear_after_cb = TX_AUTO_CLEAR_AFTER_CB,
+        .auto_clear_before_cb = TX_AUTO_CLEAR_BEFORE_CB,
         .intr_priority = 0,
     };
     ESP_ERROR_CHECK(i2s_new_channel(&chan_cfg, &tx_handle_, nullptr));
@@ -198,6 +267,7 @@ NoAudioCodecSimplex::NoAudioCodecSimplex(int input_sample_rate, int output_sampl
     std_cfg.gpio_cfg.dout = I2S_GPIO_UNUSED;
     std_cfg.gpio_cfg.din = mic_din;
     ESP_ERROR_CHECK(i2s_channel_init_std_mode(rx_handle_, &std_cfg));
+    InitPlayback();
     ESP_LOGI(TAG, "Simplex channels created");
 }
 
@@ -212,8 +282,8 @@ NoAudioCodecSimplex::NoAudioCodecSimplex(int input_sample_rate, int output_sampl
         .role = I2S_ROLE_MASTER,
         .dma_desc_num = AUDIO_CODEC_DMA_DESC_NUM,
         .dma_frame_num = AUDIO_CODEC_DMA_FRAME_NUM,
-        .auto_clear_after_cb = true,
-        .auto_clear_before_cb = false,
+        .auto_clear_after_cb = TX_AUTO_CLEAR_AFTER_CB,
+        .auto_clear_before_cb = TX_AUTO_CLEAR_BEFORE_CB,
         .intr_priority = 0,
     };
     ESP_ERROR_CHECK(i2s_new_channel(&chan_cfg, &tx_handle_, nullptr));
@@ -268,6 +338,7 @@ NoAudioCodecSimplex::NoAudioCodecSimplex(int input_sample_rate, int output_sampl
     std_cfg.gpio_cfg.dout = I2S_GPIO_UNUSED;
     std_cfg.gpio_cfg.din = mic_din;
     ESP_ERROR_CHECK(i2s_channel_init_std_mode(rx_handle_, &std_cfg));
+    InitPlayback();
     ESP_LOGI(TAG, "Simplex channels created");
 }
 
@@ -280,8 +351,8 @@ NoAudioCodecSimplexPdm::NoAudioCodecSimplexPdm(int input_sample_rate, int output
     i2s_chan_config_t tx_chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG((i2s_port_t)1, I2S_ROLE_MASTER);
     tx_chan_cfg.dma_desc_num = AUDIO_CODEC_DMA_DESC_NUM;
     tx_chan_cfg.dma_frame_num = AUDIO_CODEC_DMA_FRAME_NUM;
-    tx_chan_cfg.auto_clear_after_cb = true;
-    tx_chan_cfg.auto_clear_before_cb = false;
+    tx_chan_cfg.auto_clear_after_cb = TX_AUTO_CLEAR_AFTER_CB;
+    tx_chan_cfg.auto_clear_before_cb = TX_AUTO_CLEAR_BEFORE_CB;
     tx_chan_cfg.intr_priority = 0;
     ESP_ERROR_CHECK(i2s_new_channel(&tx_chan_cfg, &tx_handle_, NULL));
 
@@ -332,63 +403,76 @@ NoAudioCodecSimplexPdm::NoAudioCodecSimplexPdm(int input_sample_rate, int output
 #else
     ESP_LOGE(TAG, "PDM is not supported");
 #endif
+    InitPlayback();
     ESP_LOGI(TAG, "Simplex channels created");
 }
 
 int NoAudioCodec::Write(const int16_t* data, int samples) {
-    std::vector<int32_t> buffer(samples);
-
-    // output_volume_: 0-100
-    // volume_factor_: 0-65536
-    int32_t volume_factor = pow(double(output_volume_) / 100.0, 2) * 65536;
-    for (int i = 0; i < samples; i++) {
-        int64_t temp = int64_t(data[i]) * volume_factor; // 使用 int64_t 进行乘法运算
-        if (temp > INT32_MAX) {
-            buffer[i] = INT32_MAX;
-        } else if (temp < INT32_MIN) {
-            buffer[i] = INT32_MIN;
-        } else {
-            buffer[i] = static_cast<int32_t>(temp);
+    int32_t gain = output_gain_;
+
+    if (playback_ring_ != nullptr) {
+        // DMA 回调播放：直接转换写入环形缓冲，只在环满时等待发送回调腾出空间
+        int written = 0;
+        while (written < samples) {
+            size_t contiguous;
+            int32_t* dest = playback_ring_->PrepareWrite(contiguous);
+            if (contiguous == 0) {
+                if (xSemaphoreTake(tx_space_, pdMS_TO_TICKS(AUDIO_CODEC_DMA_RING_MS * 2)) != pdTRUE) {
+                    ESP_LOGW(TAG, "Playback ring stays full, drop %d samples", samples - written);
+                    break;
+                }
+                continue;
+            }
+            int count = std::min<int>(contiguous, samples - written);
+            OutputConvert(data + written, dest, count, gain);
+            playback_ring_->CommitWrite(count);
+            written += count;
         }
+        return written;
     }
 
-    size_t bytes_written;
-    ESP_ERROR_CHECK(i2s_channel_write(tx_handle_, buffer.data(), samples * sizeof(int32_t), &bytes_written, portMAX_DELAY));
-    return bytes_written / sizeof(int32_t);
+    // 按 DMA 帧分块转换到常驻缓冲后写入，不再为每次调用分配内存
+    int written = 0;
+    while (written < samples) {
+        int count = std::min<int>(AUDIO_CODEC_DMA_FRAME_NUM, samples - written);
+        OutputConvert(data + written, tx_scratch_.get(), count, gain);
+        size_t bytes_written;
+        ESP_ERROR_CHECK(i2s_channel_write(tx_handle_, tx_scratch_.get(), count * sizeof(int32_t), &bytes_written, portMAX_DELAY));
+        written += bytes_written / sizeof(int32_t);
+    }
+    return written;
 }
 
 int NoAudioCodec::Read(int16_t* dest, int samples) {
-    size_t bytes_read;
-
-    std::vector<int32_t> bit32_buffer(samples);
-    if (i2s_channel_read(rx_handle_, bit32_buffer.data(), samples * sizeof(int32_t), &bytes_read, portMAX_DELAY) != ESP_OK) {
-        ESP_LOGE(TAG, "Read Failed!");
-        return 0;
+    // 按 DMA 帧分块读入常驻缓冲，再右移饱和到 16 位，不再每次分配 32 位临时缓冲
+    if (!rx_scratch_) {
+        rx_scratch_ = std::make_unique<int32_t[]>(AUDIO_CODEC_DMA_FRAME_NUM);
     }
-
-    samples = bytes_read / sizeof(int32_t);
-    for (int i = 0; i < samples; i++) {
-        int32_t value = bit32_buffer[i] >> 12;
-        dest[i] = (value > INT16_MAX) ? INT16_MAX : (value < -INT16_MAX) ? -INT16_MAX : (int16_t)value;
+    int total = 0;
+    while (total < samples) {
+        int count = std::min<int>(AUDIO_CODEC_DMA_FRAME_NUM, samples - total);
+        size_t bytes_read;
+        if (i2s_channel_read(rx_handle_, rx_scratch_.get(), count * sizeof(int32_t), &bytes_read, portMAX_DELAY) != ESP_OK) {
+            ESP_LOGE(TAG, "Read Failed!");
+            return total;
+        }
+        int read = bytes_read / sizeof(int32_t);
+        CaptureNarrow(rx_scratch_.get(), dest + total, read, 12);
+        total += read;
+        if (read < count) {
+            break;
+        }
     }
-    return samples;
+    return total;
 }
 
 int NoAudioCodecSimplexPdm::Read(int16_t* dest, int samples) {
     size_t bytes_read;
 
-    // PDM 解调后的数据位宽为 16 位
-    std::vector<int16_t> bit16_buffer(samples);
-    if (i2s_channel_read(rx_handle_, bit16_buffer.data(), samples * sizeof(int16_t), &bytes_read, portMAX_DELAY) != ESP_OK) {
+    // PDM 解调后的数据位宽为 16 位，直接读入目标缓冲区
+    if (i2s_channel_read(rx_handle_, dest, samples * sizeof(int16_t), &bytes_read, portMAX_DELAY) != ESP_OK) {
         ESP_LOGE(TAG, "Read Failed!");
         return 0;
     }
-
-    // 计算实际读取的样本数
-    samples = bytes_read / sizeof(int16_t);
-
-    // 将 16 位数据直接复制到目标缓冲区
-    memcpy(dest, bit16_buffer.data(), samples * sizeof(int16_t));
-
-    return samples;
+    return bytes_read / sizeof(int16_t);
 }
@@ -2,17 +2,47 @@
 #define _NO_AUDIO_CODEC_H
 
 #include "audio_codec.h"
+#include "dma_playback_ring.h"
+#include "output_kernel.h"
+#include "capture_frontend.h"
 
 #include <driver/gpio.h>
 #include <driver/i2s_pdm.h>
+#include <freertos/semphr.h>
+
+#include <memory>
 
 class NoAudioCodec : public AudioCodec {
 private:
+    // DMA 回调播放（CONFIG_USE_DMA_CALLBACK_PLAYBACK）：Write 写入环形缓冲，on_sent 回调搬运到 DMA
+    std::unique_ptr<DmaPlaybackRing> playback_ring_;
+    SemaphoreHandle_t tx_space_ = nullptr;
+    // 阻塞写入时的转换缓冲，一个 DMA 帧大小，构造时分配一次
+    std::unique_ptr<int32_t[]> tx_scratch_;
+    // 读取时的 32 位采样缓冲，一个 DMA 帧大小，首次读取时分配
+    std::unique_ptr<int32_t[]> rx_scratch_;
+    // 当前音量对应的 Q16 增益，只在音量变化时重新计算
+    int32_t output_gain_ = 0;
+
+    void UpdateOutputGain();
+
     virtual int Write(const int16_t* data, int samples) override;
     virtual int Read(int16_t* dest, int samples) override;
+    static bool OnSent(i2s_chan_handle_t handle, i2s_event_data_t* event, void* user_ctx);
+
+protected:
+    // 在 tx 通道初始化之后、使能之前调用
+    void InitPlayback();
 
 public:
     virtual ~NoAudioCodec();
+
+    virtual void Start() override;
+    virtual void SetOutputVolume(int volume) override;
+
+    virtual size_t OutputBufferedSamples() override;
+    virtual uint32_t OutputUnderruns() override;
+    virtual void FlushOutput() override;
 };
 
 class NoAudioCodecDuplex : public NoAudioCodec {
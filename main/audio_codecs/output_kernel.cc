@@ -0,0 +1,18 @@
+#include "output_kernel.h"
+
+int32_t OutputGain(int volume) {
+    if (volume <= 0) {
+        return 0;
+    }
+    if (volume >= 100) {
+        return 65536;
+    }
+    return (int32_t)((int64_t)volume * volume * 65536 / 10000);
+}
+
+void OutputConvert(const int16_t* src, int32_t* dst, size_t samples, int32_t gain) {
+    // 简单的乘法循环，编译器可以展开/向量化
+    for (size_t i = 0; i < samples; i++) {
+        dst[i] = (int32_t)src[i] * gain;
+    }
+}
@@ -0,0 +1,17 @@
+#ifndef _OUTPUT_KERNEL_H
+#define _OUTPUT_KERNEL_H
+
+#include <cstddef>
+#include <cstdint>
+
+// I2S 输出内核：把 int16 PCM 一次遍历转换成带音量的 32 位 I2S 样本，不分配内存
+// 音量增益为 Q16 定点数（0~65536），只在音量变化时由 OutputGain 计算一次
+// 不依赖 FreeRTOS/驱动，可以在主机上单独测试和基准测试（scripts/audio_sim/output_kernel_bench.cc）
+
+// 音量 0~100 映射为平方律的 Q16 增益，与原先 pow(volume / 100.0, 2) * 65536 一致
+int32_t OutputGain(int volume);
+
+// dst[i] = src[i] * gain；gain 不超过 65536 时结果不会溢出 int32，无需饱和
+void OutputConvert(const int16_t* src, int32_t* dst, size_t samples, int32_t gain);
+
+#endif // _OUTPUT_KERNEL_H
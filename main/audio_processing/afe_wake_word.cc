@@ -1,18 +1,21 @@
 #include "afe_wake_word.h"
 #include "application.h"
+#include "opus_uplink_encoder.h"
 
 #include <esp_log.h>
 #include <model_path.h>
 #include <arpa/inet.h>
 #include <sstream>
+#include <algorithm>
 
 #define DETECTION_RUNNING_EVENT 1
+// 为声纹识别等保留的唤醒词前的音频时长
+#define WAKE_WORD_PCM_HISTORY_MS 2000
 
 #define TAG "AfeWakeWord"
 
 AfeWakeWord::AfeWakeWord()
     : afe_data_(nullptr),
-      wake_word_pcm_(),
       wake_word_opus_() {
 
     event_group_ = xEventGroupCreate();
@@ -69,6 +72,8 @@ void AfeWakeWord::Initialize(AudioCodec* codec) {
     
     afe_iface_ = esp_afe_handle_from_config(afe_config);
     afe_data_ = afe_iface_->create_from_config(afe_config);
+    // AFE 输出 16kHz 单声道
+    wake_word_pcm_.Configure(16000, WAKE_WORD_PCM_HISTORY_MS);
 
     xTaskCreate([](void* arg) {
         auto this_ = (AfeWakeWord*)arg;
@@ -139,16 +144,16 @@ void AfeWakeWord::AudioDetectionTask() {
 }
 
 void AfeWakeWord::StoreWakeWordData(const int16_t* data, size_t samples) {
-    // store audio data to wake_word_pcm_
-    wake_word_pcm_.emplace_back(std::vector<int16_t>(data, data + samples));
-    // keep about 2 seconds of data, detect duration is 30ms (sample_rate == 16000, chunksize == 512)
-    while (wake_word_pcm_.size() > 2000 / 30) {
-        wake_word_pcm_.pop_front();
+    // 编码任务正在读取快照时不写入（检测失败后可能很快重新开始检测）
+    if (wake_word_encoding_.load()) {
+        return;
     }
+    wake_word_pcm_.Write(data, samples);
 }
 
 void AfeWakeWord::EncodeWakeWordData() {
     wake_word_opus_.clear();
+    wake_word_encoding_ = true;
     if (wake_word_encode_task_stack_ == nullptr) {
         wake_word_encode_task_stack_ = (StackType_t*)heap_caps_malloc(4096 * 8, MALLOC_CAP_SPIRAM);
     }
@@ -156,19 +161,26 @@ void AfeWakeWord::EncodeWakeWordData() {
         auto this_ = (AfeWakeWord*)arg;
         {
             auto start_time = esp_timer_get_time();
-            auto encoder = std::make_unique<OpusEncoderWrapper>(16000, 1, OPUS_FRAME_DURATION_MS);
-            encoder->SetComplexity(0); // 0 is the fastest
+            // 默认复杂度 0，最快；直接编码环形缓冲中的两段，不拷贝 PCM
+            auto encoder = std::make_unique<OpusUplinkEncoder>(16000, 1, OPUS_FRAME_DURATION_MS);
 
             int packets = 0;
-            for (auto& pcm: this_->wake_word_pcm_) {
-                encoder->Encode(std::move(pcm), [this_](std::vector<uint8_t>&& opus) {
-                    std::lock_guard<std::mutex> lock(this_->wake_word_mutex_);
-                    this_->wake_word_opus_.emplace_back(std::move(opus));
-                    this_->wake_word_cv_.notify_all();
-                });
+            std::function<void(const uint8_t*, size_t)> handler = [this_, &packets](const uint8_t* opus, size_t size) {
+                std::lock_guard<std::mutex> lock(this_->wake_word_mutex_);
+                this_->wake_word_opus_.emplace_back(opus, opus + size);
+                this_->wake_word_cv_.notify_all();
                 packets++;
+            };
+            // 按帧送入，编码器的输入缓冲不会因为整段快照而扩容
+            size_t frame_samples = 16000 / 1000 * OPUS_FRAME_DURATION_MS;
+            auto snapshot = this_->wake_word_pcm_.GetSnapshot();
+            for (const auto& span : {snapshot.first, snapshot.second}) {
+                for (size_t offset = 0; offset < span.samples; offset += frame_samples) {
+                    encoder->Encode(span.data + offset, std::min(frame_samples, span.samples - offset), handler);
+                }
             }
-            this_->wake_word_pcm_.clear();
+            this_->wake_word_pcm_.Clear();
+            this_->wake_word_encoding_ = false;
 
             auto end_time = esp_timer_get_time();
             ESP_LOGI(TAG, "Encode wake word opus %d packets in %ld ms", packets, (long)((end_time - start_time) / 1000));
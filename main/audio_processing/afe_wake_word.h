@@ -9,6 +9,7 @@
 #include <esp_nsn_models.h>
 
 #include <list>
+#include <atomic>
 #include <string>
 #include <vector>
 #include <functional>
@@ -17,6 +18,7 @@
 
 #include "audio_codec.h"
 #include "wake_word.h"
+#include "pcm_history.h"
 
 class AfeWakeWord : public WakeWord {
 public:
@@ -47,7 +49,9 @@ private:
     TaskHandle_t wake_word_encode_task_ = nullptr;
     StaticTask_t wake_word_encode_task_buffer_;
     StackType_t* wake_word_encode_task_stack_ = nullptr;
-    std::list<std::vector<int16_t>> wake_word_pcm_;
+    // 最近约 2 秒的检测音频，预分配的环形缓冲；编码期间暂停写入，编码任务直接读取快照
+    PcmHistory wake_word_pcm_;
+    std::atomic<bool> wake_word_encoding_{false};
     std::list<std::vector<uint8_t>> wake_word_opus_;
     std::mutex wake_word_mutex_;
     std::condition_variable wake_word_cv_;
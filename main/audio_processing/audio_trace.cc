@@ -0,0 +1,121 @@
+#include "audio_trace.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+#include <cstdio>
+#include <cstring>
+
+#define TAG "AudioTrace"
+
+AudioTrace::AudioTrace() {
+#if CONFIG_USE_AUDIO_TRACE
+    capacity_ = CONFIG_AUDIO_TRACE_EVENTS;
+    // 优先放在 PSRAM，没有 PSRAM 时退回内部 RAM
+    entries_ = (Entry*)heap_caps_calloc(capacity_, sizeof(Entry), MALLOC_CAP_SPIRAM);
+    if (entries_ == nullptr) {
+        entries_ = (Entry*)heap_caps_calloc(capacity_, sizeof(Entry), MALLOC_CAP_8BIT);
+    }
+    if (entries_ == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate %u trace entries", (unsigned)capacity_);
+        capacity_ = 0;
+    }
+#endif
+}
+
+AudioTrace::~AudioTrace() {
+    if (entries_ != nullptr) {
+        heap_caps_free(entries_);
+    }
+}
+
+uint32_t AudioTrace::NewId() {
+    uint32_t id = next_id_.fetch_add(1, std::memory_order_relaxed);
+    if (id == 0) {
+        id = next_id_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return id;
+}
+
+void AudioTrace::Record(Event event, uint32_t id, uint32_t arg) {
+    if (entries_ == nullptr) {
+        return;
+    }
+    uint32_t index = head_.fetch_add(1, std::memory_order_relaxed);
+    auto& entry = entries_[index % capacity_];
+    entry.time_us = (uint32_t)esp_timer_get_time();
+    entry.id = id;
+    entry.event = event;
+    entry.arg = arg > UINT16_MAX ? UINT16_MAX : (uint16_t)arg;
+}
+
+void AudioTrace::Clear() {
+    if (entries_ == nullptr) {
+        return;
+    }
+    head_.store(0, std::memory_order_relaxed);
+    for (size_t i = 0; i < capacity_; i++) {
+        entries_[i].event = 0;
+    }
+}
+
+int AudioTrace::FormatEntry(const Entry& entry, char* buffer, size_t size) {
+    return snprintf(buffer, size, "AT,%lu,%lu,%u,%u", (unsigned long)entry.time_us,
+        (unsigned long)entry.id, (unsigned)entry.event, (unsigned)entry.arg);
+}
+
+size_t AudioTrace::Dump(uint32_t* cursor, char* buffer, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    buffer[0] = '\0';
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    uint32_t oldest = head - (head < capacity_ ? head : (uint32_t)capacity_);
+    size_t length = 0;
+    char line[64];
+    if (*cursor == 0) {
+        int n = snprintf(line, sizeof(line), "# audio-trace v1 capacity=%u recorded=%lu\n",
+            (unsigned)capacity_, (unsigned long)head);
+        if ((size_t)n >= size) {
+            return 0;
+        }
+        memcpy(buffer, line, n + 1);
+        length = n;
+        *cursor = oldest + 1;
+    }
+    if (entries_ == nullptr) {
+        return length;
+    }
+    // 游标保存下一条记录的序号 + 1；导出期间被覆盖的记录直接跳过
+    uint32_t index = *cursor - 1;
+    if ((int32_t)(index - oldest) < 0) {
+        index = oldest;
+    } else if ((int32_t)(index - head) > 0) {
+        index = head;
+    }
+    for (; index != head; index++) {
+        const auto& entry = entries_[index % capacity_];
+        if (entry.event == 0) {
+            continue;
+        }
+        int n = FormatEntry(entry, line, sizeof(line) - 1);
+        line[n++] = '\n';
+        if (length + n >= size) {
+            break;
+        }
+        memcpy(buffer + length, line, n);
+        length += n;
+    }
+    buffer[length] = '\0';
+    *cursor = index + 1;
+    return length;
+}
+
+void AudioTrace::DumpToLog() {
+    // 每块一次日志调用，块内多行；不在堆上拼接整个导出
+    char buffer[512];
+    uint32_t cursor = 0;
+    while (Dump(&cursor, buffer, sizeof(buffer)) > 0) {
+        ESP_LOGI(TAG, "\n%s", buffer);
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef AUDIO_TRACE_H
+#define AUDIO_TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// 音频端到端延迟追踪：下行每帧在接收、解码、重采样、入队、I2S 写入等节点打点，
+// 上行在采集、编码、发送节点打点，
+// 记录写入固定大小的 RAM 环（满后覆盖最旧记录），运行期间不分配、不打印
+// - 通过 MCP 工具 self.audio.dump_trace 分页导出（经 MQTT/WebSocket 返回，或分块打印到串口）
+// - scripts/audio_trace_to_chrome.py 把导出内容转换成 Chrome/Perfetto trace JSON
+// 未启用 CONFIG_USE_AUDIO_TRACE 时不分配环，Record 直接返回
+class AudioTrace {
+public:
+    enum Event : uint8_t {
+        kRx = 1,         // 收到下行包，arg = 载荷字节数
+        kRxDrop,         // 下行包因队列满被丢弃
+        kDecodeStart,    // 解码阶段开始，arg = 解码模式
+        kDecodeEnd,      // 解码阶段结束，arg = 样本数
+        kResampleEnd,    // 重采样阶段结束，arg = 样本数
+        kEnqueue,        // 按序进入播放队列，arg = 入队后的队列长度
+        kOutputStart,    // 开始写入 I2S
+        kOutputEnd,      // I2S 写入返回，arg = 样本数
+        // 上行：ID 按采集块分配，编码出的帧沿用完成该帧的采集块的 ID
+        kUplinkCapture,      // 采集块写入上行 PCM 环，arg = 样本数
+        kUplinkEncodeStart,  // 编码任务取出采集块
+        kUplinkEncodeEnd,    // 编码出一帧，arg = Opus 字节数
+        kUplinkSendStart,    // 主循环开始发送该帧
+        kUplinkSendEnd,      // 发送返回，arg = 1 成功 / 0 失败
+    };
+
+    struct Entry {
+        uint32_t time_us;   // esp_timer 时间的低 32 位，约 71 分钟回绕一次，由主机脚本展开
+        uint32_t id;
+        uint8_t event;
+        uint8_t reserved;
+        uint16_t arg;
+    };
+
+    static AudioTrace& GetInstance() {
+        static AudioTrace instance;
+        return instance;
+    }
+
+    // 为一帧分配追踪 ID（0 保留表示未追踪）
+    uint32_t NewId();
+    // 任意线程调用，无锁；导出与写入并发时个别记录可能不完整，不影响其它记录
+    void Record(Event event, uint32_t id, uint32_t arg = 0);
+
+    bool enabled() const { return entries_ != nullptr; }
+    // 累计写入的记录数（导出游标的上限）
+    uint32_t recorded() const { return head_.load(std::memory_order_relaxed); }
+    void Clear();
+    // 分块导出为文本，不分配内存：首行 "# audio-trace v1 ..."，之后每行 "AT,<time_us>,<id>,<event>,<arg>"
+    // *cursor 从 0 开始（0 时先写首行），每次把尽量多的整行写进 buffer 并推进游标，
+    // 返回写入的字节数（不含结尾的 '\0'），全部导出后返回 0；多次调用的输出依次拼接即为完整的导出
+    size_t Dump(uint32_t* cursor, char* buffer, size_t size);
+    // 用栈上的小缓冲分块打印到串口日志，格式同 Dump
+    void DumpToLog();
+
+private:
+    AudioTrace();
+    ~AudioTrace();
+    AudioTrace(const AudioTrace&) = delete;
+    AudioTrace& operator=(const AudioTrace&) = delete;
+
+    static int FormatEntry(const Entry& entry, char* buffer, size_t size);
+
+    Entry* entries_ = nullptr;
+    size_t capacity_ = 0;
+    std::atomic<uint32_t> head_{0};
+    std::atomic<uint32_t> next_id_{1};
+};
+
+#endif // AUDIO_TRACE_H
@@ -0,0 +1,96 @@
+#include "capture_frontend.h"
+
+#include <esp_log.h>
+
+#define TAG "CaptureFrontend"
+
+void CaptureDeinterleave(const int16_t* src, size_t frames, int channels, int channel, int16_t* dst) {
+    src += channel;
+    for (size_t i = 0; i < frames; i++) {
+        dst[i] = *src;
+        src += channels;
+    }
+}
+
+void CaptureInterleave(const int16_t* src, size_t frames, int channels, int channel, int16_t* dst) {
+    dst += channel;
+    for (size_t i = 0; i < frames; i++) {
+        *dst = src[i];
+        dst += channels;
+    }
+}
+
+void CaptureNarrow(const int32_t* src, int16_t* dst, size_t samples, int shift) {
+    for (size_t i = 0; i < samples; i++) {
+        int32_t value = src[i] >> shift;
+        dst[i] = (value > INT16_MAX) ? INT16_MAX : (value < -INT16_MAX) ? -INT16_MAX : (int16_t)value;
+    }
+}
+
+void CaptureFrontend::Configure(int channels, int input_sample_rate, int output_sample_rate,
+    size_t max_output_samples, Resampler resampler) {
+    channels_ = channels > 0 ? channels : 1;
+    input_sample_rate_ = input_sample_rate;
+    output_sample_rate_ = output_sample_rate;
+    resampler_ = std::move(resampler);
+    raw_.clear();
+    channel_.clear();
+    resampled_.clear();
+    Reserve(max_output_samples);
+}
+
+void CaptureFrontend::Reserve(size_t output_samples) {
+    size_t raw_samples = output_samples * input_sample_rate_ / output_sample_rate_;
+    raw_.reserve(raw_samples);
+    if (resampling()) {
+        size_t frames = raw_samples / channels_;
+        channel_.reserve(frames);
+        resampled_.reserve(frames * output_sample_rate_ / input_sample_rate_ + 1);
+    }
+}
+
+int16_t* CaptureFrontend::PrepareRead(size_t output_samples, size_t& raw_samples) {
+    raw_samples = output_samples * input_sample_rate_ / output_sample_rate_;
+    if (raw_samples > raw_.capacity()) {
+        ESP_LOGW(TAG, "Read of %u samples exceeds the preallocated buffer, growing", (unsigned)output_samples);
+        Reserve(output_samples);
+    }
+    raw_.resize(raw_samples);
+    return raw_.data();
+}
+
+size_t CaptureFrontend::Process(size_t raw_samples, std::vector<int16_t>& output) {
+    if (!resampling()) {
+        output.assign(raw_.begin(), raw_.begin() + raw_samples);
+        return output.size();
+    }
+
+    size_t frames = raw_samples / channels_;
+    // 重采样器可能因内部相位多输出一个样本
+    size_t max_frames = frames * output_sample_rate_ / input_sample_rate_ + 1;
+    if (max_frames > resampled_.capacity()) {
+        Reserve(raw_samples * output_sample_rate_ / input_sample_rate_);
+    }
+    resampled_.resize(max_frames);
+
+    size_t output_frames = 0;
+    for (int channel = 0; channel < channels_; channel++) {
+        const int16_t* source = raw_.data();
+        if (channels_ > 1) {
+            channel_.resize(frames);
+            CaptureDeinterleave(raw_.data(), frames, channels_, channel, channel_.data());
+            source = channel_.data();
+        }
+
+        size_t count = resampler_(channel, source, frames, resampled_.data());
+        // 各声道的重采样器配置相同，输出长度以第一声道为准
+        if (channel == 0) {
+            output_frames = count;
+            output.resize(output_frames * channels_);
+        } else if (count > output_frames) {
+            count = output_frames;
+        }
+        CaptureInterleave(resampled_.data(), count, channels_, channel, output.data());
+    }
+    return output.size();
+}
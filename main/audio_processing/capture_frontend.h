@@ -0,0 +1,54 @@
+#ifndef CAPTURE_FRONTEND_H
+#define CAPTURE_FRONTEND_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// 采集前端内核：在预分配的缓冲之间原地搬运，不分配内存
+// 从交织数据中取出第 channel 声道
+void CaptureDeinterleave(const int16_t* src, size_t frames, int channels, int channel, int16_t* dst);
+// 把单声道数据写回交织缓冲的第 channel 声道
+void CaptureInterleave(const int16_t* src, size_t frames, int channels, int channel, int16_t* dst);
+// 32 位 I2S 采样右移 shift 位后饱和到 [-INT16_MAX, INT16_MAX]
+void CaptureNarrow(const int32_t* src, int16_t* dst, size_t samples, int shift);
+
+// ReadAudio 的采集前端：读取缓冲、各声道缓冲和重采样输出都在 Configure 时一次性分配，
+// 稳态下每次读取只做一次解交织 -> 逐声道重采样 -> 交织，不产生堆分配
+// 不依赖 FreeRTOS/驱动，可以在主机上用录制的多声道 PCM 验证
+class CaptureFrontend {
+public:
+    // 对第 channel 声道重采样 samples 个样本写入 dst，返回写入的样本数
+    using Resampler = std::function<size_t(int channel, const int16_t* src, size_t samples, int16_t* dst)>;
+
+    // max_output_samples 为单次读取输出的最大交织样本数，超出时缓冲会增长一次（打印警告）
+    // input_sample_rate 与 output_sample_rate 相同时不重采样，resampler 可以为空
+    void Configure(int channels, int input_sample_rate, int output_sample_rate,
+        size_t max_output_samples, Resampler resampler);
+
+    // 返回可容纳 output_samples 个输出样本所需原始数据（输入采样率、交织）的读取缓冲，
+    // raw_samples 为需要从 codec 读取的样本数
+    int16_t* PrepareRead(size_t output_samples, size_t& raw_samples);
+    // 把读取缓冲中的 raw_samples 个样本转换为输出采样率的交织数据写入 output，返回输出样本数
+    // output 由调用方长期持有，容量足够时 resize 不会分配
+    size_t Process(size_t raw_samples, std::vector<int16_t>& output);
+
+    bool resampling() const { return input_sample_rate_ != output_sample_rate_; }
+    int channels() const { return channels_; }
+
+private:
+    int channels_ = 1;
+    int input_sample_rate_ = 16000;
+    int output_sample_rate_ = 16000;
+    Resampler resampler_;
+
+    std::vector<int16_t> raw_;        // codec 读取的交织数据
+    std::vector<int16_t> channel_;    // 单声道解交织数据（输入采样率）
+    std::vector<int16_t> resampled_;  // 单声道重采样结果（输出采样率）
+
+    void Reserve(size_t output_samples);
+};
+
+#endif // CAPTURE_FRONTEND_H
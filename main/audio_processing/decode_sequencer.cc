@@ -0,0 +1,75 @@
+#include "decode_sequencer.h"
+
+#include <algorithm>
+
+DecodeSequencer::DecodeSequencer(size_t reorder_depth)
+    : slots_(reorder_depth) {
+}
+
+uint32_t DecodeSequencer::Next() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return next_++;
+}
+
+void DecodeSequencer::Reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stale_before_ = next_;
+}
+
+bool DecodeSequencer::IsStale(uint32_t sequence) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return (int32_t)(sequence - stale_before_) < 0;
+}
+
+void DecodeSequencer::BeginTurn(Stage stage, uint32_t sequence) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_variable_.wait(lock, [this, stage, sequence]() {
+        return turn_[stage] == sequence;
+    });
+}
+
+void DecodeSequencer::EndTurn(Stage stage, uint32_t sequence) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        turn_[stage] = sequence + 1;
+    }
+    condition_variable_.notify_all();
+}
+
+void DecodeSequencer::Complete(uint32_t sequence, PcmPool::Block&& pcm,
+    const std::function<void(PcmPool::Block&& pcm)>& sink) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // 重排缓冲已满时等待更早的帧释放
+    condition_variable_.wait(lock, [this, sequence]() {
+        return sequence - release_ < slots_.size();
+    });
+
+    auto& slot = slots_[sequence % slots_.size()];
+    slot.pcm = std::move(pcm);
+    slot.ready = true;
+    reorder_high_water_ = std::max<size_t>(reorder_high_water_, sequence - release_ + 1);
+
+    if (delivering_) {
+        return;
+    }
+    delivering_ = true;
+    while (slots_[release_ % slots_.size()].ready) {
+        auto& head = slots_[release_ % slots_.size()];
+        PcmPool::Block frame = std::move(head.pcm);
+        head.pcm.reset();
+        head.ready = false;
+        release_++;
+        lock.unlock();
+        condition_variable_.notify_all();
+        if (!frame.empty()) {
+            sink(std::move(frame));
+        }
+        lock.lock();
+    }
+    delivering_ = false;
+}
+
+size_t DecodeSequencer::reorder_high_water() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return reorder_high_water_;
+}
@@ -0,0 +1,67 @@
+#ifndef DECODE_SEQUENCER_H
+#define DECODE_SEQUENCER_H
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+#include "pcm_pool.h"
+
+// 下行解码流水线的保序器：解码任务可以在多个后台线程上并发执行，但
+// - 有状态的阶段（Opus 解码、重采样）按序号严格依次执行，每个阶段同一时刻只有一帧
+// - 各帧的结果先进入重排缓冲，再按序号顺序交给 sink（播放队列）
+// 这样第 N 帧重采样/入队时，第 N+1 帧已经可以开始解码
+//
+// 约束：每个 Next() 分配的序号都必须被调度执行，并且依次经过所有阶段和 Complete，
+// 失败或作废的帧也要走完流程（跳过实际工作），否则后续帧会一直等待
+class DecodeSequencer {
+public:
+    enum Stage {
+        kStageDecode = 0,
+        kStageResample,
+        kStageCount
+    };
+
+    // reorder_depth 不小于同时在途的帧数
+    explicit DecodeSequencer(size_t reorder_depth);
+
+    // 调度方：为下一帧分配序号
+    uint32_t Next();
+    // 作废此前分配的所有序号（任意线程），这些帧仍会走完流程但不再做实际工作
+    void Reset();
+    bool IsStale(uint32_t sequence);
+
+    // 等待轮到 sequence 进入 stage，之后必须调用 EndTurn
+    void BeginTurn(Stage stage, uint32_t sequence);
+    void EndTurn(Stage stage, uint32_t sequence);
+
+    // 提交一帧的结果（可以为空），按序号顺序对非空结果调用 sink。sink 在内部锁外执行，同一时刻只有一个
+    // 线程在交付：它阻塞（如等待写满的 DMA 环）时其他线程照常解码和提交，提交的帧由正在交付的线程接着交出，
+    // 因此所有调用方传入的 sink 必须等价
+    void Complete(uint32_t sequence, PcmPool::Block&& pcm,
+        const std::function<void(PcmPool::Block&& pcm)>& sink);
+
+    // 重排缓冲中曾经同时等待的最大帧数（调试用）
+    size_t reorder_high_water();
+
+private:
+    struct Slot {
+        bool ready = false;
+        PcmPool::Block pcm;
+    };
+
+    std::mutex mutex_;
+    std::condition_variable condition_variable_;
+    std::vector<Slot> slots_;
+    uint32_t next_ = 0;
+    uint32_t stale_before_ = 0;
+    uint32_t turn_[kStageCount] = {};
+    uint32_t release_ = 0;
+    bool delivering_ = false;   // 有线程正在锁外调用 sink
+    size_t reorder_high_water_ = 0;
+};
+
+#endif // DECODE_SEQUENCER_H
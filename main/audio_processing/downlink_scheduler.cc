@@ -0,0 +1,101 @@
+#include "downlink_scheduler.h"
+
+#include <cstring>
+
+DownlinkScheduler::DownlinkScheduler(PacketRing& queue, JitterBuffer& jitter_buffer, DecodeSequencer& sequencer)
+    : queue_(queue), jitter_buffer_(jitter_buffer), sequencer_(sequencer) {
+}
+
+bool DownlinkScheduler::Next(Job& job) {
+    job.lost_frames = 0;
+    job.released = false;
+    // 上一个包之前还有丢失的帧待补：本次只给出其中一帧，暂不取新包
+    if (NextConcealment(job)) {
+        return true;
+    }
+
+    auto action = jitter_buffer_.OnPull(queue_.Size());
+    PacketRing::Packet packet;
+    if (action == JitterBuffer::kWait || !queue_.Acquire(packet)) {
+        return false;
+    }
+    int lost_frames = jitter_buffer_.OnPacketTimestamp(packet.timestamp);
+    bool compress = action == JitterBuffer::kPlayCompressed;
+
+    if (lost_frames > 0) {
+        lost_frames_ = lost_frames;
+        packet_size_ = packet.size <= kMaxPacketSize ? packet.size : 0;
+        memcpy(packet_, packet.data, packet_size_);
+        queue_.Release();
+        timestamp_ = packet.timestamp;
+        trace_id_ = packet.trace_id;
+        compress_ = compress;
+        remaining_ = lost_frames + 1;
+        NextConcealment(job);
+        job.lost_frames = lost_frames;
+        job.released = true;
+        return true;
+    }
+
+    job.mode = kNormal;
+    SetPayload(job, packet.data, packet.size);
+    queue_.Release();
+    job.sequence = sequencer_.Next();
+    job.compress = compress;
+    job.timestamp = packet.timestamp;
+    job.trace_id = packet.trace_id;
+    job.released = true;
+    return true;
+}
+
+bool DownlinkScheduler::NextConcealment(Job& job) {
+    int remaining = remaining_.load();
+    if (remaining == 0) {
+        return false;
+    }
+    int index = lost_frames_ + 1 - remaining;
+    if (index > 0 && sequencer_.IsStale(first_sequence_)) {
+        // 解码器已重置（打断或新的语音流）：丢弃暂存的包和待补的帧
+        remaining_ = 0;
+        return false;
+    }
+    // 最后一个丢失的帧尝试用本包的带内 FEC 恢复，更早的用 PLC 生成
+    // 补出的帧按帧时长往前推算时间戳，服务端 AEC 仍能找到对应的参考
+    uint32_t frame_ms = jitter_buffer_.frame_duration_ms();
+    job.sequence = sequencer_.Next();
+    job.trace_id = trace_id_;
+    if (index < lost_frames_ - 1) {
+        job.mode = kConceal;
+        SetPayload(job, nullptr, 0);
+        job.compress = false;
+        job.timestamp = timestamp_ - (lost_frames_ - index) * frame_ms;
+    } else if (index == lost_frames_ - 1) {
+        job.mode = kFec;
+        SetPayload(job, packet_, packet_size_);
+        job.compress = false;
+        job.timestamp = timestamp_ - frame_ms;
+    } else {
+        job.mode = kNormal;
+        SetPayload(job, packet_, packet_size_);
+        job.compress = compress_;
+        job.timestamp = timestamp_;
+    }
+    if (index == 0) {
+        first_sequence_ = job.sequence;
+    }
+    remaining_ = remaining - 1;
+    return true;
+}
+
+// 载荷拷贝到 job 的内联缓冲；没有载荷或载荷超过 kMaxPacketSize 时改为 PLC
+void DownlinkScheduler::SetPayload(Job& job, const uint8_t* data, size_t size) {
+    if (size == 0 || size > kMaxPacketSize) {
+        job.mode = kConceal;
+        job.data = nullptr;
+        job.size = 0;
+        return;
+    }
+    memcpy(job.buffer, data, size);
+    job.data = job.buffer;
+    job.size = size;
+}
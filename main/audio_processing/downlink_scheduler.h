@@ -0,0 +1,75 @@
+#ifndef DOWNLINK_SCHEDULER_H
+#define DOWNLINK_SCHEDULER_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+#include "packet_ring.h"
+#include "jitter_buffer.h"
+#include "decode_sequencer.h"
+
+// 下行解码的取包调度：每次通过准入（PlaybackFlowControl::Admit）后调用一次 Next，最多给出一帧解码任务
+// - 抖动缓冲决定是否从环形队列取新包；取出后把载荷拷贝到 Job 的内联缓冲并立即归还 slab 空间，不分配内存
+//   （超过 kMaxPacketSize 的包按丢失处理，用 PLC 补出这一帧）
+// - 按时间戳发现丢帧时先暂存本包，丢失的帧和本包各占一个序号，之后每次调用只给出其中一帧
+//   （依次为 PLC 帧、用本包 FEC 恢复的帧、本包），补出的帧与正常帧一样受在途上限约束
+// - 解码器重置（保序器作废了第一帧的序号）后丢弃暂存的包和待补的帧
+// Next 只在调度线程调用；pending() 可在任意线程读取
+// 不依赖 FreeRTOS，主机模拟器（scripts/audio_sim）与设备使用同一份调度
+class DownlinkScheduler {
+public:
+    // 单个下行包的上限：Opus 单帧最大 1275 字节，服务端的 20~120ms 包实际远小于此
+    static constexpr size_t kMaxPacketSize = 1500;
+
+    enum Mode {
+        kNormal,    // 正常解码
+        kFec,       // 用包内带内 FEC 恢复它之前丢失的一帧
+        kConceal,   // PLC 生成一帧
+    };
+
+    // 载荷内联在 Job 中，由调用方预分配（见 JobSlots）后交给解码线程；data 可能指向自身的 buffer，因此不可拷贝
+    struct Job {
+        Job() = default;
+        Job(const Job&) = delete;
+        Job& operator=(const Job&) = delete;
+
+        Mode mode = kNormal;
+        uint32_t sequence = 0;          // 已从保序器分配，调用方必须调度这一帧
+        const uint8_t* data = nullptr;  // 指向 buffer；调用方自己填写时也可以指向其他只读数据（如 flash 中的提示音）
+        size_t size = 0;                // kConceal 时为 0
+        bool compress = false;          // 抖动缓冲要求压缩本帧
+        uint32_t timestamp = 0;         // 补出的帧按帧时长从本包往前推算
+        uint32_t trace_id = 0;          // 补出的帧沿用本包的追踪 ID
+        int lost_frames = 0;            // 取到本包时发现的丢帧数，只在给出第一帧时非 0
+        bool released = false;          // 本次从环形队列取出并归还了一个包
+        uint8_t buffer[kMaxPacketSize];
+    };
+
+    DownlinkScheduler(PacketRing& queue, JitterBuffer& jitter_buffer, DecodeSequencer& sequencer);
+
+    // 有一帧需要调度时填写 job 并返回 true；抖动缓冲要求等待或队列为空时返回 false
+    bool Next(Job& job);
+    // 还有待补的帧（含暂存的包）
+    bool pending() const { return remaining_.load() > 0; }
+
+private:
+    PacketRing& queue_;
+    JitterBuffer& jitter_buffer_;
+    DecodeSequencer& sequencer_;
+
+    // 除 remaining_ 外只在调度线程访问
+    std::atomic<int> remaining_{0};     // 还要调度的帧数（含本包）
+    int lost_frames_ = 0;
+    uint32_t first_sequence_ = 0;       // 第一帧的解码序号
+    uint8_t packet_[kMaxPacketSize];    // 暂存的包
+    size_t packet_size_ = 0;            // 超过 kMaxPacketSize 时为 0，本包也用 PLC 补出
+    uint32_t timestamp_ = 0;
+    uint32_t trace_id_ = 0;
+    bool compress_ = false;
+
+    bool NextConcealment(Job& job);
+    static void SetPayload(Job& job, const uint8_t* data, size_t size);
+};
+
+#endif // DOWNLINK_SCHEDULER_H
@@ -0,0 +1,121 @@
+#include "encoder_controller.h"
+
+#include <algorithm>
+
+void EncoderController::Configure(const Limits& limits, int initial_complexity, int frame_duration_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    limits_ = limits;
+    settings_.complexity = std::min(std::max(initial_complexity, limits.min_complexity), limits.max_complexity);
+    settings_.bitrate = limits.max_bitrate;
+    settings_.vbr = limits.vbr;
+    settings_.constrained_vbr = false;
+    settings_.dtx = limits.dtx;
+    stats_ = Stats();
+    cpu_good_windows_ = 0;
+    link_good_windows_ = 0;
+    frame_duration_ms_ = frame_duration_ms;
+    window_frames_ = std::max(1, 1000 / frame_duration_ms);
+    frames_ = 0;
+    encode_us_total_ = 0;
+    encode_us_max_ = 0;
+    max_depth_ = 0;
+    send_failures_ = 0;
+    dropped_ = 0;
+}
+
+void EncoderController::OnFrameEncoded(uint32_t encode_us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    frames_++;
+    encode_us_total_ += encode_us;
+    encode_us_max_ = std::max(encode_us_max_, encode_us);
+}
+
+void EncoderController::OnSend(size_t queue_depth, bool success) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    max_depth_ = std::max(max_depth_, queue_depth);
+    if (!success) {
+        send_failures_++;
+    }
+}
+
+void EncoderController::OnDropped() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    dropped_++;
+}
+
+bool EncoderController::Evaluate(Settings& settings) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (frames_ < window_frames_) {
+        return false;
+    }
+
+    Settings previous = settings_;
+    float frame_us = frame_duration_ms_ * 1000.0f;
+    float mean_load = encode_us_total_ / (float)frames_ / frame_us;
+    float peak_load = encode_us_max_ / frame_us;
+
+    // CPU：过载立即降两档，持续空闲才升一档
+    if (mean_load > limits_.high_load || peak_load > limits_.peak_load) {
+        cpu_good_windows_ = 0;
+        if (settings_.complexity > limits_.min_complexity) {
+            settings_.complexity = std::max(settings_.complexity - 2, limits_.min_complexity);
+            stats_.complexity_down++;
+        }
+    } else if (mean_load < limits_.low_load) {
+        if (++cpu_good_windows_ >= limits_.recover_windows) {
+            cpu_good_windows_ = 0;
+            if (settings_.complexity < limits_.max_complexity) {
+                settings_.complexity++;
+                stats_.complexity_up++;
+            }
+        }
+    } else {
+        cpu_good_windows_ = 0;
+    }
+
+    // 链路：积压或失败立即降码率，持续通畅才逐步回升
+    bool congested = send_failures_ > 0 || dropped_ > 0 || max_depth_ >= limits_.congested_depth;
+    if (congested) {
+        link_good_windows_ = 0;
+        if (settings_.bitrate > limits_.min_bitrate) {
+            settings_.bitrate = std::max(settings_.bitrate * 3 / 4, limits_.min_bitrate);
+            stats_.bitrate_down++;
+        }
+        settings_.dtx = true;
+        settings_.constrained_vbr = limits_.vbr;
+    } else if (max_depth_ <= 1) {
+        if (++link_good_windows_ >= limits_.recover_windows) {
+            link_good_windows_ = 0;
+            if (settings_.bitrate < limits_.max_bitrate) {
+                settings_.bitrate = std::min(settings_.bitrate + limits_.bitrate_step, limits_.max_bitrate);
+                stats_.bitrate_up++;
+            }
+            if (settings_.bitrate >= limits_.max_bitrate) {
+                settings_.dtx = limits_.dtx;
+                settings_.constrained_vbr = false;
+            }
+        }
+    } else {
+        link_good_windows_ = 0;
+    }
+
+    frames_ = 0;
+    encode_us_total_ = 0;
+    encode_us_max_ = 0;
+    max_depth_ = 0;
+    send_failures_ = 0;
+    dropped_ = 0;
+
+    settings = settings_;
+    return settings_ != previous;
+}
+
+EncoderController::Settings EncoderController::settings() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return settings_;
+}
+
+EncoderController::Stats EncoderController::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
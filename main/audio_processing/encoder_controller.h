@@ -0,0 +1,91 @@
+#ifndef ENCODER_CONTROLLER_H
+#define ENCODER_CONTROLLER_H
+
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+// 上行 Opus 编码参数的自适应控制：按评估窗口（约 1 秒音频）统计编码耗时、发送队列深度和发送失败，
+// 在配置的上下限之间调整复杂度、码率、VBR 和 DTX
+// - CPU：平均编码耗时超过帧时长的 high_load（或单帧超过 peak_load）时复杂度立即下调 2 档；
+//   连续 recover_windows 个窗口低于 low_load 才上调 1 档
+// - 链路：窗口内有发送失败、丢帧或发送队列积压达到 congested_depth 时码率立即乘以 0.75，
+//   同时打开 DTX 和受限 VBR（限制包长峰值）；连续 recover_windows 个窗口无积压才每次回升 bitrate_step，
+//   回到上限后恢复配置的 DTX/VBR
+// 下调立即生效、上调需要持续满足条件，避免在边界附近来回切换
+// OnFrameEncoded/Evaluate 在编码线程调用，OnSend 在发送线程调用；不依赖 FreeRTOS/libopus，可以在主机上验证
+class EncoderController {
+public:
+    struct Limits {
+        int min_complexity = 0;
+        int max_complexity = 5;
+        int min_bitrate = 12000;
+        int max_bitrate = 24000;
+        int bitrate_step = 2000;
+        bool vbr = true;
+        bool dtx = true;            // 链路通畅时的 DTX（OpusEncoderWrapper 默认打开）
+        float high_load = 0.25f;    // 平均编码耗时 / 帧时长
+        float peak_load = 0.5f;     // 单帧编码耗时 / 帧时长
+        float low_load = 0.10f;
+        size_t congested_depth = 3; // 发送时队列中积压的包数
+        int recover_windows = 5;
+    };
+
+    struct Settings {
+        int complexity = 0;
+        int bitrate = 0;
+        bool vbr = true;
+        bool constrained_vbr = false;
+        bool dtx = true;
+
+        bool operator==(const Settings& other) const {
+            return complexity == other.complexity && bitrate == other.bitrate && vbr == other.vbr &&
+                constrained_vbr == other.constrained_vbr && dtx == other.dtx;
+        }
+        bool operator!=(const Settings& other) const { return !(*this == other); }
+    };
+
+    struct Stats {
+        uint32_t complexity_down = 0;
+        uint32_t complexity_up = 0;
+        uint32_t bitrate_down = 0;
+        uint32_t bitrate_up = 0;
+    };
+
+    // initial_complexity 为起始复杂度（限制在上下限内），码率从上限开始
+    void Configure(const Limits& limits, int initial_complexity, int frame_duration_ms);
+
+    // 编码线程：每编码一帧调用一次
+    void OnFrameEncoded(uint32_t encode_us);
+    // 发送线程：每发送一个包调用一次，queue_depth 为发送时队列中（含本包）尚未发出的包数
+    void OnSend(size_t queue_depth, bool success);
+    // 发送队列满而丢弃了帧
+    void OnDropped();
+
+    // 编码线程：窗口结束时给出新的编码参数，参数有变化时返回 true
+    bool Evaluate(Settings& settings);
+
+    Settings settings();
+    Stats GetStats();
+
+private:
+    std::mutex mutex_;
+    Limits limits_;
+    Settings settings_;
+    Stats stats_;
+    int frame_duration_ms_ = 60;
+    int window_frames_ = 1;
+
+    // 当前窗口
+    int frames_ = 0;
+    uint64_t encode_us_total_ = 0;
+    uint32_t encode_us_max_ = 0;
+    size_t max_depth_ = 0;
+    uint32_t send_failures_ = 0;
+    uint32_t dropped_ = 0;
+
+    int cpu_good_windows_ = 0;
+    int link_good_windows_ = 0;
+};
+
+#endif // ENCODER_CONTROLLER_H
@@ -5,9 +5,17 @@
 #include <model_path.h>
 #include <arpa/inet.h>
 #include <sstream>
+#include <cstring>
+#include <algorithm>
+#include <esp_timer.h>
 
 #define DETECTION_RUNNING_EVENT 1
 
+// 检测任务：低于采集循环（8），高于主循环；帧队列约 8 x 32ms
+#define DETECTION_TASK_STACK_SIZE (4096 * 2)
+#define DETECTION_TASK_PRIORITY 5
+#define DETECTION_QUEUE_FRAMES 8
+
 #define TAG "EspWakeWord"
 
 EspWakeWord::EspWakeWord() {
@@ -15,6 +23,9 @@ EspWakeWord::EspWakeWord() {
 }
 
 EspWakeWord::~EspWakeWord() {
+    if (frame_queue_ != nullptr) {
+        vQueueDelete(frame_queue_);
+    }
     if (wakenet_data_ != nullptr) {
         wakenet_iface_->destroy(wakenet_data_);
         esp_srmodel_deinit(wakenet_model_);
@@ -44,6 +55,19 @@ void EspWakeWord::Initialize(AudioCodec* codec) {
     int frequency = wakenet_iface_->get_samp_rate(wakenet_data_);
     int audio_chunksize = wakenet_iface_->get_samp_chunksize(wakenet_data_);
     ESP_LOGI(TAG, "Wake word(%s),freq: %d, chunksize: %d", model_name, frequency, audio_chunksize);
+
+    frame_samples_ = audio_chunksize;
+    frame_item_size_ = sizeof(FrameHeader) + frame_samples_ * sizeof(int16_t);
+    feed_buffer_.reset(new uint8_t[frame_item_size_]);
+    discard_buffer_.reset(new uint8_t[frame_item_size_]);
+    detect_buffer_.reset(new uint8_t[frame_item_size_]);
+    frame_queue_ = xQueueCreate(DETECTION_QUEUE_FRAMES, frame_item_size_);
+
+    xTaskCreate([](void* arg) {
+        auto this_ = (EspWakeWord*)arg;
+        this_->DetectionTask();
+        vTaskDelete(NULL);
+    }, "wake_word_detect", DETECTION_TASK_STACK_SIZE, this, DETECTION_TASK_PRIORITY, nullptr);
 }
 
 void EspWakeWord::OnWakeWordDetected(std::function<void(const std::string& wake_word)> callback) {
@@ -55,7 +79,15 @@ void EspWakeWord::StartDetection() {
 }
 
 void EspWakeWord::StopDetection() {
+    bool was_running = IsDetectionRunning();
     xEventGroupClearBits(event_group_, DETECTION_RUNNING_EVENT);
+    // 排队中的帧属于这一轮检测，不再处理
+    if (frame_queue_ != nullptr) {
+        xQueueReset(frame_queue_);
+    }
+    if (was_running) {
+        LogDetectionStats();
+    }
 }
 
 bool EspWakeWord::IsDetectionRunning() {
@@ -63,17 +95,56 @@ bool EspWakeWord::IsDetectionRunning() {
 }
 
 void EspWakeWord::Feed(const std::vector<int16_t>& data) {
-    int res = wakenet_iface_->detect(wakenet_data_, (int16_t *)data.data());
-    if (res > 0) {
-        StopDetection();
-        last_detected_wake_word_ = wakenet_iface_->get_word_name(wakenet_data_, res);
+    if (frame_queue_ == nullptr) {
+        return;
+    }
+    FrameHeader header = {esp_timer_get_time()};
+    size_t samples = std::min(data.size(), frame_samples_);
+    memcpy(feed_buffer_.get(), &header, sizeof(header));
+    memcpy(feed_buffer_.get() + sizeof(header), data.data(), samples * sizeof(int16_t));
+    memset(feed_buffer_.get() + sizeof(header) + samples * sizeof(int16_t), 0, (frame_samples_ - samples) * sizeof(int16_t));
+    frames_++;
+    // 不阻塞采集线程：队列满时丢弃最旧的一帧
+    while (xQueueSend(frame_queue_, feed_buffer_.get(), 0) != pdTRUE) {
+        if (xQueueReceive(frame_queue_, discard_buffer_.get(), 0) == pdTRUE) {
+            dropped_frames_++;
+        }
+    }
+}
 
-        if (wake_word_detected_callback_) {
-            wake_word_detected_callback_(last_detected_wake_word_);
+void EspWakeWord::DetectionTask() {
+    while (true) {
+        if (xQueueReceive(frame_queue_, detect_buffer_.get(), portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        if (!IsDetectionRunning()) {
+            continue;
+        }
+        FrameHeader header;
+        memcpy(&header, detect_buffer_.get(), sizeof(header));
+        int res = wakenet_iface_->detect(wakenet_data_, (int16_t*)(detect_buffer_.get() + sizeof(header)));
+        detect_latency_.Add((uint32_t)(esp_timer_get_time() - header.enqueue_us));
+        if (res > 0) {
+            StopDetection();
+            last_detected_wake_word_ = wakenet_iface_->get_word_name(wakenet_data_, res);
+
+            if (wake_word_detected_callback_) {
+                wake_word_detected_callback_(last_detected_wake_word_);
+            }
         }
     }
 }
 
+void EspWakeWord::LogDetectionStats() {
+    char histogram[128];
+    detect_latency_.Format(histogram, sizeof(histogram));
+    ESP_LOGI(TAG, "Detection: %u frames, %u dropped, latency %s", (unsigned)frames_.load(),
+        (unsigned)dropped_frames_.load(), histogram);
+    frames_ = 0;
+    dropped_frames_ = 0;
+    detect_latency_.Reset();
+}
+
 size_t EspWakeWord::GetFeedSize() {
     if (wakenet_data_ == nullptr) {
         return 0;
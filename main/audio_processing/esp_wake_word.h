@@ -4,12 +4,15 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <freertos/event_groups.h>
+#include <freertos/queue.h>
 
 #include <esp_wn_iface.h>
 #include <esp_wn_models.h>
 #include <model_path.h>
 
 #include <list>
+#include <atomic>
+#include <memory>
 #include <string>
 #include <vector>
 #include <functional>
@@ -18,7 +21,10 @@
 
 #include "audio_codec.h"
 #include "wake_word.h"
+#include "latency_stat.h"
 
+// WakeNet 检测在独立任务中进行：Feed 只把一帧拷贝进固定大小的帧队列，采集循环不会被检测耗时拖慢
+// 队列满时丢弃最旧的一帧并计数；每次停止检测时打印丢帧数和检测延迟（入队到检测返回）的分布
 class EspWakeWord : public WakeWord {
 public:
     EspWakeWord();
@@ -44,6 +50,23 @@ private:
 
     std::function<void(const std::string& wake_word)> wake_word_detected_callback_;
     std::string last_detected_wake_word_;
+
+    // 帧队列的每一项为 FrameHeader + 一帧样本
+    struct FrameHeader {
+        int64_t enqueue_us;
+    };
+    QueueHandle_t frame_queue_ = nullptr;
+    size_t frame_samples_ = 0;
+    size_t frame_item_size_ = 0;
+    std::unique_ptr<uint8_t[]> feed_buffer_;      // 只在 Feed（采集线程）中使用
+    std::unique_ptr<uint8_t[]> discard_buffer_;   // 只在 Feed 中使用：接收被丢弃的最旧一帧
+    std::unique_ptr<uint8_t[]> detect_buffer_;    // 只在检测任务中使用
+    std::atomic<uint32_t> frames_{0};
+    std::atomic<uint32_t> dropped_frames_{0};
+    LatencyHistogram detect_latency_;
+
+    void DetectionTask();
+    void LogDetectionStats();
 };
 
 #endif
@@ -0,0 +1,233 @@
+#include "jitter_buffer.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+// 估计的到达抖动乘以该系数作为预缓冲目标
+#define JITTER_TARGET_FACTOR 4
+// 缓冲高于目标多少帧后开始时间压缩
+#define JITTER_COMPRESS_HYSTERESIS_FRAMES 2
+// 单次最多补偿的丢失帧数；更大的时间戳跳变视为流不连续，不做补偿
+#define JITTER_MAX_CONCEALED_FRAMES 3
+#define JITTER_MAX_GAP_FRAMES 10
+
+JitterBuffer::JitterBuffer(int frame_duration_ms, int min_prebuffer_ms, int max_prebuffer_ms)
+    : frame_duration_ms_(frame_duration_ms),
+      min_prebuffer_ms_(min_prebuffer_ms),
+      max_prebuffer_ms_(max_prebuffer_ms),
+      target_ms_(min_prebuffer_ms),
+      average_interval_us_(frame_duration_ms * 1000LL),
+      producer_frame_duration_ms_(frame_duration_ms),
+      interval_us_(frame_duration_ms * 1000LL) {
+}
+
+void JitterBuffer::Reset() {
+    received_.store(0, std::memory_order_relaxed);
+    late_.store(0, std::memory_order_relaxed);
+    early_.store(0, std::memory_order_relaxed);
+    dropped_.store(0, std::memory_order_relaxed);
+    underruns_.store(0, std::memory_order_relaxed);
+    compressed_.store(0, std::memory_order_relaxed);
+    lost_.store(0, std::memory_order_relaxed);
+    concealed_.store(0, std::memory_order_relaxed);
+    underrun_pending_.store(false, std::memory_order_relaxed);
+    draining_.store(false, std::memory_order_relaxed);
+    // 生产者和消费者各自在下一次调用时发现代数变化，重置私有状态
+    generation_.fetch_add(1, std::memory_order_release);
+}
+
+void JitterBuffer::Drain() {
+    draining_.store(true, std::memory_order_release);
+}
+
+void JitterBuffer::SetFrameDuration(int frame_duration_ms) {
+    if (frame_duration_ms <= 0 || frame_duration_ms == frame_duration_ms_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    frame_duration_ms_.store(frame_duration_ms, std::memory_order_relaxed);
+    average_interval_us_.store(frame_duration_ms * 1000LL, std::memory_order_relaxed);
+    Reset();
+}
+
+void JitterBuffer::SyncProducer() {
+    uint32_t generation = generation_.load(std::memory_order_acquire);
+    if (generation != producer_generation_) {
+        producer_generation_ = generation;
+        last_arrival_us_ = 0;
+        // 帧时长变化后，按旧时长估计的到达间隔不再有效
+        int frame_duration_ms = frame_duration_ms_.load(std::memory_order_relaxed);
+        if (frame_duration_ms != producer_frame_duration_ms_) {
+            producer_frame_duration_ms_ = frame_duration_ms;
+            interval_us_ = frame_duration_ms * 1000LL;
+        }
+    }
+}
+
+uint32_t JitterBuffer::StampPacket(uint32_t transport_timestamp) {
+    SyncProducer();
+    // 传输层没有时间戳时按帧时长递增；被丢弃的包同样占用一个时间戳，消费者才能发现缺口
+    if (transport_timestamp != 0) {
+        producer_timestamp_ = transport_timestamp;
+    } else {
+        producer_timestamp_ += frame_duration_ms();
+    }
+    return producer_timestamp_;
+}
+
+void JitterBuffer::OnPacketArrived(int64_t now_us, size_t depth_packets) {
+    SyncProducer();
+
+    received_.fetch_add(1, std::memory_order_relaxed);
+    const int64_t frame_us = frame_duration_ms() * 1000LL;
+    if (last_arrival_us_ != 0) {
+        // RFC 3550 风格的抖动估计：到达间隔相对帧时长的偏差做 1/16 指数平滑
+        int64_t interval = now_us - last_arrival_us_;
+        int64_t deviation = interval > frame_us ? interval - frame_us : frame_us - interval;
+        jitter_us_ += (deviation - jitter_us_) / 16;
+        interval_us_ += (interval - interval_us_) / 16;
+        average_interval_us_.store(interval_us_, std::memory_order_relaxed);
+
+        int jitter_ms = (int)(jitter_us_ / 1000);
+        int target = frame_duration_ms() + JITTER_TARGET_FACTOR * jitter_ms;
+        target = std::max(min_prebuffer_ms_, std::min(max_prebuffer_ms_, target));
+        jitter_ms_.store(jitter_ms, std::memory_order_relaxed);
+        target_ms_.store(target, std::memory_order_relaxed);
+    }
+    last_arrival_us_ = now_us;
+
+    int depth_ms = (int)depth_packets * frame_duration_ms();
+    if (underrun_pending_.exchange(false, std::memory_order_acq_rel)) {
+        late_.fetch_add(1, std::memory_order_relaxed);
+    } else if (depth_ms > target_ms() + JITTER_COMPRESS_HYSTERESIS_FRAMES * frame_duration_ms()) {
+        early_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void JitterBuffer::OnPacketDropped() {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+JitterBuffer::Action JitterBuffer::OnPull(size_t depth_packets) {
+    uint32_t generation = generation_.load(std::memory_order_acquire);
+    if (generation != consumer_generation_) {
+        consumer_generation_ = generation;
+        playing_ = false;
+        compressing_ = false;
+        has_last_timestamp_ = false;
+    }
+
+    bool draining = draining_.load(std::memory_order_acquire);
+    int depth_ms = (int)depth_packets * frame_duration_ms();
+    int target = target_ms();
+
+    if (!playing_) {
+        // 预缓冲：流结束后不再等待目标深度
+        if (depth_packets == 0 || (!draining && depth_ms < target)) {
+            return kWait;
+        }
+        playing_ = true;
+    }
+
+    if (depth_packets == 0) {
+        if (!draining) {
+            // 播放中被取空：记录欠载并重新预缓冲
+            underruns_.fetch_add(1, std::memory_order_relaxed);
+            underrun_pending_.store(true, std::memory_order_release);
+            playing_ = false;
+            compressing_ = false;
+        }
+        return kWait;
+    }
+
+    // 只对按实时速率到达的流做压缩；服务器突发下发整段音频时，积压的是内容而不是延迟
+    if (compressing_) {
+        if (depth_ms <= target || draining) {
+            compressing_ = false;
+        }
+    } else if (!draining && IsRealtimeStream() &&
+               depth_ms > target + JITTER_COMPRESS_HYSTERESIS_FRAMES * frame_duration_ms()) {
+        compressing_ = true;
+    }
+
+    if (compressing_) {
+        compressed_.fetch_add(1, std::memory_order_relaxed);
+        return kPlayCompressed;
+    }
+    return kPlay;
+}
+
+int JitterBuffer::OnPacketTimestamp(uint32_t timestamp) {
+    bool has_last = has_last_timestamp_;
+    int32_t delta = (int32_t)(timestamp - last_timestamp_);
+    has_last_timestamp_ = true;
+    last_timestamp_ = timestamp;
+    if (!has_last || delta <= 0) {
+        // 新流的第一个包，或时间戳回退（服务器重新计时）
+        return 0;
+    }
+
+    int missing = (delta + frame_duration_ms() / 2) / frame_duration_ms() - 1;
+    if (missing <= 0) {
+        return 0;
+    }
+    lost_.fetch_add(missing, std::memory_order_relaxed);
+    if (missing > JITTER_MAX_GAP_FRAMES) {
+        return 0;
+    }
+    int conceal = std::min(missing, JITTER_MAX_CONCEALED_FRAMES);
+    concealed_.fetch_add(conceal, std::memory_order_relaxed);
+    return conceal;
+}
+
+bool JitterBuffer::IsRealtimeStream() const {
+    // 平均到达间隔不低于帧时长的 3/4，视为实时节奏
+    return average_interval_us_.load(std::memory_order_relaxed) * 4 >= frame_duration_ms() * 1000LL * 3;
+}
+
+JitterBuffer::Stats JitterBuffer::GetStats() const {
+    Stats stats;
+    stats.received = received_.load(std::memory_order_relaxed);
+    stats.late = late_.load(std::memory_order_relaxed);
+    stats.early = early_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    stats.underruns = underruns_.load(std::memory_order_relaxed);
+    stats.compressed = compressed_.load(std::memory_order_relaxed);
+    stats.lost = lost_.load(std::memory_order_relaxed);
+    stats.concealed = concealed_.load(std::memory_order_relaxed);
+    stats.jitter_ms = jitter_ms_.load(std::memory_order_relaxed);
+    stats.target_ms = target_ms();
+    return stats;
+}
+
+size_t JitterBuffer::CompressPcm(int16_t* pcm, size_t samples, size_t remove) {
+    if (remove == 0 || samples < remove * 3) {
+        return samples;
+    }
+
+    // 以 2*remove 为窗长、remove/2 为步长，寻找能量最低的位置
+    size_t step = std::max<size_t>(remove / 2, 1);
+    size_t best_pos = 0;
+    int64_t best_energy = INT64_MAX;
+    for (size_t pos = 0; pos + 2 * remove <= samples; pos += step) {
+        int64_t energy = 0;
+        for (size_t i = 0; i < 2 * remove; i++) {
+            energy += (int32_t)pcm[pos + i] * pcm[pos + i];
+        }
+        if (energy < best_energy) {
+            best_energy = energy;
+            best_pos = pos;
+        }
+    }
+
+    // 将 [pos, pos+remove) 与 [pos+remove, pos+2*remove) 线性交叉淡化后合并为一段
+    int16_t* a = pcm + best_pos;
+    const int16_t* b = a + remove;
+    for (size_t i = 0; i < remove; i++) {
+        int32_t mixed = ((int32_t)a[i] * (int32_t)(remove - i) + (int32_t)b[i] * (int32_t)i) / (int32_t)remove;
+        a[i] = (int16_t)mixed;
+    }
+    size_t tail = samples - best_pos - 2 * remove;
+    memmove(a + remove, b + remove, tail * sizeof(int16_t));
+    return samples - remove;
+}
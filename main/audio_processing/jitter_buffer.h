@@ -0,0 +1,103 @@
+#ifndef JITTER_BUFFER_H
+#define JITTER_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// 下行自适应抖动缓冲策略（不持有数据，数据仍在 PacketRing 中）
+// - 生产者（协议回调）每收到一帧调用 OnPacketArrived，估计到达抖动并更新目标预缓冲深度
+// - 消费者（OnAudioOutput）每次取帧前调用 OnPull：未达到目标深度前等待，达到后开始播放；
+//   播放中缓冲被取空时重新预缓冲；实时流的缓冲明显高于目标时，通过时间压缩（而不是删帧）平滑收缩延迟
+// - 每个包带一个时间戳（传输层没有时就按帧时长合成），消费者据此发现丢失的帧，交给解码器做 PLC/FEC
+// - Reset/Drain 可在任意线程调用
+class JitterBuffer {
+public:
+    enum Action {
+        kWait,            // 不取帧
+        kPlay,            // 取一帧正常播放
+        kPlayCompressed,  // 取一帧，解码后做时间压缩
+    };
+
+    struct Stats {
+        uint32_t received = 0;
+        uint32_t late = 0;        // 播放中缓冲已被取空后才到达的帧
+        uint32_t early = 0;       // 到达时缓冲已高于目标（突发到达）的帧
+        uint32_t dropped = 0;     // 队列已满被丢弃的帧
+        uint32_t underruns = 0;   // 播放中缓冲被取空的次数
+        uint32_t compressed = 0;  // 做了时间压缩的帧
+        uint32_t lost = 0;        // 按时间戳推算丢失的帧
+        uint32_t concealed = 0;   // 通过 PLC/FEC 补偿的帧
+        int jitter_ms = 0;
+        int target_ms = 0;
+    };
+
+    JitterBuffer(int frame_duration_ms, int min_prebuffer_ms, int max_prebuffer_ms);
+
+    // 新的音频流开始：清空统计，重新预缓冲（保留已估计的网络抖动）
+    void Reset();
+    // 音频流已发送完毕：不再等待预缓冲，剩余帧直接播放
+    void Drain();
+    // 协商出新的帧时长（20/40/60ms）：之后的帧按新时长计算深度和合成时间戳，并重新预缓冲
+    // 应在两段音频流之间调用
+    void SetFrameDuration(int frame_duration_ms);
+    int frame_duration_ms() const { return frame_duration_ms_.load(std::memory_order_relaxed); }
+
+    // 生产者：每收到一个包（无论能否入队）先调用 StampPacket 得到入队用的时间戳
+    uint32_t StampPacket(uint32_t transport_timestamp);
+    void OnPacketArrived(int64_t now_us, size_t depth_packets);
+    void OnPacketDropped();
+
+    // 消费者
+    Action OnPull(size_t depth_packets);
+    // 取到一个包后调用：返回在它之前需要补偿的丢失帧数
+    int OnPacketTimestamp(uint32_t timestamp);
+
+    Stats GetStats() const;
+    int target_ms() const { return target_ms_.load(std::memory_order_relaxed); }
+
+    // 从一帧 PCM 中移除约 remove 个样本：在能量最低处做交叉淡化，避免删帧造成的跳变
+    // 返回压缩后的样本数
+    static size_t CompressPcm(int16_t* pcm, size_t samples, size_t remove);
+
+private:
+    std::atomic<int> frame_duration_ms_;
+    const int min_prebuffer_ms_;
+    const int max_prebuffer_ms_;
+
+    std::atomic<uint32_t> generation_{0};
+    std::atomic<bool> draining_{false};
+    std::atomic<bool> underrun_pending_{false};
+    std::atomic<int> target_ms_;
+    std::atomic<int> jitter_ms_{0};
+    std::atomic<int64_t> average_interval_us_;
+
+    std::atomic<uint32_t> received_{0};
+    std::atomic<uint32_t> late_{0};
+    std::atomic<uint32_t> early_{0};
+    std::atomic<uint32_t> dropped_{0};
+    std::atomic<uint32_t> underruns_{0};
+    std::atomic<uint32_t> compressed_{0};
+    std::atomic<uint32_t> lost_{0};
+    std::atomic<uint32_t> concealed_{0};
+
+    // 生产者私有
+    uint32_t producer_generation_ = 0;
+    int producer_frame_duration_ms_;
+    int64_t last_arrival_us_ = 0;
+    int64_t jitter_us_ = 0;
+    int64_t interval_us_;
+    uint32_t producer_timestamp_ = 0;
+
+    // 消费者私有
+    uint32_t consumer_generation_ = 0;
+    bool playing_ = false;
+    bool compressing_ = false;
+    bool has_last_timestamp_ = false;
+    uint32_t last_timestamp_ = 0;
+
+    void SyncProducer();
+    bool IsRealtimeStream() const;
+};
+
+#endif // JITTER_BUFFER_H
@@ -0,0 +1,47 @@
+#ifndef JOB_SLOTS_H
+#define JOB_SLOTS_H
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+// 固定数量的任务槽（最多 32 个）：槽在构造时一次性分配，调度线程 Acquire 一个空槽填写后交给工作线程，
+// 工作线程用完 Release，运行期间不分配内存
+// Acquire 只在一个线程调用；Release 和 in_use() 可在任意线程调用
+template <typename T>
+class JobSlots {
+public:
+    explicit JobSlots(size_t count) : count_(count < 32 ? count : 32), slots_(new T[count_]) {}
+    JobSlots(const JobSlots&) = delete;
+    JobSlots& operator=(const JobSlots&) = delete;
+
+    // 没有空槽时返回 nullptr
+    T* Acquire() {
+        // 其他线程只会清除占用位，这里看到的空槽不会被别人占走
+        uint32_t busy = busy_.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count_; i++) {
+            if ((busy & (1u << i)) == 0) {
+                busy_.fetch_or(1u << i, std::memory_order_relaxed);
+                return &slots_[i];
+            }
+        }
+        return nullptr;
+    }
+
+    void Release(T* slot) {
+        busy_.fetch_and(~(1u << (slot - slots_.get())), std::memory_order_release);
+    }
+
+    size_t in_use() const {
+        return __builtin_popcount(busy_.load(std::memory_order_relaxed));
+    }
+    size_t count() const { return count_; }
+
+private:
+    const size_t count_;
+    std::unique_ptr<T[]> slots_;
+    std::atomic<uint32_t> busy_{0};
+};
+
+#endif // JOB_SLOTS_H
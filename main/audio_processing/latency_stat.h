@@ -0,0 +1,87 @@
+#ifndef LATENCY_STAT_H
+#define LATENCY_STAT_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstddef>
+
+// 单个阶段的延迟统计（次数、平均值、最大值，单位微秒）
+// Add 可在任意线程无锁调用；Get 与 Add 并发时三个值可能来自相邻的几次更新，只用于诊断
+class LatencyStat {
+public:
+    struct Snapshot {
+        uint32_t count = 0;
+        uint32_t mean_us = 0;
+        uint32_t max_us = 0;
+    };
+
+    void Add(uint32_t us) {
+        count_.fetch_add(1, std::memory_order_relaxed);
+        total_us_.fetch_add(us, std::memory_order_relaxed);
+        uint32_t max = max_us_.load(std::memory_order_relaxed);
+        while (us > max && !max_us_.compare_exchange_weak(max, us, std::memory_order_relaxed)) {
+        }
+    }
+
+    Snapshot Get() const {
+        Snapshot snapshot;
+        snapshot.count = count_.load(std::memory_order_relaxed);
+        // 总和按 32 位累计，一次会话内（约 70 分钟的累计延迟）不会溢出
+        snapshot.mean_us = snapshot.count > 0 ? total_us_.load(std::memory_order_relaxed) / snapshot.count : 0;
+        snapshot.max_us = max_us_.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+
+    void Reset() {
+        count_ = 0;
+        total_us_ = 0;
+        max_us_ = 0;
+    }
+
+private:
+    std::atomic<uint32_t> count_{0};
+    std::atomic<uint32_t> total_us_{0};
+    std::atomic<uint32_t> max_us_{0};
+};
+
+// 延迟分布：按 5/10/20/40/80/160ms 为上界分桶，最后一桶为 160ms 以上
+// Add 可在任意线程无锁调用
+class LatencyHistogram {
+public:
+    static constexpr int kBuckets = 7;
+
+    void Add(uint32_t us) {
+        uint32_t bound_us = 5000;
+        int bucket = 0;
+        while (bucket < kBuckets - 1 && us >= bound_us) {
+            bound_us *= 2;
+            bucket++;
+        }
+        buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint32_t bucket(int index) const { return buckets_[index].load(std::memory_order_relaxed); }
+
+    // 格式化为 "<5ms:n <10ms:n ... >=160ms:n"，返回写入的字符数
+    int Format(char* buffer, size_t size) const {
+        int length = 0;
+        uint32_t bound_ms = 5;
+        for (int i = 0; i < kBuckets && length < (int)size; i++, bound_ms *= 2) {
+            length += snprintf(buffer + length, size - length, i < kBuckets - 1 ? "%s<%ums:%u" : "%s>=%ums:%u",
+                i > 0 ? " " : "", (unsigned)(i < kBuckets - 1 ? bound_ms : bound_ms / 2), (unsigned)bucket(i));
+        }
+        return length;
+    }
+
+    void Reset() {
+        for (auto& bucket : buckets_) {
+            bucket = 0;
+        }
+    }
+
+private:
+    std::atomic<uint32_t> buckets_[kBuckets] = {};
+};
+
+#endif // LATENCY_STAT_H
@@ -0,0 +1,101 @@
+#include "nlms_audio_processor.h"
+#include "capture_frontend.h"
+#include <esp_log.h>
+#include <algorithm>
+
+#define TAG "NlmsAudioProcessor"
+
+// 每次送入 32ms（16kHz 下 512 个样本），是消除器分块长度的整数倍
+#define NLMS_FEED_SAMPLES 512
+
+void NlmsAudioProcessor::Initialize(AudioCodec* codec) {
+    codec_ = codec;
+    canceller_.Configure(16000, CONFIG_NLMS_AEC_TAIL_MS);
+    vad_.Configure(16000, CONFIG_LOCAL_VAD_HANGOVER_MS);
+    output_.reserve(NLMS_FEED_SAMPLES);
+    reference_.resize(NLMS_FEED_SAMPLES);
+    if (!codec_->input_reference()) {
+        ESP_LOGW(TAG, "Codec has no reference channel, echo cancellation disabled");
+    } else {
+        ESP_LOGI(TAG, "NLMS AEC: tail %dms (%d partitions)", CONFIG_NLMS_AEC_TAIL_MS, canceller_.partitions());
+    }
+}
+
+void NlmsAudioProcessor::Feed(const std::vector<int16_t>& data) {
+    if (!is_running_ || !output_callback_) {
+        return;
+    }
+    int channels = codec_->input_channels();
+    size_t frames = data.size() / channels;
+    // 容量足够时 resize 不分配
+    output_.resize(frames);
+    if (channels == 1) {
+        std::copy(data.begin(), data.begin() + frames, output_.begin());
+    } else {
+        CaptureDeinterleave(data.data(), frames, channels, 0, output_.data());
+    }
+
+    if (aec_enabled_ && codec_->input_reference() && channels > 1 && frames <= reference_.size() &&
+        frames % NlmsEchoCanceller::kBlockSize == 0) {
+        if (reset_pending_.exchange(false)) {
+            canceller_.Reset();
+        }
+        CaptureDeinterleave(data.data(), frames, channels, channels - 1, reference_.data());
+        canceller_.Process(output_.data(), reference_.data(), output_.data(), frames);
+    }
+
+    // 状态变化先于本块输出通知，上行门控按新状态处理这一块
+    auto event = vad_.Process(output_.data(), frames);
+    if (event != VadEndpointer::kNone && vad_state_change_callback_) {
+        vad_state_change_callback_(event == VadEndpointer::kSpeechStart);
+    }
+    // 回调只拷贝数据（写入上行 PCM 环）；万一取走了缓冲，下一次 resize 时重新分配
+    output_callback_(std::move(output_));
+}
+
+void NlmsAudioProcessor::Start() {
+    vad_.Reset();
+    is_running_ = true;
+}
+
+void NlmsAudioProcessor::Stop() {
+    if (is_running_ && aec_enabled_ && codec_->input_reference()) {
+        auto stats = canceller_.GetStats();
+        ESP_LOGI(TAG, "NLMS AEC: ERLE %ddB, adapted %u/%u blocks, foreground updates %u, background restores %u",
+            stats.erle_db, (unsigned)stats.adapted, (unsigned)stats.blocks, (unsigned)stats.updates, (unsigned)stats.restores);
+    }
+    if (is_running_) {
+        auto vad_stats = vad_.GetStats();
+        ESP_LOGI(TAG, "Local VAD: speech %u/%u frames, starts %u, ends %u, noise rms %u",
+            (unsigned)vad_stats.speech_frames, (unsigned)vad_stats.frames, (unsigned)vad_stats.starts,
+            (unsigned)vad_stats.ends, (unsigned)vad_stats.noise_rms);
+    }
+    is_running_ = false;
+}
+
+bool NlmsAudioProcessor::IsRunning() {
+    return is_running_;
+}
+
+void NlmsAudioProcessor::OnOutput(std::function<void(std::vector<int16_t>&& data)> callback) {
+    output_callback_ = callback;
+}
+
+void NlmsAudioProcessor::OnVadStateChange(std::function<void(bool speaking)> callback) {
+    vad_state_change_callback_ = callback;
+}
+
+size_t NlmsAudioProcessor::GetFeedSize() {
+    if (!codec_) {
+        return 0;
+    }
+    return NLMS_FEED_SAMPLES * codec_->input_channels();
+}
+
+void NlmsAudioProcessor::EnableDeviceAec(bool enable) {
+    // 重新启用时回声路径可能已经变化，从零开始收敛
+    if (enable && !aec_enabled_) {
+        reset_pending_ = true;
+    }
+    aec_enabled_ = enable;
+}
@@ -0,0 +1,45 @@
+#ifndef NLMS_AUDIO_PROCESSOR_H
+#define NLMS_AUDIO_PROCESSOR_H
+
+#include <atomic>
+#include <vector>
+#include <functional>
+
+#include "audio_processor.h"
+#include "audio_codec.h"
+#include "nlms_echo_canceller.h"
+#include "vad_endpointer.h"
+
+// 没有 esp-sr AFE 的芯片上的音频处理：用编解码器的参考声道做定点 NLMS 回声消除（见 NlmsEchoCanceller）
+// 输入为交织的多声道数据（最后一个声道是参考），输出为消除回声后的单声道；
+// 编解码器没有参考声道或关闭设备端 AEC 时直接输出麦克风声道。处理在调用 Feed 的线程中完成
+// 输出再经过 VadEndpointer 驱动 OnVadStateChange（上行静音抑制、LED），实时对话下残留回声不会被当作说话
+class NlmsAudioProcessor : public AudioProcessor {
+public:
+    NlmsAudioProcessor() = default;
+    ~NlmsAudioProcessor() = default;
+
+    void Initialize(AudioCodec* codec) override;
+    void Feed(const std::vector<int16_t>& data) override;
+    void Start() override;
+    void Stop() override;
+    bool IsRunning() override;
+    void OnOutput(std::function<void(std::vector<int16_t>&& data)> callback) override;
+    void OnVadStateChange(std::function<void(bool speaking)> callback) override;
+    size_t GetFeedSize() override;
+    void EnableDeviceAec(bool enable) override;
+
+private:
+    AudioCodec* codec_ = nullptr;
+    std::function<void(std::vector<int16_t>&& data)> output_callback_;
+    std::function<void(bool speaking)> vad_state_change_callback_;
+    std::atomic<bool> is_running_{false};   // 主任务写，采集循环读
+    NlmsEchoCanceller canceller_;
+    VadEndpointer vad_;
+    std::vector<int16_t> output_;       // Initialize 时按一次送入的帧数分配，Feed 中复用
+    std::vector<int16_t> reference_;
+    std::atomic<bool> aec_enabled_{true};
+    std::atomic<bool> reset_pending_{false};    // 由 EnableDeviceAec 请求，在 Feed 中执行
+};
+
+#endif // NLMS_AUDIO_PROCESSOR_H
@@ -0,0 +1,288 @@
+#include "nlms_echo_canceller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#define NLMS_WEIGHT_Q 23            // 滤波器系数的 Q 格式，回声路径增益不超过 256 倍时不会溢出
+#define NLMS_POWER_FLOOR (1 << 16)  // 功率归一化的下限，参考信号很弱时几乎不自适应
+#define NLMS_REF_ACTIVE_POWER 256   // 尾长内参考信号的平均功率低于此值（有效值 16）时不自适应
+#define NLMS_RESTORE_RATIO 8        // 后台残差功率超过前台 8 倍（9dB）时用前台系数恢复后台
+
+namespace {
+
+inline int16_t Saturate(int32_t value) {
+    return (int16_t)std::min<int32_t>(INT16_MAX, std::max<int32_t>(-INT16_MAX, value));
+}
+
+// 系数限制在 ±2^30 以内，FFT 蝶形加法不会溢出
+inline int32_t ClampWeight(int64_t value) {
+    return (int32_t)std::min<int64_t>(1 << 30, std::max<int64_t>(-(1 << 30), value));
+}
+
+// 原位基 2 复数 FFT，data 为 kFftSize 个交织的 int32 复数
+// scale：每级右移 1 位（总共除以 kFftSize），正变换用来防止增长，逆变换则得到标准的 IDFT
+void Fft(int32_t* data, const int16_t* cos_table, const int16_t* sin_table, const uint8_t* bitrev, bool inverse, bool scale) {
+    const int n = NlmsEchoCanceller::kFftSize;
+    for (int i = 0; i < n; i++) {
+        int j = bitrev[i];
+        if (j > i) {
+            std::swap(data[2 * i], data[2 * j]);
+            std::swap(data[2 * i + 1], data[2 * j + 1]);
+        }
+    }
+    for (int size = 2; size <= n; size <<= 1) {
+        int half = size >> 1;
+        int step = n / size;
+        for (int start = 0; start < n; start += size) {
+            for (int j = 0; j < half; j++) {
+                int32_t wr = cos_table[j * step];
+                int32_t wi = inverse ? sin_table[j * step] : -sin_table[j * step];
+                int32_t* a = data + 2 * (start + j);
+                int32_t* b = data + 2 * (start + j + half);
+                int32_t tr = (int32_t)(((int64_t)b[0] * wr - (int64_t)b[1] * wi) >> 15);
+                int32_t ti = (int32_t)(((int64_t)b[0] * wi + (int64_t)b[1] * wr) >> 15);
+                if (scale) {
+                    b[0] = (a[0] - tr + 1) >> 1;
+                    b[1] = (a[1] - ti + 1) >> 1;
+                    a[0] = (a[0] + tr + 1) >> 1;
+                    a[1] = (a[1] + ti + 1) >> 1;
+                } else {
+                    b[0] = a[0] - tr;
+                    b[1] = a[1] - ti;
+                    a[0] += tr;
+                    a[1] += ti;
+                }
+            }
+        }
+    }
+}
+
+// 由 0..kBlockSize 的半边频谱补出共轭对称的完整频谱
+void MirrorSpectrum(int32_t* data) {
+    const int n = NlmsEchoCanceller::kFftSize;
+    for (int k = 1; k < n / 2; k++) {
+        data[2 * (n - k)] = data[2 * k];
+        data[2 * (n - k) + 1] = -data[2 * k + 1];
+    }
+}
+
+int BitLength(uint64_t value) {
+    int bits = 0;
+    while (value != 0) {
+        value >>= 1;
+        bits++;
+    }
+    return bits;
+}
+
+} // namespace
+
+void NlmsEchoCanceller::Configure(int sample_rate, int tail_ms, int step_q15) {
+    int tail_samples = std::max(1, sample_rate * tail_ms / 1000);
+    partitions_ = (tail_samples + kBlockSize - 1) / kBlockSize;
+    step_q15_ = step_q15;
+
+    cos_.resize(kFftSize / 2);
+    sin_.resize(kFftSize / 2);
+    for (int i = 0; i < kFftSize / 2; i++) {
+        double angle = 2 * M_PI * i / kFftSize;
+        cos_[i] = (int16_t)std::lround(std::cos(angle) * 32767);
+        sin_[i] = (int16_t)std::lround(std::sin(angle) * 32767);
+    }
+    bitrev_.resize(kFftSize);
+    for (int i = 0; i < kFftSize; i++) {
+        int reversed = 0;
+        for (int bit = 1, mirror = kFftSize >> 1; bit < kFftSize; bit <<= 1, mirror >>= 1) {
+            if (i & bit) {
+                reversed |= mirror;
+            }
+        }
+        bitrev_[i] = (uint8_t)reversed;
+    }
+
+    ref_window_.assign(kFftSize, 0);
+    x_spectra_.assign((size_t)partitions_ * kBins * 2, 0);
+    weights_.assign((size_t)partitions_ * kBins * 2, 0);
+    foreground_.assign((size_t)partitions_ * kBins * 2, 0);
+    x_power_.assign(kBins, 0);
+    ref_energies_.assign(partitions_, 0);
+    fft_.assign(kFftSize * 2, 0);
+    phi_.assign(kBins * 2, 0);
+    Reset();
+}
+
+void NlmsEchoCanceller::Reset() {
+    std::fill(ref_window_.begin(), ref_window_.end(), 0);
+    std::fill(x_spectra_.begin(), x_spectra_.end(), 0);
+    std::fill(weights_.begin(), weights_.end(), 0);
+    std::fill(foreground_.begin(), foreground_.end(), 0);
+    std::fill(x_power_.begin(), x_power_.end(), 0);
+    std::fill(ref_energies_.begin(), ref_energies_.end(), 0);
+    newest_ = 0;
+    constrain_next_ = 0;
+    mic_power_ = 0;
+    error_power_ = 0;
+    output_power_ = 0;
+}
+
+void NlmsEchoCanceller::Process(const int16_t* mic, const int16_t* ref, int16_t* out, size_t samples) {
+    if (partitions_ == 0) {
+        if (out != mic) {
+            memcpy(out, mic, samples * sizeof(int16_t));
+        }
+        return;
+    }
+    for (size_t offset = 0; offset + kBlockSize <= samples; offset += kBlockSize) {
+        ProcessBlock(mic + offset, ref + offset, out + offset);
+    }
+}
+
+void NlmsEchoCanceller::EstimateEcho(const int32_t* weights, int16_t* echo) {
+    // 各分块频谱与对应延迟的参考频谱相乘后累加，逆变换后取后半块
+    for (int k = 0; k < kBins; k++) {
+        int64_t re = 0;
+        int64_t im = 0;
+        for (int p = 0; p < partitions_; p++) {
+            const int32_t* x = x_spectra_.data() + (size_t)((newest_ + partitions_ - p) % partitions_) * kBins * 2 + 2 * k;
+            const int32_t* w = weights + (size_t)p * kBins * 2 + 2 * k;
+            re += (int64_t)x[0] * w[0] - (int64_t)x[1] * w[1];
+            im += (int64_t)x[0] * w[1] + (int64_t)x[1] * w[0];
+        }
+        fft_[2 * k] = (int32_t)(re >> NLMS_WEIGHT_Q);
+        fft_[2 * k + 1] = (int32_t)(im >> NLMS_WEIGHT_Q);
+    }
+    MirrorSpectrum(fft_.data());
+    Fft(fft_.data(), cos_.data(), sin_.data(), bitrev_.data(), true, false);
+    for (int i = 0; i < kBlockSize; i++) {
+        echo[i] = Saturate(fft_[2 * (kBlockSize + i)]);
+    }
+}
+
+void NlmsEchoCanceller::ProcessBlock(const int16_t* mic, const int16_t* ref, int16_t* out) {
+    stats_.blocks++;
+
+    // 1. 参考信号窗口后移一块，做正变换存入频谱环的最新位置
+    memmove(ref_window_.data(), ref_window_.data() + kBlockSize, kBlockSize * sizeof(int16_t));
+    memcpy(ref_window_.data() + kBlockSize, ref, kBlockSize * sizeof(int16_t));
+    newest_ = (newest_ + 1) % partitions_;
+    int64_t ref_energy = 0;
+    for (int i = 0; i < kFftSize; i++) {
+        fft_[2 * i] = ref_window_[i];
+        fft_[2 * i + 1] = 0;
+        if (i >= kBlockSize) {
+            ref_energy += (int32_t)ref_window_[i] * ref_window_[i];
+        }
+    }
+    ref_energies_[newest_] = (uint32_t)(ref_energy / kBlockSize);
+    Fft(fft_.data(), cos_.data(), sin_.data(), bitrev_.data(), false, true);
+    int32_t* x_newest = x_spectra_.data() + (size_t)newest_ * kBins * 2;
+    memcpy(x_newest, fft_.data(), kBins * 2 * sizeof(int32_t));
+    for (int k = 0; k < kBins; k++) {
+        int64_t power = (int64_t)x_newest[2 * k] * x_newest[2 * k] + (int64_t)x_newest[2 * k + 1] * x_newest[2 * k + 1];
+        x_power_[k] += (power - x_power_[k]) >> 3;
+    }
+
+    // 2. 前台滤波器的残差作为输出，后台滤波器的残差用于自适应
+    int16_t echo[kBlockSize];
+    int16_t error[kBlockSize];
+    int64_t mic_energy = 0;
+    int64_t output_energy = 0;
+    int64_t error_energy = 0;
+    EstimateEcho(foreground_.data(), echo);
+    for (int i = 0; i < kBlockSize; i++) {
+        out[i] = Saturate(mic[i] - echo[i]);
+        mic_energy += (int32_t)mic[i] * mic[i];
+        output_energy += (int32_t)out[i] * out[i];
+    }
+    EstimateEcho(weights_.data(), echo);
+    for (int i = 0; i < kBlockSize; i++) {
+        error[i] = Saturate(mic[i] - echo[i]);
+        error_energy += (int32_t)error[i] * error[i];
+    }
+    mic_power_ += (mic_energy / kBlockSize - mic_power_) >> 4;
+    output_power_ += (output_energy / kBlockSize - output_power_) >> 3;
+    error_power_ += (error_energy / kBlockSize - error_power_) >> 3;
+
+    int64_t ref_power = 0;
+    for (int p = 0; p < partitions_; p++) {
+        ref_power += ref_energies_[p];
+    }
+    if (ref_power / partitions_ < NLMS_REF_ACTIVE_POWER) {
+        // 尾长内没有回声：两组滤波器的残差都只是近端信号，不做比较也不自适应
+        return;
+    }
+
+    // 3. 双路径比较：后台明显更好（收敛或跟上了回声路径的变化）时复制到前台；
+    //    后台明显更差（双讲期间被近端语音带偏）时用前台恢复后台
+    if (error_power_ * 4 < output_power_ * 3) {
+        foreground_ = weights_;
+        output_power_ = error_power_;
+        stats_.updates++;
+    } else if (error_power_ > output_power_ * NLMS_RESTORE_RATIO) {
+        weights_ = foreground_;
+        error_power_ = output_power_;
+        stats_.restores++;
+        return;
+    }
+    stats_.adapted++;
+
+    // 4. 后台残差前补零做正变换，按各频点的参考功率归一化：phi = mu * E / (P * S + delta)
+    //    归一化系数用 16 位尾数加移位表示，避免 64 位除法和溢出
+    for (int i = 0; i < kBlockSize; i++) {
+        fft_[2 * i] = 0;
+        fft_[2 * i + 1] = 0;
+        fft_[2 * (kBlockSize + i)] = error[i];
+        fft_[2 * (kBlockSize + i) + 1] = 0;
+    }
+    Fft(fft_.data(), cos_.data(), sin_.data(), bitrev_.data(), false, true);
+    int shifts[kBins];
+    for (int k = 0; k < kBins; k++) {
+        uint64_t denominator = (uint64_t)x_power_[k] * partitions_ + NLMS_POWER_FLOOR;
+        int shift = BitLength(denominator) - 16;
+        int32_t reciprocal = (int32_t)(((int64_t)step_q15_ << 16) / (int64_t)(denominator >> shift));
+        phi_[2 * k] = (int32_t)(((int64_t)fft_[2 * k] * reciprocal) >> 8);
+        phi_[2 * k + 1] = (int32_t)(((int64_t)fft_[2 * k + 1] * reciprocal) >> 8);
+        shifts[k] = 31 + shift - 8 - NLMS_WEIGHT_Q;
+    }
+
+    // 5. W += conj(X) * phi，逐分块更新
+    for (int p = 0; p < partitions_; p++) {
+        const int32_t* x = x_spectra_.data() + (size_t)((newest_ + partitions_ - p) % partitions_) * kBins * 2;
+        int32_t* w = weights_.data() + (size_t)p * kBins * 2;
+        for (int k = 0; k < kBins; k++) {
+            int64_t re = (int64_t)x[2 * k] * phi_[2 * k] + (int64_t)x[2 * k + 1] * phi_[2 * k + 1];
+            int64_t im = (int64_t)x[2 * k] * phi_[2 * k + 1] - (int64_t)x[2 * k + 1] * phi_[2 * k];
+            w[2 * k] = ClampWeight(w[2 * k] + (re >> shifts[k]));
+            w[2 * k + 1] = ClampWeight(w[2 * k + 1] + (im >> shifts[k]));
+        }
+    }
+
+    // 6. 轮流对一个分块做梯度约束：时域后半部分（循环卷积的混叠项）清零
+    Constrain(constrain_next_);
+    constrain_next_ = (constrain_next_ + 1) % partitions_;
+}
+
+void NlmsEchoCanceller::Constrain(int partition) {
+    int32_t* w = weights_.data() + (size_t)partition * kBins * 2;
+    memcpy(fft_.data(), w, kBins * 2 * sizeof(int32_t));
+    MirrorSpectrum(fft_.data());
+    Fft(fft_.data(), cos_.data(), sin_.data(), bitrev_.data(), true, true);
+    for (int i = 0; i < kFftSize; i++) {
+        if (i >= kBlockSize) {
+            fft_[2 * i] = 0;
+        }
+        fft_[2 * i + 1] = 0;
+    }
+    Fft(fft_.data(), cos_.data(), sin_.data(), bitrev_.data(), false, false);
+    memcpy(w, fft_.data(), kBins * 2 * sizeof(int32_t));
+}
+
+NlmsEchoCanceller::Stats NlmsEchoCanceller::GetStats() const {
+    Stats stats = stats_;
+    if (output_power_ > 0 && mic_power_ > 0) {
+        stats.erle_db = (int)std::lround(10 * std::log10((double)mic_power_ / output_power_));
+    }
+    return stats;
+}
@@ -0,0 +1,74 @@
+#ifndef NLMS_ECHO_CANCELLER_H
+#define NLMS_ECHO_CANCELLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 定点分块频域 NLMS 回声消除（PBFDAF，滤波器按 64 点分块，128 点 FFT 的重叠保留法）
+// - 用参考声道（扬声器回采）自适应估计回声路径，从麦克风信号中减去回声估计
+// - 全部运算为 32/64 位整数，适合没有浮点单元、跑不动 esp-sr AEC 的芯片（如 ESP32-C3）
+// - 尾长按分块数向上取整；每块只对一个分块做梯度约束（轮换），开销与无约束版本接近
+// - 双路径：后台滤波器持续自适应，前台滤波器产生输出；后台残差明显更小时复制到前台，
+//   明显更大（双讲时被近端语音带偏）时用前台恢复后台，不需要单独的双讲检测
+// 内存在 Configure 时一次性分配，Process 不分配；不加锁，由调用方串行化
+class NlmsEchoCanceller {
+public:
+    static constexpr int kBlockSize = 64;
+    static constexpr int kFftSize = 2 * kBlockSize;
+    static constexpr int kBins = kBlockSize + 1;
+
+    struct Stats {
+        uint32_t blocks = 0;
+        uint32_t adapted = 0;       // 后台做了自适应的块数
+        uint32_t updates = 0;       // 后台复制到前台的次数
+        uint32_t restores = 0;      // 用前台恢复后台的次数
+        int erle_db = 0;            // 平滑后的回声损耗增强（麦克风功率 / 输出功率）
+    };
+
+    NlmsEchoCanceller() = default;
+    NlmsEchoCanceller(const NlmsEchoCanceller&) = delete;
+    NlmsEchoCanceller& operator=(const NlmsEchoCanceller&) = delete;
+
+    // step_q15：归一化步长（Q15），默认 0.5
+    void Configure(int sample_rate, int tail_ms, int step_q15 = 16384);
+    // mic、ref、out 各 samples 个单声道样本，samples 必须是 kBlockSize 的整数倍；out 可以与 mic 相同
+    void Process(const int16_t* mic, const int16_t* ref, int16_t* out, size_t samples);
+    // 清空滤波器和历史（回声路径突变，或重新启用时）
+    void Reset();
+
+    int partitions() const { return partitions_; }
+    int tail_samples() const { return partitions_ * kBlockSize; }
+    Stats GetStats() const;
+
+private:
+    void ProcessBlock(const int16_t* mic, const int16_t* ref, int16_t* out);
+    void EstimateEcho(const int32_t* weights, int16_t* echo);
+    void Constrain(int partition);
+
+    int partitions_ = 0;
+    int step_q15_ = 16384;
+
+    // FFT 表：Q15 旋转因子和位反转序
+    std::vector<int16_t> cos_;
+    std::vector<int16_t> sin_;
+    std::vector<uint8_t> bitrev_;
+
+    std::vector<int16_t> ref_window_;   // 最近 2 块参考信号
+    std::vector<int32_t> x_spectra_;    // 最近 partitions_ 块参考信号的频谱（缩放 1/M），环形
+    std::vector<int32_t> weights_;      // 后台滤波器：各分块的频域系数（Q23）
+    std::vector<int32_t> foreground_;   // 前台滤波器，格式同上
+    std::vector<int64_t> x_power_;      // 各频点参考功率的平滑值
+    std::vector<uint32_t> ref_energies_;    // 各块参考信号的平均功率，环形，与 x_spectra_ 对齐
+    std::vector<int32_t> fft_;          // FFT 工作区（复数交织）
+    std::vector<int32_t> phi_;          // 各频点的归一化误差
+    int newest_ = 0;                    // x_spectra_ 中最新一块的位置
+    int constrain_next_ = 0;
+
+    int64_t mic_power_ = 0;             // 平滑的麦克风、前台输出、后台残差功率（每样本）
+    int64_t output_power_ = 0;
+    int64_t error_power_ = 0;
+    Stats stats_;
+};
+
+#endif // NLMS_ECHO_CANCELLER_H
@@ -5,21 +5,43 @@
 
 void NoAudioProcessor::Initialize(AudioCodec* codec) {
     codec_ = codec;
+#if CONFIG_USE_LOCAL_VAD
+    vad_.Configure(16000, CONFIG_LOCAL_VAD_HANGOVER_MS);
+#endif
 }
 
 void NoAudioProcessor::Feed(const std::vector<int16_t>& data) {
     if (!is_running_ || !output_callback_) {
         return;
     }
+#if CONFIG_USE_LOCAL_VAD
+    // 本地 VAD 只看麦克风声道；状态变化先于本块输出通知，上行门控按新状态处理这一块
+    int channels = codec_->input_channels();
+    auto event = vad_.Process(data.data(), data.size() / channels, channels, 0);
+    if (event != VadEndpointer::kNone && vad_state_change_callback_) {
+        vad_state_change_callback_(event == VadEndpointer::kSpeechStart);
+    }
+#endif
     // 直接将输入数据传递给输出回调
     output_callback_(std::vector<int16_t>(data));
 }
 
 void NoAudioProcessor::Start() {
+#if CONFIG_USE_LOCAL_VAD
+    vad_.Reset();
+#endif
     is_running_ = true;
 }
 
 void NoAudioProcessor::Stop() {
+#if CONFIG_USE_LOCAL_VAD
+    if (is_running_) {
+        auto stats = vad_.GetStats();
+        ESP_LOGI(TAG, "Local VAD: speech %u/%u frames, starts %u, ends %u, noise rms %u",
+            (unsigned)stats.speech_frames, (unsigned)stats.frames, (unsigned)stats.starts, (unsigned)stats.ends,
+            (unsigned)stats.noise_rms);
+    }
+#endif
     is_running_ = false;
 }
 
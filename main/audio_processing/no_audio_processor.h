@@ -6,6 +6,9 @@
 
 #include "audio_processor.h"
 #include "audio_codec.h"
+#if CONFIG_USE_LOCAL_VAD
+#include "vad_endpointer.h"
+#endif
 
 class NoAudioProcessor : public AudioProcessor {
 public:
@@ -27,6 +30,9 @@ private:
     std::function<void(std::vector<int16_t>&& data)> output_callback_;
     std::function<void(bool speaking)> vad_state_change_callback_;
     bool is_running_ = false;
+#if CONFIG_USE_LOCAL_VAD
+    VadEndpointer vad_;
+#endif
 };
 
 #endif 
\ No newline at end of file
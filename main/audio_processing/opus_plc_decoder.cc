@@ -0,0 +1,69 @@
+#include "opus_plc_decoder.h"
+
+#include <opus.h>
+#include <esp_log.h>
+
+#define TAG "OpusPlcDecoder"
+
+OpusPlcDecoder::OpusPlcDecoder(int sample_rate, int channels, int duration_ms)
+    : frame_size_(sample_rate / 1000 * duration_ms),
+      channels_(channels),
+      sample_rate_(sample_rate),
+      duration_ms_(duration_ms) {
+    int error;
+    audio_dec_ = opus_decoder_create(sample_rate, channels, &error);
+    if (audio_dec_ == nullptr) {
+        ESP_LOGE(TAG, "Failed to create audio decoder, error code: %d", error);
+    }
+}
+
+OpusPlcDecoder::~OpusPlcDecoder() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (audio_dec_ != nullptr) {
+        opus_decoder_destroy(audio_dec_);
+    }
+}
+
+int OpusPlcDecoder::Decode(const uint8_t* data, size_t size, int16_t* pcm, size_t max_samples) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 正常解码允许包时长小于缓冲区容量
+    return DecodeLocked(data, size, 0, pcm, (int)(max_samples / channels_));
+}
+
+int OpusPlcDecoder::DecodeFec(const uint8_t* next_data, size_t next_size, int16_t* pcm, size_t max_samples) {
+    if (max_samples < (size_t)frame_samples()) {
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    // PLC 和 FEC 的 frame_size 决定恢复的时长，必须等于丢失帧的时长
+    return DecodeLocked(next_data, next_size, 1, pcm, frame_size_);
+}
+
+int OpusPlcDecoder::Conceal(int16_t* pcm, size_t max_samples) {
+    if (max_samples < (size_t)frame_samples()) {
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    return DecodeLocked(nullptr, 0, 0, pcm, frame_size_);
+}
+
+int OpusPlcDecoder::DecodeLocked(const uint8_t* data, size_t size, int decode_fec, int16_t* pcm, int frame_size) {
+    if (audio_dec_ == nullptr) {
+        ESP_LOGE(TAG, "Audio decoder is not configured");
+        return -1;
+    }
+
+    int ret = opus_decode(audio_dec_, data, (opus_int32)size, pcm, frame_size, decode_fec);
+    if (ret < 0) {
+        ESP_LOGE(TAG, "Failed to decode audio, error code: %d", ret);
+        return -1;
+    }
+    return ret * channels_;
+}
+
+void OpusPlcDecoder::ResetState() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (audio_dec_ != nullptr) {
+        opus_decoder_ctl(audio_dec_, OPUS_RESET_STATE);
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef OPUS_PLC_DECODER_H
+#define OPUS_PLC_DECODER_H
+
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+struct OpusDecoder;
+
+// 下行 Opus 解码器，在普通解码之外提供丢包补偿（PLC）和带内 FEC 恢复
+// OpusDecoderWrapper 不暴露底层 OpusDecoder，无法调用 PLC/FEC，因此直接基于 libopus 实现
+// 所有解码接口都把 PCM 写入调用方提供的缓冲区（容量 max_samples 个样本），返回写入的样本数，失败返回 -1
+class OpusPlcDecoder {
+public:
+    OpusPlcDecoder(int sample_rate, int channels, int duration_ms = 60);
+    ~OpusPlcDecoder();
+
+    // 正常解码一个 Opus 包
+    int Decode(const uint8_t* data, size_t size, int16_t* pcm, size_t max_samples);
+    // 用下一个包中的带内 FEC（LBRR）恢复紧邻其前的丢失帧；包内没有 FEC 时 libopus 自动退化为 PLC
+    int DecodeFec(const uint8_t* next_data, size_t next_size, int16_t* pcm, size_t max_samples);
+    // 没有任何后续数据时，生成一帧丢包补偿
+    int Conceal(int16_t* pcm, size_t max_samples);
+    void ResetState();
+
+    inline int sample_rate() const {
+        return sample_rate_;
+    }
+
+    inline int duration_ms() const {
+        return duration_ms_;
+    }
+
+    // 一帧的样本数（所有声道）
+    inline int frame_samples() const {
+        return frame_size_ * channels_;
+    }
+
+private:
+    std::mutex mutex_;
+    OpusDecoder* audio_dec_ = nullptr;
+    int frame_size_;    // 每声道样本数
+    int channels_;
+    int sample_rate_;
+    int duration_ms_;
+
+    int DecodeLocked(const uint8_t* data, size_t size, int decode_fec, int16_t* pcm, int frame_size);
+};
+
+#endif // OPUS_PLC_DECODER_H
@@ -0,0 +1,101 @@
+#include "opus_uplink_encoder.h"
+
+#include <opus.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#define TAG "OpusUplinkEncoder"
+
+// 单个 Opus 包的上限，与 OpusEncoderWrapper 一致
+#define MAX_OPUS_PACKET_SIZE 1000
+
+OpusUplinkEncoder::OpusUplinkEncoder(int sample_rate, int channels, int duration_ms)
+    : frame_size_(sample_rate / 1000 * duration_ms),
+      channels_(channels),
+      sample_rate_(sample_rate),
+      duration_ms_(duration_ms) {
+    int error;
+    audio_enc_ = opus_encoder_create(sample_rate, channels, OPUS_APPLICATION_VOIP, &error);
+    if (audio_enc_ == nullptr) {
+        ESP_LOGE(TAG, "Failed to create audio encoder, error code: %d", error);
+        return;
+    }
+    // 输入最多积压不足一帧的样本再加一个采集块，按两帧预留
+    in_buffer_.reserve((size_t)frame_size_ * channels_ * 2);
+    out_buffer_.resize(MAX_OPUS_PACKET_SIZE);
+    // 与 OpusEncoderWrapper 相同的默认值
+    SetDtx(true);
+    SetComplexity(0);
+}
+
+OpusUplinkEncoder::~OpusUplinkEncoder() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (audio_enc_ != nullptr) {
+        opus_encoder_destroy(audio_enc_);
+    }
+}
+
+void OpusUplinkEncoder::Encode(const int16_t* pcm, size_t samples, const std::function<void(const uint8_t* opus, size_t size)>& handler) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (audio_enc_ == nullptr) {
+        ESP_LOGE(TAG, "Audio encoder is not configured");
+        return;
+    }
+
+    in_buffer_.insert(in_buffer_.end(), pcm, pcm + samples);
+
+    size_t frame_samples = (size_t)frame_size_ * channels_;
+    size_t offset = 0;
+    while (in_buffer_.size() - offset >= frame_samples) {
+        int64_t start = esp_timer_get_time();
+        auto ret = opus_encode(audio_enc_, in_buffer_.data() + offset, frame_size_, out_buffer_.data(), out_buffer_.size());
+        last_encode_us_ = (uint32_t)(esp_timer_get_time() - start);
+        if (ret < 0) {
+            ESP_LOGE(TAG, "Failed to encode audio, error code: %d", ret);
+            in_buffer_.clear();
+            return;
+        }
+        offset += frame_samples;
+        if (handler != nullptr) {
+            handler(out_buffer_.data(), ret);
+        }
+    }
+    in_buffer_.erase(in_buffer_.begin(), in_buffer_.begin() + offset);
+}
+
+void OpusUplinkEncoder::ResetState() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (audio_enc_ != nullptr) {
+        opus_encoder_ctl(audio_enc_, OPUS_RESET_STATE);
+    }
+    in_buffer_.clear();
+}
+
+void OpusUplinkEncoder::SetComplexity(int complexity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (audio_enc_ != nullptr) {
+        opus_encoder_ctl(audio_enc_, OPUS_SET_COMPLEXITY(complexity));
+    }
+}
+
+void OpusUplinkEncoder::SetBitrate(int bitrate) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (audio_enc_ != nullptr) {
+        opus_encoder_ctl(audio_enc_, OPUS_SET_BITRATE(bitrate > 0 ? bitrate : OPUS_AUTO));
+    }
+}
+
+void OpusUplinkEncoder::SetVbr(bool vbr, bool constrained) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (audio_enc_ != nullptr) {
+        opus_encoder_ctl(audio_enc_, OPUS_SET_VBR(vbr ? 1 : 0));
+        opus_encoder_ctl(audio_enc_, OPUS_SET_VBR_CONSTRAINT(constrained ? 1 : 0));
+    }
+}
+
+void OpusUplinkEncoder::SetDtx(bool enable) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (audio_enc_ != nullptr) {
+        opus_encoder_ctl(audio_enc_, OPUS_SET_DTX(enable ? 1 : 0));
+    }
+}
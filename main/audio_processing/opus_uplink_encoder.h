@@ -0,0 +1,56 @@
+#ifndef OPUS_UPLINK_ENCODER_H
+#define OPUS_UPLINK_ENCODER_H
+
+#include <functional>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct OpusEncoder;
+
+// 上行 Opus 编码器，接口与 OpusEncoderWrapper 相同（输入攒够一帧就编码并回调），
+// 另外可以在运行时调整码率、VBR 和 DTX，并记录每帧的编码耗时，供 EncoderController 使用
+// OpusEncoderWrapper 只暴露复杂度和 DTX，因此直接基于 libopus 实现
+// 输入缓冲和输出缓冲长期持有，指针版本的 Encode 在稳态下不分配
+class OpusUplinkEncoder {
+public:
+    OpusUplinkEncoder(int sample_rate, int channels, int duration_ms = 60);
+    ~OpusUplinkEncoder();
+
+    // handler 在编码锁内、编码线程上对每个输出包调用一次，opus 指向编码器内部缓冲，只在回调内有效
+    void Encode(const int16_t* pcm, size_t samples, const std::function<void(const uint8_t* opus, size_t size)>& handler);
+    void ResetState();
+
+    void SetComplexity(int complexity);
+    // bitrate <= 0 时交给 libopus 自动选择
+    void SetBitrate(int bitrate);
+    void SetVbr(bool vbr, bool constrained);
+    void SetDtx(bool enable);
+
+    inline int sample_rate() const {
+        return sample_rate_;
+    }
+
+    inline int duration_ms() const {
+        return duration_ms_;
+    }
+
+    // 最近一帧的编码耗时（微秒），在 handler 中读取
+    inline uint32_t last_encode_us() const {
+        return last_encode_us_;
+    }
+
+private:
+    std::mutex mutex_;
+    OpusEncoder* audio_enc_ = nullptr;
+    int frame_size_;    // 每声道样本数
+    int channels_;
+    int sample_rate_;
+    int duration_ms_;
+    std::vector<int16_t> in_buffer_;
+    std::vector<uint8_t> out_buffer_;
+    uint32_t last_encode_us_ = 0;
+};
+
+#endif // OPUS_UPLINK_ENCODER_H
@@ -0,0 +1,109 @@
+#include "packet_ring.h"
+
+#include <cstring>
+
+// 包序号允许 uint32_t 回绕，用差值的符号判断先后
+static inline bool SequenceBefore(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) < 0;
+}
+
+PacketRing::PacketRing(size_t max_packets, size_t slab_size)
+    : max_packets_(max_packets),
+      slab_size_(slab_size),
+      descriptors_(new Descriptor[max_packets]),
+      slab_(new uint8_t[slab_size]) {
+}
+
+bool PacketRing::Push(const uint8_t* data, size_t size, uint32_t timestamp, uint32_t trace_id) {
+    if (size == 0 || size > slab_size_) {
+        return false;
+    }
+
+    uint32_t write = write_.load(std::memory_order_relaxed);
+    uint32_t release = release_.load(std::memory_order_acquire);
+    if (write - release >= max_packets_) {
+        return false;
+    }
+
+    // 在 slab 中找一段连续空间：[head, tail) 为仍被占用的载荷
+    size_t offset;
+    if (write == release) {
+        // 队列为空，从头开始写，保证最大的连续空间
+        offset = 0;
+    } else {
+        size_t head = descriptors_[release % max_packets_].offset;
+        size_t tail = write_offset_;
+        if (tail > head) {
+            if (slab_size_ - tail >= size) {
+                offset = tail;
+            } else if (head >= size) {
+                offset = 0;
+            } else {
+                return false;
+            }
+        } else if (tail < head) {
+            if (head - tail >= size) {
+                offset = tail;
+            } else {
+                return false;
+            }
+        } else {
+            // tail == head 且队列非空：slab 已写满
+            return false;
+        }
+    }
+
+    memcpy(slab_.get() + offset, data, size);
+    descriptors_[write % max_packets_] = Descriptor{(uint32_t)offset, (uint32_t)size, timestamp, trace_id};
+    write_offset_ = offset + size;
+    write_.store(write + 1, std::memory_order_release);
+    return true;
+}
+
+bool PacketRing::Acquire(Packet& packet) {
+    uint32_t acquire = acquire_.load(std::memory_order_relaxed);
+    uint32_t clear_to = clear_to_.load(std::memory_order_acquire);
+    if (SequenceBefore(acquire, clear_to)) {
+        // 有 Clear 请求：等在途的包全部归还后再整体跳过，避免覆盖正在被读取的载荷
+        if (release_.load(std::memory_order_acquire) != acquire) {
+            return false;
+        }
+        acquire = clear_to;
+        acquire_.store(acquire, std::memory_order_release);
+        release_.store(acquire, std::memory_order_release);
+    }
+
+    if (acquire == write_.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    const auto& descriptor = descriptors_[acquire % max_packets_];
+    packet.data = slab_.get() + descriptor.offset;
+    packet.size = descriptor.size;
+    packet.timestamp = descriptor.timestamp;
+    packet.trace_id = descriptor.trace_id;
+    acquire_.store(acquire + 1, std::memory_order_release);
+    return true;
+}
+
+void PacketRing::Release() {
+    release_.fetch_add(1, std::memory_order_release);
+}
+
+void PacketRing::Clear() {
+    uint32_t target = write_.load(std::memory_order_acquire);
+    uint32_t current = clear_to_.load(std::memory_order_relaxed);
+    while (SequenceBefore(current, target) &&
+           !clear_to_.compare_exchange_weak(current, target, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+    }
+}
+
+size_t PacketRing::Size() const {
+    uint32_t write = write_.load(std::memory_order_acquire);
+    uint32_t start = acquire_.load(std::memory_order_acquire);
+    uint32_t clear_to = clear_to_.load(std::memory_order_acquire);
+    if (SequenceBefore(start, clear_to)) {
+        start = clear_to;
+    }
+    return SequenceBefore(start, write) ? write - start : 0;
+}
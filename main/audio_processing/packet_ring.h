@@ -0,0 +1,67 @@
+#ifndef PACKET_RING_H
+#define PACKET_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// 单生产者/单消费者无锁环形队列，用于存放变长音频包（如下行 Opus 帧）
+// - 包描述符和载荷内存（slab）在构造时一次性分配，运行期间 Push/Acquire 不再触发堆分配
+// - 生产者线程调用 Push；消费者线程调用 Acquire，Release 按 Acquire 的顺序归还载荷内存
+// - Clear 可在任意线程调用：丢弃调用时刻之前写入的所有包，在消费者下一次 Acquire 时生效
+class PacketRing {
+public:
+    struct Packet {
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        uint32_t timestamp = 0;  // 随包保存的时间戳（毫秒），由生产者填写
+        uint32_t trace_id = 0;   // 延迟追踪 ID（见 AudioTrace），由生产者填写
+    };
+
+    PacketRing(size_t max_packets, size_t slab_size);
+    PacketRing(const PacketRing&) = delete;
+    PacketRing& operator=(const PacketRing&) = delete;
+
+    // 生产者：拷贝一个包到 slab，空间不足时返回 false（不阻塞）
+    bool Push(const uint8_t* data, size_t size, uint32_t timestamp = 0, uint32_t trace_id = 0);
+
+    // 消费者：取出下一个包，返回的指针在对应的 Release 之前一直有效
+    bool Acquire(Packet& packet);
+    // 归还最早一个已 Acquire 的包，可以在 Acquire 以外的线程调用，但必须保持顺序
+    void Release();
+
+    void Clear();
+
+    // 尚未被消费者取走的包数
+    size_t Size() const;
+    bool Empty() const { return Size() == 0; }
+    // 已被取走但尚未 Release 的包数
+    size_t InFlight() const { return acquire_.load(std::memory_order_acquire) - release_.load(std::memory_order_acquire); }
+    size_t max_packets() const { return max_packets_; }
+    size_t slab_size() const { return slab_size_; }
+
+private:
+    struct Descriptor {
+        uint32_t offset;
+        uint32_t size;
+        uint32_t timestamp;
+        uint32_t trace_id;
+    };
+
+    const size_t max_packets_;
+    const size_t slab_size_;
+    std::unique_ptr<Descriptor[]> descriptors_;
+    std::unique_ptr<uint8_t[]> slab_;
+
+    // 生产者私有：下一个包在 slab 中的写入位置
+    size_t write_offset_ = 0;
+
+    // 以下均为单调递增的包序号，取模 max_packets_ 得到槽位
+    std::atomic<uint32_t> write_{0};     // 生产者已写入
+    std::atomic<uint32_t> acquire_{0};   // 消费者已取走
+    std::atomic<uint32_t> release_{0};   // 载荷内存已归还
+    std::atomic<uint32_t> clear_to_{0};  // Clear 请求：丢弃该序号之前的包
+};
+
+#endif // PACKET_RING_H
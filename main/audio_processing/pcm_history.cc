@@ -0,0 +1,47 @@
+#include "pcm_history.h"
+
+#include <algorithm>
+#include <cstring>
+
+void PcmHistory::Configure(int sample_rate, int duration_ms) {
+    capacity_ = (size_t)sample_rate * duration_ms / 1000;
+    buffer_.reset(capacity_ > 0 ? new int16_t[capacity_] : nullptr);
+    Clear();
+}
+
+void PcmHistory::Write(const int16_t* data, size_t samples) {
+    if (capacity_ == 0) {
+        return;
+    }
+    // 超过容量时只有最后 capacity_ 个样本会留下
+    if (samples > capacity_) {
+        data += samples - capacity_;
+        samples = capacity_;
+    }
+    size_t head = std::min(samples, capacity_ - write_);
+    memcpy(buffer_.get() + write_, data, head * sizeof(int16_t));
+    memcpy(buffer_.get(), data + head, (samples - head) * sizeof(int16_t));
+    write_ = (write_ + samples) % capacity_;
+    size_ = std::min(size_ + samples, capacity_);
+}
+
+void PcmHistory::Clear() {
+    write_ = 0;
+    size_ = 0;
+}
+
+PcmHistory::Snapshot PcmHistory::GetSnapshot() const {
+    Snapshot snapshot;
+    if (size_ == 0) {
+        return snapshot;
+    }
+    // 最旧的样本位于 write_ 之前 size_ 个位置
+    size_t start = (write_ + capacity_ - size_) % capacity_;
+    if (start + size_ <= capacity_) {
+        snapshot.first = Span{buffer_.get() + start, size_};
+    } else {
+        snapshot.first = Span{buffer_.get() + start, capacity_ - start};
+        snapshot.second = Span{buffer_.get(), size_ - (capacity_ - start)};
+    }
+    return snapshot;
+}
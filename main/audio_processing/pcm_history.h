@@ -0,0 +1,45 @@
+#ifndef PCM_HISTORY_H
+#define PCM_HISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// 最近一段 PCM 的环形缓冲：容量在 Configure 时按采样率和时长一次性分配，写满后覆盖最旧的样本，
+// 运行期间 Write 不分配
+// GetSnapshot 返回按时间顺序的最多两段连续内存（环回绕处分开），调用方直接读取，不拷贝；
+// 快照在下一次 Write/Clear 之前有效。不加锁，读写需由调用方串行化
+class PcmHistory {
+public:
+    struct Span {
+        const int16_t* data = nullptr;
+        size_t samples = 0;
+    };
+
+    struct Snapshot {
+        Span first;     // 较早的一段
+        Span second;    // 较新的一段，没有回绕时为空
+        size_t samples() const { return first.samples + second.samples; }
+    };
+
+    PcmHistory() = default;
+    PcmHistory(const PcmHistory&) = delete;
+    PcmHistory& operator=(const PcmHistory&) = delete;
+
+    // 重新分配容量并清空
+    void Configure(int sample_rate, int duration_ms);
+    void Write(const int16_t* data, size_t samples);
+    void Clear();
+    Snapshot GetSnapshot() const;
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+
+private:
+    std::unique_ptr<int16_t[]> buffer_;
+    size_t capacity_ = 0;
+    size_t write_ = 0;  // 下一个样本的写入位置
+    size_t size_ = 0;
+};
+
+#endif // PCM_HISTORY_H
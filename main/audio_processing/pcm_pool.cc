@@ -0,0 +1,86 @@
+#include "pcm_pool.h"
+
+#include <chrono>
+
+PcmPool::Block& PcmPool::Block::operator=(Block&& other) noexcept {
+    if (this != &other) {
+        reset();
+        pool_ = other.pool_;
+        data_ = other.data_;
+        size_ = other.size_;
+        capacity_ = other.capacity_;
+        trace_id_ = other.trace_id_;
+        timestamp_ = other.timestamp_;
+        other.pool_ = nullptr;
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.capacity_ = 0;
+        other.trace_id_ = 0;
+        other.timestamp_ = 0;
+    }
+    return *this;
+}
+
+void PcmPool::Block::reset() {
+    if (pool_ != nullptr && data_ != nullptr) {
+        pool_->Return(data_);
+    }
+    pool_ = nullptr;
+    data_ = nullptr;
+    size_ = 0;
+    capacity_ = 0;
+    trace_id_ = 0;
+    timestamp_ = 0;
+}
+
+PcmPool::PcmPool(size_t block_count, size_t block_samples)
+    : block_count_(block_count),
+      block_samples_(block_samples),
+      storage_(new int16_t[block_count * block_samples]) {
+    free_blocks_.reserve(block_count);
+    for (size_t i = 0; i < block_count; i++) {
+        free_blocks_.push_back(storage_.get() + i * block_samples);
+    }
+}
+
+PcmPool::Block PcmPool::Acquire(int timeout_ms) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (free_blocks_.empty()) {
+        exhausted_++;
+        if (timeout_ms <= 0 || !condition_variable_.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                [this]() { return !free_blocks_.empty(); })) {
+            timeouts_++;
+            return Block();
+        }
+    }
+
+    Block block;
+    block.pool_ = this;
+    block.data_ = free_blocks_.back();
+    block.capacity_ = block_samples_;
+    free_blocks_.pop_back();
+    size_t in_use = block_count_ - free_blocks_.size();
+    if (in_use > high_water_) {
+        high_water_ = in_use;
+    }
+    return block;
+}
+
+void PcmPool::Return(int16_t* data) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_blocks_.push_back(data);
+    }
+    condition_variable_.notify_one();
+}
+
+PcmPool::Stats PcmPool::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats;
+    stats.blocks = block_count_;
+    stats.in_use = block_count_ - free_blocks_.size();
+    stats.high_water = high_water_;
+    stats.exhausted = exhausted_;
+    stats.timeouts = timeouts_;
+    return stats;
+}
@@ -0,0 +1,82 @@
+#ifndef PCM_POOL_H
+#define PCM_POOL_H
+
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// 固定大小的 PCM 缓冲块池：块内存在构造时一次性分配，运行期间不再触发堆分配，避免长时间对话造成堆碎片
+// Block 是只能移动的 RAII 句柄，析构（或 reset）时自动把块归还到池中
+class PcmPool {
+public:
+    class Block {
+    public:
+        Block() = default;
+        ~Block() { reset(); }
+        Block(Block&& other) noexcept { *this = std::move(other); }
+        Block& operator=(Block&& other) noexcept;
+        Block(const Block&) = delete;
+        Block& operator=(const Block&) = delete;
+
+        int16_t* data() { return data_; }
+        const int16_t* data() const { return data_; }
+        size_t size() const { return size_; }
+        size_t capacity() const { return capacity_; }
+        bool empty() const { return size_ == 0; }
+        explicit operator bool() const { return data_ != nullptr; }
+        // 只能在容量范围内调整有效样本数
+        void resize(size_t samples) { size_ = samples <= capacity_ ? samples : capacity_; }
+        void reset();
+        // 随块传递的延迟追踪 ID（见 AudioTrace），不影响块的归还
+        uint32_t trace_id() const { return trace_id_; }
+        void set_trace_id(uint32_t trace_id) { trace_id_ = trace_id; }
+        // 本帧对应的下行时间戳（服务器毫秒时间戳，本地提示音为 0），用于服务端 AEC 对齐参考信号
+        uint32_t timestamp() const { return timestamp_; }
+        void set_timestamp(uint32_t timestamp) { timestamp_ = timestamp; }
+
+    private:
+        friend class PcmPool;
+        PcmPool* pool_ = nullptr;
+        int16_t* data_ = nullptr;
+        size_t size_ = 0;
+        size_t capacity_ = 0;
+        uint32_t trace_id_ = 0;
+        uint32_t timestamp_ = 0;
+    };
+
+    struct Stats {
+        size_t blocks = 0;
+        size_t in_use = 0;
+        size_t high_water = 0;    // 同时借出块数的峰值
+        uint32_t exhausted = 0;   // 借用时池已空的次数
+        uint32_t timeouts = 0;    // 等待后仍然借不到块的次数
+    };
+
+    PcmPool(size_t block_count, size_t block_samples);
+    PcmPool(const PcmPool&) = delete;
+    PcmPool& operator=(const PcmPool&) = delete;
+
+    // 借出一个块；池空时最多等待 timeout_ms，仍借不到则返回无效块
+    Block Acquire(int timeout_ms = 0);
+
+    size_t block_samples() const { return block_samples_; }
+    Stats GetStats();
+
+private:
+    const size_t block_count_;
+    const size_t block_samples_;
+    std::unique_ptr<int16_t[]> storage_;
+    std::vector<int16_t*> free_blocks_;
+    std::mutex mutex_;
+    std::condition_variable condition_variable_;
+    size_t high_water_ = 0;
+    uint32_t exhausted_ = 0;
+    uint32_t timeouts_ = 0;
+
+    void Return(int16_t* data);
+};
+
+#endif // PCM_POOL_H
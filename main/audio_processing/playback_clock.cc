@@ -0,0 +1,67 @@
+#include "playback_clock.h"
+
+void PlaybackClock::OnFrameWritten(uint32_t timestamp, size_t samples, size_t pending_samples, int sample_rate, uint32_t now_us) {
+    if (sample_rate <= 0 || samples == 0) {
+        return;
+    }
+    uint32_t duration_us = (uint32_t)((uint64_t)samples * 1000000 / sample_rate);
+    uint32_t measured_end = now_us + (uint32_t)((uint64_t)pending_samples * 1000000 / sample_rate);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t start = measured_end - duration_us;
+    uint32_t end = measured_end;
+    int32_t error = has_end_ ? (int32_t)(measured_end - (end_us_ + duration_us)) : 0;
+    // 连续播放时本帧紧接上一帧，只按偏差做小幅修正：调度延迟只会让写入晚返回，测量值偏早时更可信，
+    // 因此偏早时修正一半，偏晚时只修正 1/16，估计贴近测量值的下沿；I2S 时钟相对系统定时器的漂移
+    // 表现为持续的同向偏差，会被逐步跟上
+    if (has_end_ && error > -(int32_t)(2 * duration_us) && error < (int32_t)(2 * duration_us)) {
+        start = end_us_;
+        end = end_us_ + duration_us + (error < 0 ? error / 2 : error / 16);
+    } else {
+        stats_.resyncs++;
+    }
+    has_end_ = true;
+    end_us_ = end;
+    stats_.frames++;
+    stats_.last_correction_us = error;
+
+    // 连续播放的帧首尾相接，修正量计入本帧时长，查询时不会落进帧间空隙
+    entries_[head_] = Entry{timestamp, start, end - start};
+    head_ = (head_ + 1) % PLAYBACK_CLOCK_ENTRIES;
+    if (count_ < PLAYBACK_CLOCK_ENTRIES) {
+        count_++;
+    }
+}
+
+uint32_t PlaybackClock::Lookup(uint32_t time_us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 从最新的一帧往前找；上行查询的时刻通常只比最新帧早几帧
+    for (size_t i = 1; i <= count_; i++) {
+        const Entry& entry = entries_[(head_ + PLAYBACK_CLOCK_ENTRIES - i) % PLAYBACK_CLOCK_ENTRIES];
+        int32_t offset = (int32_t)(time_us - entry.start_us);
+        if (offset < 0) {
+            continue;
+        }
+        if ((uint32_t)offset >= entry.duration_us || entry.timestamp == 0) {
+            // 落在最新帧之后（已播完）、帧之间的空隙，或本地提示音
+            break;
+        }
+        stats_.hits++;
+        return entry.timestamp + ((uint32_t)offset + 500) / 1000;
+    }
+    stats_.misses++;
+    return 0;
+}
+
+void PlaybackClock::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    head_ = 0;
+    count_ = 0;
+    has_end_ = false;
+    stats_ = Stats();
+}
+
+PlaybackClock::Stats PlaybackClock::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
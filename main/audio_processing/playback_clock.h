@@ -0,0 +1,50 @@
+#ifndef PLAYBACK_CLOCK_H
+#define PLAYBACK_CLOCK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#define PLAYBACK_CLOCK_ENTRIES 32   // 记录最近若干帧的播放时间，60ms 帧约 2 秒
+
+// 下行播放时钟：记录每个已输出帧实际从扬声器放出的时间，供服务端 AEC 为上行帧找到对应的回声参考
+// - 播放方在 OutputData 返回后调用 OnFrameWritten，传入此刻尚未放出的样本数（本帧在最后），
+//   由此推算本帧的放音区间；连续播放时以上一帧的结束时间为基准做小幅修正，吸收写入返回时间的抖动，
+//   并跟随 I2S 时钟与系统定时器之间的漂移；偏差过大（新的流或欠载）时重新对齐
+// - 上行在编码后调用 Lookup，按采集时间查出当时正在放出的下行时间戳（已加上帧内偏移）
+// - 只保留最近 PLAYBACK_CLOCK_ENTRIES 帧，超出的自动覆盖；时间均为 esp_timer 微秒（32 位回绕）
+// 两端在不同任务中调用，内部加锁，临界区只有几次整数运算
+class PlaybackClock {
+public:
+    struct Stats {
+        uint32_t frames = 0;    // 记录的帧数
+        uint32_t resyncs = 0;   // 重新对齐次数
+        uint32_t hits = 0;      // Lookup 找到参考帧的次数
+        uint32_t misses = 0;    // 查询时刻没有下行在播放（或是本地提示音）
+        int32_t last_correction_us = 0;  // 最近一帧平滑前的估计偏差
+    };
+
+    // samples: 本帧样本数；pending_samples: 写入返回时尚未放出的样本数（本帧位于末尾，已包含在内）
+    void OnFrameWritten(uint32_t timestamp, size_t samples, size_t pending_samples, int sample_rate, uint32_t now_us);
+    // 返回 time_us 时刻正在放出的下行时间戳（毫秒），没有时返回 0
+    uint32_t Lookup(uint32_t time_us);
+    void Clear();
+    Stats GetStats();
+
+private:
+    struct Entry {
+        uint32_t timestamp;
+        uint32_t start_us;
+        uint32_t duration_us;
+    };
+
+    std::mutex mutex_;
+    Entry entries_[PLAYBACK_CLOCK_ENTRIES] = {};
+    size_t head_ = 0;   // 下一条记录的位置
+    size_t count_ = 0;
+    bool has_end_ = false;
+    uint32_t end_us_ = 0;   // 上一帧的放音结束时间
+    Stats stats_;
+};
+
+#endif // PLAYBACK_CLOCK_H
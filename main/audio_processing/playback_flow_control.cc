@@ -0,0 +1,58 @@
+#include "playback_flow_control.h"
+
+#include <algorithm>
+
+PlaybackFlowControl::PlaybackFlowControl(int max_in_flight, int max_queue, int high_watermark, int low_watermark)
+    : max_in_flight_(max_in_flight),
+      base_max_queue_(max_queue),
+      base_high_watermark_(high_watermark),
+      base_low_watermark_(low_watermark),
+      max_queue_(max_queue),
+      high_watermark_(high_watermark),
+      low_watermark_(low_watermark) {
+}
+
+bool PlaybackFlowControl::Admit(size_t queued, int in_flight) {
+    if (queued > queue_high_water_.load(std::memory_order_relaxed)) {
+        queue_high_water_.store(queued, std::memory_order_relaxed);
+    }
+
+    int max_queue = max_queue_.load(std::memory_order_relaxed);
+    bool backpressure = backpressure_.load(std::memory_order_relaxed);
+    if (!backpressure && (int)queued >= high_watermark_.load(std::memory_order_relaxed)) {
+        backpressure = true;
+        backpressure_events_.fetch_add(1, std::memory_order_relaxed);
+    } else if (backpressure && (int)queued <= low_watermark_.load(std::memory_order_relaxed)) {
+        backpressure = false;
+    }
+    backpressure_.store(backpressure, std::memory_order_relaxed);
+
+    // 背压生效时让 Opus 帧先积压在解码队列（内存小），不再调度新的解码
+    // 在途帧最终都会进入播放队列：两者之和不超过播放队列硬上限
+    if (backpressure || in_flight >= max_in_flight_ || (int)queued + in_flight >= max_queue) {
+        throttled_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void PlaybackFlowControl::SetFrameDuration(int frame_duration_ms, int base_frame_duration_ms, int max_queue_frames) {
+    int max_queue = std::min(base_max_queue_ * base_frame_duration_ms / frame_duration_ms, max_queue_frames);
+    int high_watermark = std::min(base_high_watermark_ * base_frame_duration_ms / frame_duration_ms, max_queue - 1);
+    int low_watermark = std::min(base_low_watermark_ * base_frame_duration_ms / frame_duration_ms, high_watermark - 1);
+    max_queue_.store(max_queue, std::memory_order_relaxed);
+    high_watermark_.store(high_watermark, std::memory_order_relaxed);
+    low_watermark_.store(std::max(low_watermark, 0), std::memory_order_relaxed);
+}
+
+void PlaybackFlowControl::Reset() {
+    backpressure_.store(false, std::memory_order_relaxed);
+}
+
+PlaybackFlowControl::Stats PlaybackFlowControl::GetStats() const {
+    Stats stats;
+    stats.backpressure_events = backpressure_events_.load(std::memory_order_relaxed);
+    stats.throttled = throttled_.load(std::memory_order_relaxed);
+    stats.queue_high_water = queue_high_water_.load(std::memory_order_relaxed);
+    return stats;
+}
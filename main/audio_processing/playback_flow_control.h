@@ -0,0 +1,46 @@
+#ifndef PLAYBACK_FLOW_CONTROL_H
+#define PLAYBACK_FLOW_CONTROL_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// 下行解码调度的准入控制：根据播放队列长度和在途解码帧数决定是否再调度一帧
+// - 播放队列达到高水位时进入背压，回落到低水位才解除（滞回，避免频繁切换）
+// - 在途帧数不超过并发上限，且在途帧与播放队列之和不超过播放队列硬上限
+// Admit 只在调度线程调用；backpressure() 和 GetStats() 可在任意线程读取
+// 不依赖 FreeRTOS，主机模拟器（scripts/audio_sim）与设备使用同一份策略
+class PlaybackFlowControl {
+public:
+    struct Stats {
+        uint32_t backpressure_events = 0;   // 进入背压的次数
+        uint32_t throttled = 0;             // 因背压或上限被拒绝的调度次数
+        size_t queue_high_water = 0;        // 观察到的播放队列最大长度
+    };
+
+    PlaybackFlowControl(int max_in_flight, int max_queue, int high_watermark, int low_watermark);
+
+    // queued 为播放队列当前长度，in_flight 为已调度但尚未完成的解码帧数
+    bool Admit(size_t queued, int in_flight);
+    // 构造参数按 base_frame_duration_ms 的帧计；帧时长变化时换算成相同时长的帧数，
+    // 队列上限不超过 max_queue_frames（通常由 PCM 块数决定），水位依次至少小一帧
+    void SetFrameDuration(int frame_duration_ms, int base_frame_duration_ms, int max_queue_frames);
+    bool backpressure() const { return backpressure_.load(std::memory_order_relaxed); }
+    void Reset();
+    Stats GetStats() const;
+
+private:
+    const int max_in_flight_;
+    const int base_max_queue_;
+    const int base_high_watermark_;
+    const int base_low_watermark_;
+    std::atomic<int> max_queue_;
+    std::atomic<int> high_watermark_;
+    std::atomic<int> low_watermark_;
+    std::atomic<bool> backpressure_{false};
+    std::atomic<uint32_t> backpressure_events_{0};
+    std::atomic<uint32_t> throttled_{0};
+    std::atomic<size_t> queue_high_water_{0};
+};
+
+#endif // PLAYBACK_FLOW_CONTROL_H
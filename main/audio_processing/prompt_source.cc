@@ -0,0 +1,181 @@
+#include "prompt_source.h"
+
+#include <cstring>
+
+// BinaryProtocol3 头部：type(1) + reserved(1) + payload_size(2，网络字节序)
+static constexpr size_t kP3HeaderSize = 4;
+
+// 预解码资源头部（小端）：magic(4) + format(1) + channels(1) + block_samples(2) + sample_rate(4) + total_samples(4)
+static constexpr size_t kPcmHeaderSize = 16;
+static constexpr uint8_t kPcmFormatPcm16 = 1;
+static constexpr uint8_t kPcmFormatAdpcm = 2;
+// IMA-ADPCM 块头：predictor(2) + step_index(1) + reserved(1)
+static constexpr size_t kAdpcmBlockHeaderSize = 4;
+
+static const int8_t kImaIndexTable[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8,
+};
+
+static const int16_t kImaStepTable[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+    11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+    32767,
+};
+
+static inline uint16_t ReadLe16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t ReadLe32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+bool PromptSource::Start(const std::string_view& sound) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sound_ = sound;
+    offset_ = 0;
+    format_ = kFormatOpus;
+    sample_rate_ = 0;
+    block_samples_ = 0;
+
+    // P3 包的首字节是 type(0)，不会与预解码资源的 magic 冲突
+    if (sound.size() < 4 || memcmp(sound.data(), "PCMP", 4) != 0) {
+        return true;
+    }
+
+    auto header = reinterpret_cast<const uint8_t*>(sound.data());
+    if (sound.size() < kPcmHeaderSize || header[5] != 1 || ReadLe16(header + 6) == 0 ||
+            (header[4] != kPcmFormatPcm16 && header[4] != kPcmFormatAdpcm)) {
+        Finish();
+        return false;
+    }
+    format_ = header[4] == kPcmFormatPcm16 ? kFormatPcm16 : kFormatAdpcm;
+    block_samples_ = ReadLe16(header + 6);
+    sample_rate_ = (int)ReadLe32(header + 8);
+    offset_ = kPcmHeaderSize;
+    return true;
+}
+
+bool PromptSource::Next(Chunk& chunk) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (format_ == kFormatOpus) {
+        return NextOpus(chunk);
+    }
+
+    size_t block_size = format_ == kFormatPcm16 ? block_samples_ * sizeof(int16_t)
+        : kAdpcmBlockHeaderSize + block_samples_ / 2;
+    size_t remaining = offset_ < sound_.size() ? sound_.size() - offset_ : 0;
+    size_t size = remaining < block_size ? remaining : block_size;
+    // 最后一块可以不满，但至少要有一个样本
+    size_t min_size = format_ == kFormatPcm16 ? sizeof(int16_t) : kAdpcmBlockHeaderSize + 1;
+    if (size < min_size) {
+        Finish();
+        return false;
+    }
+    chunk.format = format_;
+    chunk.data = reinterpret_cast<const uint8_t*>(sound_.data()) + offset_;
+    chunk.size = size;
+    offset_ += size;
+    return true;
+}
+
+bool PromptSource::NextOpus(Chunk& chunk) {
+    while (offset_ + kP3HeaderSize <= sound_.size()) {
+        auto header = reinterpret_cast<const uint8_t*>(sound_.data()) + offset_;
+        size_t payload_size = (size_t(header[2]) << 8) | header[3];
+        if (offset_ + kP3HeaderSize + payload_size > sound_.size()) {
+            break;
+        }
+        offset_ += kP3HeaderSize + payload_size;
+        if (payload_size == 0) {
+            continue;
+        }
+        chunk.format = kFormatOpus;
+        chunk.data = header + kP3HeaderSize;
+        chunk.size = payload_size;
+        return true;
+    }
+    Finish();
+    return false;
+}
+
+void PromptSource::Stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Finish();
+}
+
+void PromptSource::Finish() {
+    sound_ = std::string_view();
+    offset_ = 0;
+}
+
+bool PromptSource::Active() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !sound_.empty();
+}
+
+PromptSource::Format PromptSource::format() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return format_;
+}
+
+int PromptSource::sample_rate() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sample_rate_;
+}
+
+size_t PromptSource::block_samples() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return block_samples_;
+}
+
+int PromptSource::DecodePcm(const Chunk& chunk, int16_t* pcm, size_t max_samples) {
+    if (chunk.format == kFormatPcm16) {
+        size_t samples = chunk.size / sizeof(int16_t);
+        if (samples > max_samples) {
+            return -1;
+        }
+        // flash 中的数据不保证 2 字节对齐，逐字节组装
+        for (size_t i = 0; i < samples; i++) {
+            pcm[i] = (int16_t)ReadLe16(chunk.data + i * 2);
+        }
+        return (int)samples;
+    }
+
+    if (chunk.format != kFormatAdpcm || chunk.size <= kAdpcmBlockHeaderSize) {
+        return -1;
+    }
+    size_t samples = (chunk.size - kAdpcmBlockHeaderSize) * 2;
+    if (samples > max_samples) {
+        return -1;
+    }
+
+    // 每块自带预测值和步长索引，可以独立解码
+    int predictor = (int16_t)ReadLe16(chunk.data);
+    int index = chunk.data[2];
+    if (index > 88) {
+        return -1;
+    }
+    const uint8_t* codes = chunk.data + kAdpcmBlockHeaderSize;
+    for (size_t i = 0; i < samples; i++) {
+        int code = (i & 1) ? (codes[i / 2] >> 4) : (codes[i / 2] & 0x0F);
+        int step = kImaStepTable[index];
+        int delta = step >> 3;
+        if (code & 4) delta += step;
+        if (code & 2) delta += step >> 1;
+        if (code & 1) delta += step >> 2;
+        predictor += (code & 8) ? -delta : delta;
+        if (predictor > 32767) predictor = 32767;
+        else if (predictor < -32768) predictor = -32768;
+        index += kImaIndexTable[code];
+        if (index < 0) index = 0;
+        else if (index > 88) index = 88;
+        pcm[i] = (int16_t)predictor;
+    }
+    return (int)samples;
+}
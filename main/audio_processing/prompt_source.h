@@ -0,0 +1,58 @@
+#ifndef PROMPT_SOURCE_H
+#define PROMPT_SOURCE_H
+
+#include <mutex>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+// 内置提示音的零拷贝数据源：直接引用映射在 flash 中的数据
+// - Start 只记录提示音的 string_view，不拷贝也不分配
+// - Next 依次返回每个块在 flash 中的指针，解码器直接从 flash 读取
+// 提示音数据嵌入在固件中，生命周期覆盖整个运行期，返回的指针始终有效
+//
+// 支持两种资源格式：
+// - P3：BinaryProtocol3 包序列，每包一帧 Opus
+// - 预解码（scripts/gen_prompt_pcm.py 生成）："PCMP" 头 + PCM16 或 IMA-ADPCM 块，播放时无需 Opus 解码
+class PromptSource {
+public:
+    enum Format {
+        kFormatOpus,
+        kFormatPcm16,
+        kFormatAdpcm,
+    };
+
+    struct Chunk {
+        Format format = kFormatOpus;
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+    };
+
+    // 开始播放一段提示音，替换尚未播放完的提示音；预解码资源头部无效时返回 false
+    bool Start(const std::string_view& sound);
+    // 取下一块；播放完毕或数据损坏时返回 false 并结束播放
+    bool Next(Chunk& chunk);
+    void Stop();
+    bool Active();
+
+    // 当前提示音的格式信息，Opus 资源的 sample_rate/block_samples 为 0
+    Format format();
+    int sample_rate();
+    size_t block_samples();
+
+    // 把一个预解码块展开成 PCM16，返回样本数，失败返回 -1；无状态，可在任意线程调用
+    static int DecodePcm(const Chunk& chunk, int16_t* pcm, size_t max_samples);
+
+private:
+    std::mutex mutex_;
+    std::string_view sound_;
+    size_t offset_ = 0;
+    Format format_ = kFormatOpus;
+    int sample_rate_ = 0;
+    size_t block_samples_ = 0;
+
+    bool NextOpus(Chunk& chunk);
+    void Finish();
+};
+
+#endif // PROMPT_SOURCE_H
@@ -0,0 +1,87 @@
+#include "uplink_gate.h"
+
+void UplinkGate::Configure(Mode mode, int hangover_ms, int keepalive_ms) {
+    mode_ = mode;
+    hangover_ms_ = hangover_ms;
+    keepalive_ms_ = keepalive_ms;
+    Reset();
+}
+
+void UplinkGate::Reset() {
+    open_ms_ = hangover_ms_;
+    since_marker_ms_ = 0;
+    dtx_since_marker_ms_ = 0;
+    idle_ = false;
+    captured_ms_ = 0;
+    suppressed_ms_ = 0;
+    dtx_dropped_ = 0;
+    markers_ = 0;
+}
+
+UplinkGate::Action UplinkGate::OnCapture(bool speaking, int duration_ms) {
+    captured_ms_ += duration_ms;
+    if (mode_ != kModeVad) {
+        return kPass;
+    }
+
+    if (speaking || open_ms_ > 0) {
+        // 说话中，或说话结束后的拖尾
+        open_ms_ = speaking ? hangover_ms_ : open_ms_ - duration_ms;
+        return idle_.exchange(false) ? kResume : kPass;
+    }
+
+    suppressed_ms_ += duration_ms;
+    if (!idle_.exchange(true)) {
+        since_marker_ms_ = duration_ms;
+        return kEnterSilence;
+    }
+    since_marker_ms_ += duration_ms;
+    if (keepalive_ms_ > 0 && since_marker_ms_ >= keepalive_ms_) {
+        since_marker_ms_ = 0;
+        markers_++;
+        return kMarker;
+    }
+    return kSuppress;
+}
+
+UplinkGate::Action UplinkGate::OnEncoded(size_t packet_size, int frame_duration_ms) {
+    // libopus 约定：DTX 打开时静音帧的输出不超过 2 字节，不需要传输
+    if (mode_ != kModeDtx || packet_size > 2) {
+        idle_ = false;
+        return kPass;
+    }
+    if (!idle_.exchange(true)) {
+        dtx_since_marker_ms_ = frame_duration_ms;
+        dtx_dropped_++;
+        return kEnterSilence;
+    }
+    dtx_since_marker_ms_ += frame_duration_ms;
+    if (keepalive_ms_ > 0 && dtx_since_marker_ms_ >= keepalive_ms_) {
+        dtx_since_marker_ms_ = 0;
+        markers_++;
+        return kMarker;
+    }
+    dtx_dropped_++;
+    return kSuppress;
+}
+
+UplinkGate::Stats UplinkGate::GetStats() const {
+    Stats stats;
+    stats.captured_ms = captured_ms_;
+    stats.suppressed_ms = suppressed_ms_;
+    stats.dtx_dropped = dtx_dropped_;
+    stats.markers = markers_;
+    return stats;
+}
+
+uint8_t UplinkGate::DtxMarker(int frame_duration_ms) {
+    // TOC = config << 3 | stereo << 2 | code，SILK 宽带的 config 8~11 对应 10/20/40/60ms
+    int config;
+    switch (frame_duration_ms) {
+        case 10: config = 8; break;
+        case 20: config = 9; break;
+        case 40: config = 10; break;
+        default: config = 11; break;
+    }
+    return (uint8_t)(config << 3);
+}
@@ -0,0 +1,76 @@
+#ifndef UPLINK_GATE_H
+#define UPLINK_GATE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// 上行静音抑制：监听期间没人说话时不编码、不发送（或只发极小的舒适噪声标记）
+// - kModeVad：按本地 VAD 门控采集段。说话结束后再发送 hangover_ms 防止截掉词尾；
+//   静音期间不编码，每 keepalive_ms 发一个只有 TOC 的 Opus DTX 包作为舒适噪声标记（0 表示不发）；
+//   重新开始说话时返回 kResume，调用方先补发保留的 lookback 音频，避免截掉词首
+// - kModeDtx：没有本地 VAD 时使用编码器自身的 DTX，丢弃 DTX 输出的 1~2 字节包，
+//   每 keepalive_ms 保留一个作为标记
+// - kModeOff：全部发送（原先的行为）
+// 标记包是标准的 Opus DTX 帧，服务端按丢帧解码得到舒适噪声；依赖连续音频做 VAD 的服务端
+// 可以把 keepalive_ms 设为一帧时长
+// OnCapture 和 OnEncoded 都在编码任务中调用，idle() 和统计可以在任意线程读取
+class UplinkGate {
+public:
+    enum Mode {
+        kModeOff = 0,
+        kModeDtx,
+        kModeVad,
+    };
+
+    enum Action {
+        kPass,          // 编码并发送
+        kResume,        // 从静音恢复：先补发 lookback，再编码并发送
+        kEnterSilence,  // 刚进入静音：不发送，调用方应让传输层立即发出攒着的尾帧
+        kSuppress,      // 不编码（或丢弃编码结果）、不发送
+        kMarker,        // 发送一个舒适噪声标记
+    };
+
+    struct Stats {
+        uint32_t captured_ms = 0;
+        uint32_t suppressed_ms = 0;     // VAD 门控下未编码的时长
+        uint32_t dtx_dropped = 0;       // DTX 模式下丢弃的编码帧数
+        uint32_t markers = 0;
+    };
+
+    void Configure(Mode mode, int hangover_ms, int keepalive_ms);
+    // 新的监听会话：清零统计，门控从打开状态开始（VAD 尚未判定前不截音）
+    void Reset();
+
+    // 一段时长为 duration_ms 的处理后音频是否需要编码
+    Action OnCapture(bool speaking, int duration_ms);
+    // 一个编码后的包是否需要发送（kPass/kEnterSilence/kSuppress/kMarker，kMarker 时发送该包本身）
+    Action OnEncoded(size_t packet_size, int frame_duration_ms);
+
+    Mode mode() const { return mode_; }
+    // 当前处于静音抑制中（任意线程）
+    bool idle() const { return idle_.load(std::memory_order_relaxed); }
+    Stats GetStats() const;
+
+    // 只有 TOC 字节的 Opus 包（SILK 宽带、单声道、一帧），解码端视为 DTX/丢帧并生成舒适噪声
+    static uint8_t DtxMarker(int frame_duration_ms);
+
+private:
+    Mode mode_ = kModeOff;
+    int hangover_ms_ = 0;
+    int keepalive_ms_ = 0;
+
+    // 编码任务私有
+    int open_ms_ = 0;
+    int since_marker_ms_ = 0;
+    int dtx_since_marker_ms_ = 0;
+
+    std::atomic<bool> idle_{false};
+
+    std::atomic<uint32_t> captured_ms_{0};
+    std::atomic<uint32_t> suppressed_ms_{0};
+    std::atomic<uint32_t> dtx_dropped_{0};
+    std::atomic<uint32_t> markers_{0};
+};
+
+#endif // UPLINK_GATE_H
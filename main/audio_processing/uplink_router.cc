@@ -0,0 +1,36 @@
+#include "uplink_router.h"
+
+void UplinkRouter::Configure(UplinkGate::Mode mode, int hangover_ms, int keepalive_ms, int lookback_ms, int max_chunk_ms) {
+    gate_.Configure(mode, hangover_ms, keepalive_ms);
+    lookback_samples_ = lookback_ms * 16;
+    lookback_.clear();
+    lookback_.reserve(lookback_samples_ + max_chunk_ms * 16);
+    resumed_ = false;
+}
+
+void UplinkRouter::Reset() {
+    gate_.Reset();
+    lookback_.clear();
+    resumed_ = false;
+}
+
+UplinkGate::Action UplinkRouter::OnCapture(bool speaking, const int16_t* pcm, size_t samples) {
+    if (resumed_) {
+        // 上一块已经补发了 lookback
+        lookback_.clear();
+        resumed_ = false;
+    }
+    auto action = gate_.OnCapture(speaking, (int)(samples / 16));
+    if (action == UplinkGate::kPass) {
+        lookback_.clear();
+    } else if (action == UplinkGate::kResume) {
+        resumed_ = true;
+    } else {
+        // 静音抑制：不编码，只保留最近 lookback_ms 的音频
+        lookback_.insert(lookback_.end(), pcm, pcm + samples);
+        if (lookback_.size() > lookback_samples_) {
+            lookback_.erase(lookback_.begin(), lookback_.end() - lookback_samples_);
+        }
+    }
+    return action;
+}
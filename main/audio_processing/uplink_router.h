@@ -0,0 +1,39 @@
+#ifndef UPLINK_ROUTER_H
+#define UPLINK_ROUTER_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "uplink_gate.h"
+
+// 编码任务中 16kHz 采集块的静音抑制路由：UplinkGate 决定采集块是否编码，
+// 不编码的块只保留最近 lookback_ms 的音频；恢复说话（kResume）时调用方先重置编码器、
+// 补发 lookback()，再编码本块
+// OnCapture 只在编码任务调用，gate() 的 idle() 和统计可以在任意线程读取
+// 不依赖 FreeRTOS，主机模拟器（scripts/audio_sim）与设备使用同一份路由
+class UplinkRouter {
+public:
+    // max_chunk_ms 为单个采集块的最长时长，用于预留 lookback 的容量
+    void Configure(UplinkGate::Mode mode, int hangover_ms, int keepalive_ms, int lookback_ms, int max_chunk_ms);
+    // 新的监听会话：清零统计，丢弃保留的音频
+    void Reset();
+
+    // 一个采集块的去向：
+    // kPass/kResume 编码本块（kResume 先补发 lookback()），kMarker 发送 UplinkGate::DtxMarker，
+    // kEnterSilence 让传输层立即发出攒着的尾帧，kSuppress 无需处理
+    UplinkGate::Action OnCapture(bool speaking, const int16_t* pcm, size_t samples);
+    // kResume 时需要补发的音频，到下一次 OnCapture 之前有效
+    const std::vector<int16_t>& lookback() const { return lookback_; }
+
+    UplinkGate& gate() { return gate_; }
+    const UplinkGate& gate() const { return gate_; }
+
+private:
+    UplinkGate gate_;
+    size_t lookback_samples_ = 0;
+    std::vector<int16_t> lookback_;
+    bool resumed_ = false;
+};
+
+#endif // UPLINK_ROUTER_H
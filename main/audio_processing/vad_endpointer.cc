@@ -0,0 +1,155 @@
+#include "vad_endpointer.h"
+
+#include <algorithm>
+#include <iterator>
+
+#define VAD_FRAME_MS 10
+#define VAD_STRONG_RATIO 8              // 功率高于底噪 9dB：直接判为语音
+#define VAD_WEAK_RATIO 3                // 高于底噪 4.8dB：再看过零数
+#define VAD_MIN_VOICED_CROSSINGS 3      // 每 10ms 帧的过零数，约 150Hz
+#define VAD_MAX_VOICED_CROSSINGS 56     // 约 2.8kHz，再高是嘶声或清辅音
+#define VAD_MIN_NOISE_POWER 64          // 底噪下限（均方根 8），也决定了安静环境下的绝对门限
+#define VAD_WINDOW_FRAMES 16            // 最小值统计的子窗口长度（160ms），共 kMinWindows 个
+#define VAD_WARMUP_FRAMES 10            // Configure 后先学习 100ms 底噪
+
+void VadEndpointer::Configure(int sample_rate, int hangover_ms, int onset_ms) {
+    frame_samples_ = sample_rate * VAD_FRAME_MS / 1000;
+    onset_frames_ = std::max(1, onset_ms / VAD_FRAME_MS);
+    hangover_frames_ = std::max(1, hangover_ms / VAD_FRAME_MS);
+    noise_floor_ = VAD_MIN_NOISE_POWER;
+    std::fill(std::begin(window_min_), std::end(window_min_), UINT32_MAX);
+    current_min_ = UINT32_MAX;
+    window_frames_ = 0;
+    window_index_ = 0;
+    warmup_frames_ = 0;
+    Reset();
+}
+
+void VadEndpointer::Reset() {
+    filled_ = 0;
+    energy_ = 0;
+    crossings_ = 0;
+    last_sample_ = 0;
+    dc_q8_ = 0;
+    speaking_ = false;
+    voiced_run_ = 0;
+    silence_run_ = 0;
+    stats_ = Stats();
+}
+
+VadEndpointer::Event VadEndpointer::Process(const int16_t* samples, size_t count) {
+    return Process(samples, count, 1, 0);
+}
+
+VadEndpointer::Event VadEndpointer::Process(const int16_t* data, size_t frames, int channels, int channel) {
+    Event result = kNone;
+    for (size_t i = 0; i < frames; i++) {
+        // 一阶高通去掉直流偏置，否则偏置会吃掉过零
+        int32_t x = (int32_t)data[i * channels + channel] << 8;
+        dc_q8_ += (x - dc_q8_) >> 6;
+        int32_t sample = (x - dc_q8_) >> 8;
+        energy_ += (int64_t)sample * sample;
+        if ((sample < 0) != (last_sample_ < 0)) {
+            crossings_++;
+        }
+        last_sample_ = (int16_t)std::max(-32768, std::min(32767, (int)sample));
+        if (++filled_ == frame_samples_) {
+            Event event = ProcessFrame();
+            if (event != kNone) {
+                result = event;
+            }
+        }
+    }
+    return result;
+}
+
+VadEndpointer::Event VadEndpointer::ProcessFrame() {
+    uint32_t power = (uint32_t)std::min<uint64_t>(energy_ / frame_samples_, UINT32_MAX);
+    int crossings = crossings_;
+    filled_ = 0;
+    energy_ = 0;
+    crossings_ = 0;
+
+    bool speech = warmup_frames_ >= VAD_WARMUP_FRAMES && IsSpeechFrame(power, crossings);
+    UpdateNoiseFloor(power);
+    stats_.frames++;
+    if (speech) {
+        stats_.speech_frames++;
+    }
+
+    if (!speaking_) {
+        // 开始说话需要足够的浊音帧：突然变大的宽带噪声（风扇、水声）功率高但过零数高，不会触发
+        bool voiced = speech && crossings >= VAD_MIN_VOICED_CROSSINGS && crossings <= VAD_MAX_VOICED_CROSSINGS;
+        voiced_run_ = speech ? voiced_run_ + (voiced ? 1 : 0) : 0;
+        if (voiced_run_ >= onset_frames_) {
+            speaking_ = true;
+            silence_run_ = 0;
+            stats_.starts++;
+            return kSpeechStart;
+        }
+    } else {
+        silence_run_ = speech ? 0 : silence_run_ + 1;
+        if (silence_run_ >= hangover_frames_) {
+            speaking_ = false;
+            voiced_run_ = 0;
+            stats_.ends++;
+            return kSpeechEnd;
+        }
+    }
+    return kNone;
+}
+
+bool VadEndpointer::IsSpeechFrame(uint32_t power, int crossings) const {
+    uint64_t floor = noise_floor_;
+    if (power > floor * VAD_STRONG_RATIO) {
+        return true;
+    }
+    if (power <= floor * VAD_WEAK_RATIO) {
+        return false;
+    }
+    // 略高于底噪：浊音的过零数在中间；过零很少是低频嗡声或碰撞，很多是嘶声，
+    // 但说话过程中的高过零帧多半是清辅音，算作语音以免提前判定结束
+    if (crossings < VAD_MIN_VOICED_CROSSINGS) {
+        return false;
+    }
+    return crossings <= VAD_MAX_VOICED_CROSSINGS || speaking_;
+}
+
+void VadEndpointer::UpdateNoiseFloor(uint32_t power) {
+    current_min_ = std::min(current_min_, power);
+    if (++window_frames_ == VAD_WINDOW_FRAMES) {
+        window_min_[window_index_] = current_min_;
+        window_index_ = (window_index_ + 1) % kMinWindows;
+        current_min_ = UINT32_MAX;
+        window_frames_ = 0;
+    }
+    uint32_t minimum = current_min_;
+    for (uint32_t value : window_min_) {
+        minimum = std::min(minimum, value);
+    }
+    // 短帧功率的最小值比平均底噪低，乘 1.5 补偿
+    uint32_t target = minimum + minimum / 2;
+    if (warmup_frames_ < VAD_WARMUP_FRAMES) {
+        warmup_frames_++;
+        noise_floor_ = target;
+    } else if (target < noise_floor_) {
+        noise_floor_ -= (noise_floor_ - target) >> 2;
+    } else {
+        noise_floor_ += (target - noise_floor_) >> 3;
+    }
+    noise_floor_ = std::max<uint32_t>(noise_floor_, VAD_MIN_NOISE_POWER);
+}
+
+VadEndpointer::Stats VadEndpointer::GetStats() const {
+    Stats stats = stats_;
+    // 整数平方根
+    uint32_t root = 0;
+    for (uint32_t bit = 1u << 15; bit > 0; bit >>= 1) {
+        uint32_t candidate = root | bit;
+        if ((uint64_t)candidate * candidate <= noise_floor_) {
+            root = candidate;
+        }
+    }
+    stats.noise_rms = root;
+    return stats;
+}
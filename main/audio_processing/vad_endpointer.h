@@ -0,0 +1,73 @@
+#ifndef VAD_ENDPOINTER_H
+#define VAD_ENDPOINTER_H
+
+#include <cstddef>
+#include <cstdint>
+
+// 本地定点 VAD 和端点检测：没有 esp-sr AFE 的芯片上代替服务端的说话结束判定
+// - 按 10ms 帧计算平均功率和过零数；底噪取最近约 1 秒内帧功率的最小值（最小值统计）再平滑，
+//   说话时音节和词之间的间隙会落到底噪附近，所以说话本身不会把底噪抬高，噪声变大时 1 秒内跟上
+// - 功率明显高于底噪即为语音帧；只略高于底噪时再看过零数：低频嗡声和嘶声不算，
+//   说话过程中的清辅音（过零数高）算，避免截掉词尾
+// - 连续的语音帧中累计 onset_ms 的浊音帧判定开始说话，开始后连续 hangover_ms 没有语音帧判定说话结束
+// 全部为整数运算，不分配内存；不加锁，由调用方串行化
+class VadEndpointer {
+public:
+    enum Event {
+        kNone,
+        kSpeechStart,
+        kSpeechEnd,
+    };
+
+    struct Stats {
+        uint32_t frames = 0;
+        uint32_t speech_frames = 0;     // 判为语音的帧数
+        uint32_t starts = 0;
+        uint32_t ends = 0;
+        uint32_t noise_rms = 0;         // 当前底噪的均方根（样本值）
+    };
+
+    // sample_rate 为单声道采样率，hangover_ms 为判定说话结束所需的静音时长
+    void Configure(int sample_rate, int hangover_ms, int onset_ms = 30);
+    // 新的监听会话：回到未说话状态并清零统计；底噪保留，环境通常没有变化
+    void Reset();
+
+    // 送入任意长度的单声道样本（不足一帧的部分留到下一次），返回本次最后一个状态变化
+    Event Process(const int16_t* samples, size_t count);
+    // 交织的多声道数据，只取 channel 声道
+    Event Process(const int16_t* data, size_t frames, int channels, int channel);
+
+    bool speaking() const { return speaking_; }
+    int frame_samples() const { return frame_samples_; }
+    Stats GetStats() const;
+
+private:
+    Event ProcessFrame();
+    bool IsSpeechFrame(uint32_t power, int crossings) const;
+    void UpdateNoiseFloor(uint32_t power);
+
+    int frame_samples_ = 160;
+    int onset_frames_ = 3;
+    int hangover_frames_ = 50;
+
+    // 当前帧的累加量
+    int filled_ = 0;
+    uint64_t energy_ = 0;
+    int crossings_ = 0;
+    int16_t last_sample_ = 0;
+    int32_t dc_q8_ = 0;                 // 直流偏置（Q8）
+
+    static constexpr int kMinWindows = 6;
+    uint32_t noise_floor_ = 0;          // 底噪功率（每样本）
+    uint32_t window_min_[kMinWindows] = {};  // 最近几个子窗口内帧功率的最小值，环形
+    uint32_t current_min_ = 0;          // 当前子窗口的最小值
+    int window_frames_ = 0;             // 当前子窗口已有的帧数
+    int window_index_ = 0;
+    int warmup_frames_ = 0;             // Configure 后的底噪学习帧数，学习期内不判定开始说话
+    bool speaking_ = false;
+    int voiced_run_ = 0;                // 未说话时，连续语音帧中的浊音帧数
+    int silence_run_ = 0;
+    Stats stats_;
+};
+
+#endif // VAD_ENDPOINTER_H
@@ -1,12 +1,14 @@
 #include "background_task.h"
 
+#include <algorithm>
+
 #include <esp_log.h>
 #include <esp_task_wdt.h>
 
 #define TAG "BackgroundTask"
 
 BackgroundTask::BackgroundTask(uint32_t stack_size, int thread_count, int priority)
-    : thread_count_(thread_count) {
+    : background_tasks_(kMaxTasks), thread_count_(thread_count) {
     background_task_handles_.resize(thread_count_);
 
     ESP_LOGI(TAG, "🔧 Creating %d BackgroundTask threads with priority %d", thread_count_, priority);
@@ -39,10 +41,10 @@ void BackgroundTask::Schedule(std::function<void()> callback) {
     std::unique_lock<std::mutex> lock(mutex_);
 
     // 🔴 流控机制：当任务堆积过多时，阻塞等待直到队列有空间
-    if (active_tasks_ >= 80) {
+    if (active_tasks_ >= kMaxTasks) {
         ESP_LOGW(TAG, "⏳ BackgroundTask queue FULL (%u tasks), waiting for space...", active_tasks_.load());
         condition_variable_.wait(lock, [this]() {
-            return active_tasks_ < 80;
+            return active_tasks_ < kMaxTasks;
         });
         ESP_LOGI(TAG, "✅ BackgroundTask queue has space, resuming task creation");
     }
@@ -54,50 +56,62 @@ void BackgroundTask::Schedule(std::function<void()> callback) {
         }
     }
 
+    // 排队的任务数不超过 active_tasks_，环形队列不会溢出
     active_tasks_++;
-    background_tasks_.emplace_back([this, cb = std::move(callback)]() {
-        cb();
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            active_tasks_--;
-            // 🔴 任务完成时通知等待的线程
-            condition_variable_.notify_all();
-        }
-    });
+    background_tasks_[(queue_head_ + queue_size_) % kMaxTasks] = std::move(callback);
+    queue_size_++;
     condition_variable_.notify_all();
 }
 
 void BackgroundTask::WaitForCompletion() {
     std::unique_lock<std::mutex> lock(mutex_);
     condition_variable_.wait(lock, [this]() {
-        return background_tasks_.empty() && active_tasks_ == 0;
+        return queue_size_ == 0 && active_tasks_ == 0;
     });
 }
 
+uint32_t BackgroundTask::GetStackHighWaterMark() {
+    uint32_t minimum = UINT32_MAX;
+    for (auto handle : background_task_handles_) {
+        if (handle != nullptr) {
+            minimum = std::min<uint32_t>(minimum, uxTaskGetStackHighWaterMark(handle));
+        }
+    }
+    return minimum;
+}
+
 void BackgroundTask::BackgroundTaskLoop(int worker_id) {
     ESP_LOGI(TAG, "🔧 BackgroundTask worker %d started, priority=%d", worker_id, uxTaskPriorityGet(NULL));
 
     while (!stop_flag_.load()) {
         std::unique_lock<std::mutex> lock(mutex_);
         condition_variable_.wait(lock, [this]() {
-            return !background_tasks_.empty() || stop_flag_.load();
+            return queue_size_ > 0 || stop_flag_.load();
         });
 
         if (stop_flag_.load()) {
             break;
         }
 
-        if (background_tasks_.empty()) {
+        if (queue_size_ == 0) {
             continue;
         }
 
         // 每个工作线程取一个任务执行
-        auto task = std::move(background_tasks_.front());
-        background_tasks_.pop_front();
+        auto task = std::move(background_tasks_[queue_head_]);
+        background_tasks_[queue_head_] = nullptr;
+        queue_head_ = (queue_head_ + 1) % kMaxTasks;
+        queue_size_--;
         lock.unlock();
 
         // 执行任务
         task();
+        task = nullptr;
+
+        lock.lock();
+        active_tasks_--;
+        // 🔴 任务完成时通知等待的线程
+        condition_variable_.notify_all();
     }
 
     ESP_LOGI(TAG, "🔧 BackgroundTask worker %d stopped", worker_id);
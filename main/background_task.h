@@ -3,8 +3,8 @@
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include <functional>
 #include <mutex>
-#include <list>
 #include <vector>
 #include <condition_variable>
 #include <atomic>
@@ -14,12 +14,19 @@ public:
     BackgroundTask(uint32_t stack_size = 4096 * 2, int thread_count = 2, int priority = 6);
     ~BackgroundTask();
 
+    // 任务存放在构造时分配的环形队列中：callback 能放进 std::function 的内联存储时（捕获不超过 8 字节、
+    // 可平凡拷贝，例如 [this, slot]）调度不分配内存；队列满时阻塞等待
     void Schedule(std::function<void()> callback);
     void WaitForCompletion();
+    // 各工作线程栈的剩余最小值（字节）中最小的一个
+    uint32_t GetStackHighWaterMark();
 
 private:
     std::mutex mutex_;
-    std::list<std::function<void()>> background_tasks_;
+    static constexpr size_t kMaxTasks = 80;  // 排队和执行中的任务总数上限
+    std::vector<std::function<void()>> background_tasks_;
+    size_t queue_head_ = 0;
+    size_t queue_size_ = 0;
     std::condition_variable condition_variable_;
     std::vector<TaskHandle_t> background_task_handles_;
     std::atomic<size_t> active_tasks_{0};
@@ -13,10 +13,12 @@
 #include "application.h"
 #include "display.h"
 #include "board.h"
+#include "audio_trace.h"
 
 #define TAG "MCP"
 
 #define DEFAULT_TOOLCALL_STACK_SIZE 6144
+#define AUDIO_TRACE_PAGE_SIZE 2048  // self.audio.dump_trace 每页的最大字节数
 
 McpServer::McpServer() {
 }
@@ -56,6 +58,67 @@ void McpServer::AddCommonTools() {
             return true;
         });
     
+    AddTool("self.audio.set_frame_duration",
+        "Set the Opus frame duration in milliseconds (20, 40 or 60) used for both directions. "
+        "Shorter frames lower latency but cost more CPU and bandwidth. Takes effect from the next conversation.",
+        PropertyList({
+            Property("duration_ms", kPropertyTypeInteger, 20, 60)
+        }),
+        [](const PropertyList& properties) -> ReturnValue {
+            int duration = properties["duration_ms"].value<int>();
+            if (duration % 20 != 0) {
+                return "{\"success\": false, \"message\": \"Frame duration must be 20, 40 or 60\"}";
+            }
+            Application::GetInstance().SetPreferredFrameDuration(duration);
+            return true;
+        });
+
+    AddTool("self.audio.get_uplink_stats",
+        "Get the microphone uplink latency statistics of the current or last conversation for debugging: "
+        "count, mean and max in microseconds for capture-to-encode, encode, encode-to-send, send and end-to-end, "
+        "plus the current depth of the PCM and Opus rings. Only use this tool when the user explicitly asks for it.",
+        PropertyList(),
+        [](const PropertyList& properties) -> ReturnValue {
+            return Application::GetInstance().GetUplinkStatsJson();
+        });
+
+#if CONFIG_USE_AUDIO_TRACE
+    AddTool("self.audio.dump_trace",
+        "Dump the downlink audio latency trace for debugging. Only use this tool when the user explicitly asks for it.\n"
+        "Args:\n"
+        "  `serial`: Print the trace to the serial log instead of returning it.\n"
+        "  `offset`: Cursor returned by the previous call (`# next_offset=N`), 0 for the first page. "
+        "The trace is returned in pages of about 2KB; call again with the returned offset until `# end`.\n"
+        "  `clear`: Clear the trace after dumping.",
+        PropertyList({
+            Property("serial", kPropertyTypeBoolean, false),
+            Property("offset", kPropertyTypeInteger, 0, 0, INT32_MAX),
+            Property("clear", kPropertyTypeBoolean, false)
+        }),
+        [](const PropertyList& properties) -> ReturnValue {
+            auto& trace = AudioTrace::GetInstance();
+            ReturnValue result = true;
+            if (properties["serial"].value<bool>()) {
+                trace.DumpToLog();
+            } else {
+                // 每次只返回一页（有界的一次分配），避免把整个环（数十 KB）拼进一个字符串
+                std::string text(AUDIO_TRACE_PAGE_SIZE, '\0');
+                uint32_t cursor = properties["offset"].value<int>();
+                text.resize(trace.Dump(&cursor, &text[0], text.size() - 32));  // 留出结尾一行的空间
+                if (cursor - 1 < trace.recorded()) {
+                    text += "# next_offset=" + std::to_string(cursor) + "\n";
+                } else {
+                    text += "# end\n";
+                }
+                result = std::move(text);
+            }
+            if (properties["clear"].value<bool>()) {
+                trace.Clear();
+            }
+            return result;
+        });
+#endif
+
     auto backlight = board.GetBacklight();
     if (backlight) {
         AddTool("self.screen.set_brightness",
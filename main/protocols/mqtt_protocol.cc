@@ -10,12 +10,16 @@
 #include <arpa/inet.h>
 #include "assets/lang_config.h"
 #include <cctype>
+#include <algorithm>
 
 #define TAG "MQTT"
 
 // 构造函数，创建事件组
 MqttProtocol::MqttProtocol() {
     event_group_handle_ = xEventGroupCreate();
+    uplink_publisher_ = [this](std::string& payload, int frames) {
+        return PublishAudio(payload, frames);
+    };
 }
 
 // 析构函数，清理资源
@@ -50,6 +54,11 @@ bool MqttProtocol::StartMqttClient(bool report_error) {
     password_ = settings.GetString("password");
     int keepalive_interval = settings.GetInt("keepalive", 90);
     subscribe_topic_ = settings.GetString("subscribe_topic");
+    uplink_batch_ms_ = settings.GetInt("uplink_batch_ms", MQTT_UPLINK_BATCH_MS);
+    // 新连接上先逐帧发送，等服务端 hello 接受 uplink_batch 后再攒包
+    uplink_batcher_.Clear();
+    uplink_batcher_.SetLatencyBudget(0);
+    requested_batch_ms_ = -1;
 
     // 使用设备MAC地址生成唯一的设备ID和相关主题
     std::string user_id3 = SystemInfo::GetMacAddressDecimal();
@@ -111,32 +120,23 @@ bool MqttProtocol::StartMqttClient(bool report_error) {
             // 如果是JSON消息 (以'{'开头)
             if (!payload.empty() && payload[0] == '{') {
                 ESP_LOGD(TAG, "Received JSON message: %s", payload.c_str());
-                if (on_incoming_json_ != nullptr) {
-                    cJSON* root = cJSON_Parse(payload.c_str());
-                    if (root != nullptr) {
+                cJSON* root = cJSON_Parse(payload.c_str());
+                if (root != nullptr) {
+                    // 服务端 hello：协商下行音频参数
+                    auto type = cJSON_GetObjectItem(root, "type");
+                    if (cJSON_IsString(type) && strcmp(type->valuestring, "hello") == 0) {
+                        ParseServerHello(root);
+                    } else if (on_incoming_json_ != nullptr) {
                         on_incoming_json_(root);
-                        cJSON_Delete(root);
                     }
+                    cJSON_Delete(root);
                 }
             } else {
                 // 否则，视为音频数据包（服务器发送纯OPUS payload）
                 // 直接传递原始数据，避免AudioStreamPacket封装开销
                 if (on_incoming_audio_ != nullptr) {
-                    // 直接将payload转换为原始音频数据
-                    std::vector<uint8_t> raw_data(reinterpret_cast<const uint8_t*>(payload.data()),
-                                                 reinterpret_cast<const uint8_t*>(payload.data()) + payload.size());
-
-                    // 详细记录每个音频包的接收情况
-                    static uint32_t s_audio_log_counter = 0;
-                    static auto s_last_audio_time = std::chrono::steady_clock::now();
-                    auto current_time = std::chrono::steady_clock::now();
-                    auto interval_ms = std::chrono::duration_cast<std::chrono::milliseconds>(current_time - s_last_audio_time).count();
-                    s_last_audio_time = current_time;
-
-                    // ESP_LOGI(TAG, "AUDIO: recv opus frame #%" PRIu32 ": bytes=%zu, interval=%lldms",
-                    //          ++s_audio_log_counter, raw_data.size(), interval_ms);
-                    // 直接传递原始数据给应用层，避免packet封装
-                    on_incoming_audio_(std::move(raw_data));
+                    // 直接传递 payload 的只读视图给应用层，由应用层拷贝进解码环形队列，避免中间 vector 分配
+                    on_incoming_audio_(reinterpret_cast<const uint8_t*>(payload.data()), payload.size(), 0);
                 }
             }
         }
@@ -201,6 +201,9 @@ bool MqttProtocol::StartMqttClient(bool report_error) {
         ESP_LOGI(TAG, "vad_detection_topic: %s", vad_detection_topic_.c_str());
     }
 
+    // 告知服务端设备的音频能力，服务端可以回复 hello 选择下行采样率和帧长
+    SendText(GetHelloMessage());
+
     return true;
 }
 
@@ -252,11 +255,56 @@ std::string MqttProtocol::LoadLanguageTypeFromNVS() {
     return saved_language;
 }
 
+std::string MqttProtocol::GetHelloMessage() {
+    cJSON* root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "type", "hello");
+    cJSON_AddStringToObject(root, "transport", "mqtt");
+    cJSON_AddItemToObject(root, "audio_params", CreateAudioParams());
+    if (uplink_batch_ms_ > 0) {
+        // 询问服务端是否接受多帧容器（格式见 UplinkBatcher）
+        cJSON* uplink_batch = cJSON_CreateObject();
+        cJSON_AddNumberToObject(uplink_batch, "version", UplinkBatcher::kVersion);
+        cJSON_AddNumberToObject(uplink_batch, "max_latency_ms", uplink_batch_ms_);
+        cJSON_AddItemToObject(root, "uplink_batch", uplink_batch);
+    }
+    auto json_str = cJSON_PrintUnformatted(root);
+    std::string message(json_str);
+    cJSON_free(json_str);
+    cJSON_Delete(root);
+    return message;
+}
+
+void MqttProtocol::ParseServerHello(const cJSON* root) {
+    auto session_id = cJSON_GetObjectItem(root, "session_id");
+    if (cJSON_IsString(session_id)) {
+        session_id_ = session_id->valuestring;
+    }
+    ParseAudioParams(cJSON_GetObjectItem(root, "audio_params"));
+
+    // 服务端回复 "uplink_batch": true 后上行改为多帧容器；否则保持逐帧发送原始 Opus
+    // 这里在 MQTT 任务中，只记下预算，由主循环在下一次 SendAudio/FlushAudio 时先发出已攒的帧再切换
+    auto uplink_batch = cJSON_GetObjectItem(root, "uplink_batch");
+    requested_batch_ms_ = cJSON_IsTrue(uplink_batch) ? uplink_batch_ms_ : 0;
+}
+
+// 在主循环调用：应用服务端 hello 协商出的攒包预算
+void MqttProtocol::ApplyRequestedBatchBudget() {
+    int budget = requested_batch_ms_.exchange(-1);
+    if (budget < 0) {
+        return;
+    }
+    uplink_batcher_.Flush(uplink_publisher_);
+    uplink_batcher_.SetLatencyBudget(budget);
+    ESP_LOGI(TAG, "Uplink batching %s (budget %dms)", budget > 0 ? "enabled" : "disabled", budget);
+}
+
 // 发送文本消息
 bool MqttProtocol::SendText(const std::string& text) {
     if (publish_topic_.empty()) {
         return false;
     }
+    // 控制消息（停止监听、唤醒词等）必须排在已采集的音频之后
+    FlushAudio();
     if (!mqtt_->Publish(publish_topic_, text)) {
         ESP_LOGE(TAG, "Failed to publish message: %s", text.c_str());
         SetError(Lang::Strings::SERVER_ERROR);
@@ -265,7 +313,7 @@ bool MqttProtocol::SendText(const std::string& text) {
     return true;
 }
 
-// 发送音频数据 - 支持分片传输
+// 发送音频数据：服务端接受 uplink_batch 时攒成多帧容器发布，否则逐帧发布（大帧分片）
 bool MqttProtocol::SendAudio(const AudioStreamPacket& packet) {
     // 降低日志频率，并修正格式化规约：使用 %u 搭配显式转换，避免某些平台下 %zu 导致变参错位
     ESP_LOGD(TAG, "SendAudio: payload_size=%u, sample_rate=%d, frame_duration=%d",
@@ -273,89 +321,138 @@ bool MqttProtocol::SendAudio(const AudioStreamPacket& packet) {
 
     if (publish_topic_.empty() || mqtt_ == nullptr || !mqtt_->IsConnected()) {
         ESP_LOGE(TAG, "MQTT client not connected or topic empty");
+        std::lock_guard<std::mutex> lock(uplink_mutex_);
         audio_stats_.failed_packets++;
         return false;
     }
 
-    // 更新统计信息
-    audio_stats_.total_packets++;
-    audio_stats_.total_bytes += packet.payload.size();
-    audio_stats_.last_transmission = std::chrono::steady_clock::now();
+    ApplyRequestedBatchBudget();
+    {
+        // 更新统计信息
+        std::lock_guard<std::mutex> lock(uplink_mutex_);
+        auto now = std::chrono::steady_clock::now();
+        if (audio_stats_.total_packets == 0) {
+            audio_stats_.first_transmission = now;
+        }
+        audio_stats_.total_packets++;
+        audio_stats_.total_bytes += packet.payload.size();
+        audio_stats_.unbatched_wire_bytes += packet.payload.size() + PublishOverhead(packet.payload.size());
+        audio_stats_.last_transmission = now;
+    }
 
-    // 直接使用payload数据，不处理时间戳（参考S3项目）
-    std::string mqtt_payload(reinterpret_cast<const char*>(packet.payload.data()),
-                            packet.payload.size());
+    if (!uplink_batcher_.Add(packet.payload.data(), packet.payload.size(), packet.frame_duration, uplink_publisher_)) {
+        if (!uplink_publish_failed_) {
+            ESP_LOGE(TAG, "Audio frame too large for uplink container: bytes=%u", (unsigned)packet.payload.size());
+            std::lock_guard<std::mutex> lock(uplink_mutex_);
+            audio_stats_.failed_packets++;
+        }
+        ReportUplinkError();
+        return false;
+    }
+    return true;
+}
 
-    // 分片发送大的音频数据（参考S3项目实现）
-    const size_t MAX_CHUNK_SIZE = 1024;  // 每片最大1KB
+void MqttProtocol::FlushAudio() {
+    ApplyRequestedBatchBudget();
+    if (uplink_batcher_.pending_frames() == 0) {
+        return;
+    }
+    if (mqtt_ == nullptr || !mqtt_->IsConnected()) {
+        std::lock_guard<std::mutex> lock(uplink_mutex_);
+        audio_stats_.failed_packets += uplink_batcher_.pending_frames();
+        uplink_batcher_.Clear();
+        return;
+    }
+    uplink_batcher_.Flush(uplink_publisher_);
+    ReportUplinkError();
+}
+
+// 发布失败在发送路径的最后上报：SetError 会同步回调应用层
+void MqttProtocol::ReportUplinkError() {
+    if (!uplink_publish_failed_) {
+        return;
+    }
+    uplink_publish_failed_ = false;
+    SetError(Lang::Strings::SERVER_ERROR);
+}
+
+// 估算一次 QoS 0 发布在负载之外的开销：MQTT 固定头（1 字节类型 + 剩余长度变长编码）、
+// 主题长度和主题，以及 TCP/IPv4 头（假设每次发布单独成段，不含 WiFi MAC 层）
+size_t MqttProtocol::PublishOverhead(size_t payload_size) const {
+    size_t remaining = 2 + publish_topic_.size() + payload_size;
+    size_t length_bytes = remaining < 128 ? 1 : remaining < 16384 ? 2 : 3;
+    return 1 + length_bytes + 2 + publish_topic_.size() + 40;
+}
 
-    if (mqtt_payload.size() <= MAX_CHUNK_SIZE) {
-        // 小数据包直接发送
-        if (!mqtt_->Publish(publish_topic_, std::move(mqtt_payload))) {
+// 在主循环调用，不持有 uplink_mutex_：MQTT 事件回调持有客户端 API 锁再取 uplink_mutex_，
+// 这里持锁调用 Publish（需要 API 锁）会与之反序死锁
+// Mqtt 封装只接受 std::string 负载，一次发布必然对应一个 std::string：容器直接 std::move 给它，不再拷贝
+bool MqttProtocol::PublishAudio(std::string& payload, int frames) {
+    if (payload.size() <= MQTT_AUDIO_CHUNK_SIZE) {
+        size_t size = payload.size();
+        if (!mqtt_->Publish(publish_topic_, std::move(payload), 0)) {  // QoS 0，低延迟
             ESP_LOGE(TAG, "Failed to publish audio message");
-            audio_stats_.failed_packets++;
-            SetError(Lang::Strings::SERVER_ERROR);
+            OnAudioPublishFailed(frames);
             return false;
         }
-        audio_stats_.total_chunks++;
-        // 成功发送小包（单帧），在 DEBUG 级别记录一次成功日志
-        ESP_LOGD(TAG, "Audio packet published: bytes=%u", (unsigned)mqtt_payload.size());
-
-    } else {
-        // 大数据包分片发送
-        size_t remaining = mqtt_payload.size();
-        size_t offset = 0;
-        size_t total_chunks = (mqtt_payload.size() + MAX_CHUNK_SIZE - 1) / MAX_CHUNK_SIZE;
-
-        // 修正 size_t 打印格式以避免潜在不兼容
-        ESP_LOGI(TAG, "Sending large audio packet in chunks: total_size=%u, chunks=%u",
-                 (unsigned)mqtt_payload.size(), (unsigned)total_chunks);
-
-        while (remaining > 0) {
-            size_t chunk_size = std::min(remaining, MAX_CHUNK_SIZE);
-            std::string chunk_payload(mqtt_payload.data() + offset, chunk_size);
-
-            if (!mqtt_->Publish(publish_topic_, chunk_payload, 0)) {  // QoS 0，低延迟
-                ESP_LOGE(TAG, "Failed to publish audio chunk at offset %u", (unsigned)offset);
-                audio_stats_.failed_packets++;
-                SetError(Lang::Strings::SERVER_ERROR);
-                return false;
-            }
+        OnAudioPublished(size);
+        ESP_LOGD(TAG, "Audio published: bytes=%u frames=%d", (unsigned)size, frames);
+        return true;
+    }
 
-            audio_stats_.total_chunks++;
-            remaining -= chunk_size;
-            offset += chunk_size;
+    // 逐帧发送时的超大单帧分片发送（攒包容器不会超过 MQTT_AUDIO_CHUNK_SIZE）：
+    // 每片直接从帧数据构造交给 Mqtt 的负载，不经过 substr 的临时串
+    size_t total_chunks = (payload.size() + MQTT_AUDIO_CHUNK_SIZE - 1) / MQTT_AUDIO_CHUNK_SIZE;
+    ESP_LOGI(TAG, "Sending large audio packet in chunks: total_size=%u, chunks=%u",
+             (unsigned)payload.size(), (unsigned)total_chunks);
+    for (size_t offset = 0; offset < payload.size(); offset += MQTT_AUDIO_CHUNK_SIZE) {
+        size_t chunk_size = std::min(payload.size() - offset, (size_t)MQTT_AUDIO_CHUNK_SIZE);
+        if (!mqtt_->Publish(publish_topic_, std::string(payload.data() + offset, chunk_size), 0)) {
+            ESP_LOGE(TAG, "Failed to publish audio chunk at offset %u", (unsigned)offset);
+            OnAudioPublishFailed(frames);
+            return false;
         }
-
-        ESP_LOGI(TAG, "Successfully sent audio packet in %u chunks", (unsigned)total_chunks);
+        OnAudioPublished(chunk_size);
     }
+    return true;
+}
 
-    // 周期性输出统计信息，避免日志过于频繁（每100包一次，约每3秒）
-    // if ((audio_stats_.total_packets % 100) == 0) {
-    //     LogAudioStats();
-    // }
+void MqttProtocol::OnAudioPublished(size_t size) {
+    std::lock_guard<std::mutex> lock(uplink_mutex_);
+    audio_stats_.total_chunks++;
+    audio_stats_.wire_bytes += size + PublishOverhead(size);
+}
 
-    return true;
+void MqttProtocol::OnAudioPublishFailed(int frames) {
+    {
+        std::lock_guard<std::mutex> lock(uplink_mutex_);
+        audio_stats_.failed_packets += frames;
+    }
+    uplink_publish_failed_ = true;
 }
 
 // 打印音频传输统计信息（用于调试）
 void MqttProtocol::LogAudioStats() {
+    auto stats = GetAudioStats();
+    if (stats.total_packets == 0) {
+        return;
+    }
     auto now = std::chrono::steady_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::seconds>(
-        now - audio_stats_.last_transmission).count();
+    auto idle = std::chrono::duration_cast<std::chrono::seconds>(now - stats.last_transmission).count();
+    // 按一次会话内第一帧到最后一帧的时间（加一帧）计算速率
+    double seconds = std::chrono::duration<double>(stats.last_transmission - stats.first_transmission).count()
+        + server_frame_duration_ / 1000.0;
 
     ESP_LOGI(TAG, "=== Audio Transmission Stats ===");
-    ESP_LOGI(TAG, "Total packets: %u", (unsigned)audio_stats_.total_packets);
-    ESP_LOGI(TAG, "Total chunks: %u", (unsigned)audio_stats_.total_chunks);
-    ESP_LOGI(TAG, "Failed packets: %u", (unsigned)audio_stats_.failed_packets);
-    ESP_LOGI(TAG, "Total bytes: %u", (unsigned)audio_stats_.total_bytes);
-    ESP_LOGI(TAG, "Success rate: %.2f%%",
-             audio_stats_.total_packets > 0 ?
-             (100.0 * (audio_stats_.total_packets - audio_stats_.failed_packets) / audio_stats_.total_packets) : 0.0);
-    ESP_LOGI(TAG, "Avg chunks per packet: %.2f",
-             audio_stats_.total_packets > 0 ?
-             (float)audio_stats_.total_chunks / audio_stats_.total_packets : 0.0);
-    ESP_LOGI(TAG, "Last transmission: %d seconds ago", (int)duration);
+    ESP_LOGI(TAG, "Frames: %u, publishes: %u, failed: %u, payload bytes: %u",
+             (unsigned)stats.total_packets, (unsigned)stats.total_chunks,
+             (unsigned)stats.failed_packets, (unsigned)stats.total_bytes);
+    ESP_LOGI(TAG, "Frames per publish: %.2f", (float)stats.total_packets / std::max<uint32_t>(stats.total_chunks, 1));
+    ESP_LOGI(TAG, "Publishes/s: %.1f (unbatched %.1f)",
+             stats.total_chunks / seconds, stats.total_packets / seconds);
+    ESP_LOGI(TAG, "Bytes on air/s: %.0f (unbatched %.0f)",
+             stats.wire_bytes / seconds, stats.unbatched_wire_bytes / seconds);
+    ESP_LOGI(TAG, "Last transmission: %d seconds ago", (int)idle);
     ESP_LOGI(TAG, "================================");
 }
 
@@ -409,6 +506,9 @@ void MqttProtocol::SendImuStatesAndValue(const t_sQMI8658& imu_data, int touch_v
 // 关闭音频通道（在纯MQTT模式下，这通常只是一个逻辑上的关闭）
 void MqttProtocol::CloseAudioChannel() {
     ESP_LOGI(TAG, "Closing audio channel");
+    FlushAudio();
+    LogAudioStats();
+    ResetAudioStats();
     if (mqtt_ && !publish_topic_.empty()) {
         // 发送"END"消息，服务器可以此作为音频流结束的标志
         mqtt_->Publish(publish_topic_, "END", 1);
@@ -497,6 +597,7 @@ void MqttProtocol::HandleVadDetectionMessage(const std::string& payload) {
 
 // 服务端VAD检测处理 通知APP层（不做本地防抖）
 void MqttProtocol::HandleServerVadDetection() {
+    // 在 MQTT 任务中：尾帧由应用层切换状态时在主循环发出（FlushAudio 只能在主循环调用）
     ESP_LOGI(TAG, "Server VAD detected speech end, notify application");
     if (on_server_vad_detected_) {
         on_server_vad_detected_();
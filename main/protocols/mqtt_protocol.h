@@ -3,6 +3,7 @@
 
 
 #include "protocol.h"
+#include "uplink_batcher.h"
 #include <mqtt.h>
 #include <udp.h>
 #include <cJSON.h>
@@ -10,6 +11,7 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/event_groups.h>
 
+#include <atomic>
 #include <functional>
 #include <string>
 #include <map>
@@ -23,6 +25,12 @@
 #define MQTT_PROTOCOL_SERVER_HELLO_EVENT (1 << 0)
 #define MWTT_PORT 1883
 
+// 单次音频发布的最大字节数，更大的单帧按此分片
+#define MQTT_AUDIO_CHUNK_SIZE 1024
+// 上行攒包的默认延迟预算（毫秒），可由设置项 mqtt.uplink_batch_ms 覆盖，0 表示逐帧发送
+// 仅在服务端 hello 回复接受 uplink_batch 后生效
+#define MQTT_UPLINK_BATCH_MS 180
+
 
 class MqttProtocol : public Protocol {
 public:
@@ -34,11 +42,8 @@ public:
     bool OpenAudioChannel() override;
     void CloseAudioChannel() override;
     bool IsAudioChannelOpened() const override;
+    void FlushAudio() override;
 
-    //F移植 添加  ---使用C3原版 注释掉
-    // void SetOnIncomingAudio(std::function<void(std::vector<uint8_t>&&)> callback) {
-    //     on_incoming_audio_ = std::move(callback);
-    // }
     //F移植 添加
     void SendCancelTTS(bool f=false );//发送取消tts消息
     //F移植 添加
@@ -62,20 +67,25 @@ public:
 
     // 音频传输统计结构体
     struct AudioTransmissionStats {
-        uint32_t total_packets = 0;
-        uint32_t total_chunks = 0;
+        uint32_t total_packets = 0;         // SendAudio 收到的 Opus 帧数
+        uint32_t total_chunks = 0;          // 实际发布次数（攒包后一个容器计一次）
         uint32_t failed_packets = 0;
-        uint64_t total_bytes = 0;
+        uint64_t total_bytes = 0;           // Opus 负载字节数
+        uint64_t wire_bytes = 0;            // 估算的空中字节数：负载 + 容器头 + MQTT 头 + TCP/IP 头
+        uint64_t unbatched_wire_bytes = 0;  // 同样的帧逐帧发布时估算的空中字节数，用于对比
+        std::chrono::steady_clock::time_point first_transmission;
         std::chrono::steady_clock::time_point last_transmission;
     };
 
     // 获取音频传输统计信息
     AudioTransmissionStats GetAudioStats() const {
+        std::lock_guard<std::mutex> lock(uplink_mutex_);
         return audio_stats_;
     }
 
     // 重置音频传输统计
     void ResetAudioStats() {
+        std::lock_guard<std::mutex> lock(uplink_mutex_);
         audio_stats_ = AudioTransmissionStats{};
     }
 
@@ -117,6 +127,23 @@ private:
     // 音频传输统计实例
     AudioTransmissionStats audio_stats_;
 
+    // 上行攒包和音频发布只在主循环进行（SendAudio/FlushAudio/SendText/CloseAudioChannel），不加锁；
+    // MQTT 任务只通过 requested_batch_ms_ 提交 hello 协商的预算。uplink_mutex_ 只保护 audio_stats_，
+    // 从不在持有时调用 Mqtt::Publish
+    mutable std::mutex uplink_mutex_;
+    UplinkBatcher uplink_batcher_{MQTT_AUDIO_CHUNK_SIZE};
+    UplinkBatcher::Publisher uplink_publisher_;
+    int uplink_batch_ms_ = MQTT_UPLINK_BATCH_MS;
+    std::atomic<int> requested_batch_ms_{-1};  // -1 表示没有待应用的预算
+    bool uplink_publish_failed_ = false;
+
+    void ApplyRequestedBatchBudget();
+    bool PublishAudio(std::string& payload, int frames);
+    void OnAudioPublished(size_t size);
+    void OnAudioPublishFailed(int frames);
+    void ReportUplinkError();
+    size_t PublishOverhead(size_t payload_size) const;
+
     bool StartMqttClient(bool report_error=false);
     void ParseServerHello(const cJSON* root);
     std::string DecodeHexString(const std::string& hex_string);
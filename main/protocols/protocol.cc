@@ -1,4 +1,5 @@
 #include "protocol.h"
+#include "board.h"
 
 #include <esp_log.h>
 
@@ -8,7 +9,7 @@ void Protocol::OnIncomingJson(std::function<void(const cJSON* root)> callback) {
     on_incoming_json_ = callback;
 }
 
-void Protocol::OnIncomingAudio(std::function<void(std::vector<uint8_t>&& raw_data)> callback) {
+void Protocol::OnIncomingAudio(std::function<void(const uint8_t* data, size_t size, uint32_t timestamp)> callback) {
     on_incoming_audio_ = callback;
 }
 
@@ -20,10 +21,51 @@ void Protocol::OnAudioChannelClosed(std::function<void()> callback) {
     on_audio_channel_closed_ = callback;
 }
 
+void Protocol::OnServerAudioParams(std::function<void(int sample_rate, int frame_duration)> callback) {
+    on_server_audio_params_ = callback;
+}
+
 void Protocol::OnNetworkError(std::function<void(const std::string& message)> callback) {
     on_network_error_ = callback;
 }
 
+cJSON* Protocol::CreateAudioParams() {
+    auto codec = Board::GetInstance().GetAudioCodec();
+    cJSON* audio_params = cJSON_CreateObject();
+    cJSON_AddStringToObject(audio_params, "format", "opus");
+    cJSON_AddNumberToObject(audio_params, "sample_rate", 16000);
+    cJSON_AddNumberToObject(audio_params, "channels", 1);
+    cJSON_AddNumberToObject(audio_params, "frame_duration", preferred_frame_duration_);
+    // 下行：服务端按设备原生采样率发送时，设备解码后无需重采样
+    cJSON_AddNumberToObject(audio_params, "output_sample_rate", codec->output_sample_rate());
+    cJSON* frame_durations = cJSON_CreateArray();
+    for (int duration = 20; duration <= max_frame_duration_; duration += 20) {
+        cJSON_AddItemToArray(frame_durations, cJSON_CreateNumber(duration));
+    }
+    cJSON_AddItemToObject(audio_params, "frame_durations", frame_durations);
+    return audio_params;
+}
+
+void Protocol::ParseAudioParams(const cJSON* audio_params) {
+    if (!cJSON_IsObject(audio_params)) {
+        return;
+    }
+    auto sample_rate = cJSON_GetObjectItem(audio_params, "sample_rate");
+    if (cJSON_IsNumber(sample_rate)) {
+        server_sample_rate_ = sample_rate->valueint;
+    }
+    // 服务端没有给出帧时长时，视为接受 hello 中提出的帧时长
+    server_frame_duration_ = preferred_frame_duration_;
+    auto frame_duration = cJSON_GetObjectItem(audio_params, "frame_duration");
+    if (cJSON_IsNumber(frame_duration)) {
+        server_frame_duration_ = frame_duration->valueint;
+    }
+    ESP_LOGI(TAG, "Server audio params: sample_rate=%d, frame_duration=%d", server_sample_rate_, server_frame_duration_);
+    if (on_server_audio_params_ != nullptr) {
+        on_server_audio_params_(server_sample_rate_, server_frame_duration_);
+    }
+}
+
 void Protocol::SetError(const std::string& message) {
     error_occurred_ = true;
     if (on_network_error_ != nullptr) {
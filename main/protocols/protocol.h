@@ -57,13 +57,22 @@ public:
     }
 
     // 直接处理原始音频数据的接口，避免packet封装开销
-    void OnIncomingAudio(std::function<void(std::vector<uint8_t>&& raw_data)> callback);
+    // data 仅在回调期间有效，接收方需要自行拷贝（例如写入解码环形队列）
+    // timestamp 为传输层携带的包时间戳（毫秒），传输层没有时间戳时为 0
+    void OnIncomingAudio(std::function<void(const uint8_t* data, size_t size, uint32_t timestamp)> callback);
 
     void OnIncomingJson(std::function<void(const cJSON* root)> callback);
     void OnAudioChannelOpened(std::function<void()> callback);
     void OnAudioChannelClosed(std::function<void()> callback);
     void OnNetworkError(std::function<void(const std::string& message)> callback);
     void OnServerVadDetected(std::function<void()> callback) { on_server_vad_detected_ = std::move(callback); }
+    // 服务端 hello 中给出（或更改）下行音频参数时回调，应用层据此重建解码器
+    void OnServerAudioParams(std::function<void(int sample_rate, int frame_duration)> callback);
+    // hello 中提出的帧时长和支持的最长帧时长（20ms 的整数倍），应用层在 Start 之前以及偏好变化时设置
+    void SetPreferredFrameDuration(int frame_duration, int max_frame_duration) {
+        preferred_frame_duration_ = frame_duration;
+        max_frame_duration_ = max_frame_duration;
+    }
 
 
     virtual bool Start() = 0;
@@ -71,6 +80,8 @@ public:
     virtual void CloseAudioChannel() = 0;
     virtual bool IsAudioChannelOpened() const = 0;
     virtual bool SendAudio(const AudioStreamPacket& packet) = 0;
+    // 传输层攒包发送上行音频时，立即发出尚未发送的帧（说话结束时在主循环调用，与 SendAudio 同一线程）
+    virtual void FlushAudio() {}
     virtual void SendWakeWordDetected(const std::string& wake_word);
     virtual void SendStartListening(ListeningMode mode);
     virtual void SendStopListening();
@@ -81,21 +92,28 @@ public:
 
 protected:
     std::function<void(const cJSON* root)> on_incoming_json_;
-    std::function<void(std::vector<uint8_t>&& raw_data)> on_incoming_audio_;
+    std::function<void(const uint8_t* data, size_t size, uint32_t timestamp)> on_incoming_audio_;
     std::function<void()> on_audio_channel_opened_;
     std::function<void()> on_audio_channel_closed_;
     std::function<void(const std::string& message)> on_network_error_;
 
     int server_sample_rate_ = 24000;
     int server_frame_duration_ = 60;
+    int preferred_frame_duration_ = 60;
+    int max_frame_duration_ = 60;
     bool error_occurred_ = false;
     std::string session_id_;
 
     std::function<void()> on_server_vad_detected_;
+    std::function<void(int sample_rate, int frame_duration)> on_server_audio_params_;
 
     std::chrono::time_point<std::chrono::steady_clock> last_incoming_time_;
 
     virtual bool SendText(const std::string& text) = 0;
+    // hello 消息的 audio_params：上行格式，以及设备原生输出采样率和支持的下行帧长，供服务端选择下行参数
+    cJSON* CreateAudioParams();
+    // 解析服务端 hello 的 audio_params，更新 server_sample_rate_/server_frame_duration_ 并通知应用层
+    void ParseAudioParams(const cJSON* audio_params);
     virtual void SetError(const std::string& message);
     virtual bool IsTimeout() const;
 };
@@ -0,0 +1,92 @@
+#include "uplink_batcher.h"
+
+#include <algorithm>
+
+UplinkBatcher::UplinkBatcher(size_t max_container_bytes)
+    : max_container_bytes_(max_container_bytes) {
+    container_.reserve(max_container_bytes_);
+}
+
+int UplinkBatcher::MaxFrames(int frame_duration_ms) const {
+    if (frame_duration_ms <= 0) {
+        return 1;
+    }
+    // frame_count 只有一个字节
+    return std::min(std::max(1, latency_budget_ms_ / frame_duration_ms), 255);
+}
+
+bool UplinkBatcher::Add(const uint8_t* frame, size_t size, int frame_duration_ms, const Publisher& publish) {
+    int max_frames = MaxFrames(frame_duration_ms);
+    if (max_frames <= 1 && pending_frames_ == 0) {
+        // 不攒包：与原先一样直接发布原始 Opus
+        container_.assign(reinterpret_cast<const char*>(frame), size);
+        bool success = publish(container_, 1);
+        container_.clear();
+        return success;
+    }
+
+    size_t needed = kFrameHeaderSize + size;
+    if (kHeaderSize + needed > max_container_bytes_ || size > 0xFFFF) {
+        return false;
+    }
+    bool success = true;
+    if (pending_frames_ > 0 && container_.size() + needed > max_container_bytes_) {
+        success = Flush(publish);
+    }
+
+    if (pending_frames_ == 0) {
+        container_.clear();
+        // 上一个容器可能被发布方取走
+        container_.reserve(max_container_bytes_);
+        container_.push_back((char)kVersion);
+        container_.push_back(0);
+    }
+    container_.push_back((char)(size >> 8));
+    container_.push_back((char)(size & 0xFF));
+    container_.append(reinterpret_cast<const char*>(frame), size);
+    pending_frames_++;
+
+    if (pending_frames_ >= max_frames) {
+        success = Flush(publish) && success;
+    }
+    return success;
+}
+
+bool UplinkBatcher::Flush(const Publisher& publish) {
+    if (pending_frames_ == 0) {
+        return true;
+    }
+    container_[1] = (char)pending_frames_;
+    int frames = pending_frames_;
+    pending_frames_ = 0;
+    bool success = publish(container_, frames);
+    container_.clear();
+    return success;
+}
+
+void UplinkBatcher::Clear() {
+    pending_frames_ = 0;
+    container_.clear();
+}
+
+bool UplinkBatcher::Unpack(const uint8_t* data, size_t size,
+    const std::function<void(const uint8_t* frame, size_t size)>& callback) {
+    if (size < kHeaderSize || data[0] != kVersion) {
+        return false;
+    }
+    int frames = data[1];
+    size_t offset = kHeaderSize;
+    for (int i = 0; i < frames; i++) {
+        if (offset + kFrameHeaderSize > size) {
+            return false;
+        }
+        size_t frame_size = ((size_t)data[offset] << 8) | data[offset + 1];
+        offset += kFrameHeaderSize;
+        if (offset + frame_size > size) {
+            return false;
+        }
+        callback(data + offset, frame_size);
+        offset += frame_size;
+    }
+    return offset == size;
+}
@@ -0,0 +1,55 @@
+#ifndef UPLINK_BATCHER_H
+#define UPLINK_BATCHER_H
+
+#include <functional>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// 上行 Opus 攒包：把连续的多帧打包成一个容器一次发布，摊薄 MQTT 固定头、主题和 TCP/IP 的逐包开销
+//
+// 容器格式（与服务端在 hello 中协商 uplink_batch 后使用）：
+//   [version = 1][frame_count] { [length 高字节][length 低字节][Opus 数据] } * frame_count
+//
+// - 攒够 latency_budget_ms 对应的帧数，或容器再放一帧就超过 max_container_bytes 时立即发出
+// - 说话结束、发送文本消息前由调用方 Flush，保证尾帧不被延迟、音频与控制消息保持顺序
+// - 帧直接追加到容器缓冲中，每帧只拷贝一次；发布方可以取走整个缓冲（std::move 给网络库），之后的容器重新分配
+// - latency_budget_ms 不超过一帧时退化为逐帧发送原始 Opus
+// 不依赖 FreeRTOS/网络库，可以在主机上验证
+class UplinkBatcher {
+public:
+    static constexpr uint8_t kVersion = 1;
+    static constexpr size_t kHeaderSize = 2;
+    static constexpr size_t kFrameHeaderSize = 2;
+
+    // 发布一个完整容器（或未攒包时的单帧原始 Opus）；container 仅在回调期间有效，回调可以 std::move 取走它
+    using Publisher = std::function<bool(std::string& container, int frames)>;
+
+    explicit UplinkBatcher(size_t max_container_bytes);
+
+    void SetLatencyBudget(int latency_budget_ms) { latency_budget_ms_ = latency_budget_ms; }
+    int latency_budget_ms() const { return latency_budget_ms_; }
+    // 本帧时长下一个容器最多容纳的帧数，1 表示不攒包
+    int MaxFrames(int frame_duration_ms) const;
+
+    // 加入一帧，需要时调用 publish 发出；publish 失败或帧超过容器上限时返回 false（该帧被丢弃）
+    bool Add(const uint8_t* frame, size_t size, int frame_duration_ms, const Publisher& publish);
+    // 立即发出已攒的帧（没有时什么也不做）
+    bool Flush(const Publisher& publish);
+    // 丢弃已攒的帧（连接重建时使用）
+    void Clear();
+
+    int pending_frames() const { return pending_frames_; }
+
+    // 服务端/模拟器侧：按顺序解出容器中的各帧，格式错误时返回 false
+    static bool Unpack(const uint8_t* data, size_t size,
+        const std::function<void(const uint8_t* frame, size_t size)>& callback);
+
+private:
+    const size_t max_container_bytes_;
+    int latency_budget_ms_ = 0;
+    std::string container_;
+    int pending_frames_ = 0;
+};
+
+#endif // UPLINK_BATCHER_H
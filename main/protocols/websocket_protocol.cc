@@ -122,22 +122,15 @@ bool WebsocketProtocol::OpenAudioChannel() {
                     bp2->type = ntohs(bp2->type);
                     bp2->timestamp = ntohl(bp2->timestamp);
                     bp2->payload_size = ntohl(bp2->payload_size);
-                    auto payload = (uint8_t*)bp2->payload;
-                    // 优化：直接传递原始音频数据，避免AudioStreamPacket封装
-                    std::vector<uint8_t> raw_data(payload, payload + bp2->payload_size);
-                    on_incoming_audio_(std::move(raw_data));
+                    // 优化：直接传递原始音频数据视图，避免AudioStreamPacket封装和拷贝
+                    on_incoming_audio_(bp2->payload, bp2->payload_size, bp2->timestamp);
                 } else if (version_ == 3) {
                     BinaryProtocol3* bp3 = (BinaryProtocol3*)data;
                     bp3->type = bp3->type;
                     bp3->payload_size = ntohs(bp3->payload_size);
-                    auto payload = (uint8_t*)bp3->payload;
-                    // 优化：直接传递原始音频数据，避免AudioStreamPacket封装
-                    std::vector<uint8_t> raw_data(payload, payload + bp3->payload_size);
-                    on_incoming_audio_(std::move(raw_data));
+                    on_incoming_audio_(bp3->payload, bp3->payload_size, 0);
                 } else {
-                    // 优化：直接传递原始音频数据，避免AudioStreamPacket封装
-                    std::vector<uint8_t> raw_data((uint8_t*)data, (uint8_t*)data + len);
-                    on_incoming_audio_(std::move(raw_data));
+                    on_incoming_audio_((const uint8_t*)data, len, 0);
                 }
             }
         } else {
@@ -209,12 +202,7 @@ std::string WebsocketProtocol::GetHelloMessage() {
 #endif
     cJSON_AddItemToObject(root, "features", features);
     cJSON_AddStringToObject(root, "transport", "websocket");
-    cJSON* audio_params = cJSON_CreateObject();
-    cJSON_AddStringToObject(audio_params, "format", "opus");
-    cJSON_AddNumberToObject(audio_params, "sample_rate", 16000);
-    cJSON_AddNumberToObject(audio_params, "channels", 1);
-    cJSON_AddNumberToObject(audio_params, "frame_duration", OPUS_FRAME_DURATION_MS);
-    cJSON_AddItemToObject(root, "audio_params", audio_params);
+    cJSON_AddItemToObject(root, "audio_params", CreateAudioParams());
     auto json_str = cJSON_PrintUnformatted(root);
     std::string message(json_str);
     cJSON_free(json_str);
@@ -235,17 +223,7 @@ void WebsocketProtocol::ParseServerHello(const cJSON* root) {
         ESP_LOGI(TAG, "Session ID: %s", session_id_.c_str());
     }
 
-    auto audio_params = cJSON_GetObjectItem(root, "audio_params");
-    if (cJSON_IsObject(audio_params)) {
-        auto sample_rate = cJSON_GetObjectItem(audio_params, "sample_rate");
-        if (cJSON_IsNumber(sample_rate)) {
-            server_sample_rate_ = sample_rate->valueint;
-        }
-        auto frame_duration = cJSON_GetObjectItem(audio_params, "frame_duration");
-        if (cJSON_IsNumber(frame_duration)) {
-            server_frame_duration_ = frame_duration->valueint;
-        }
-    }
+    ParseAudioParams(cJSON_GetObjectItem(root, "audio_params"));
 
     xEventGroupSetBits(event_group_handle_, WEBSOCKET_PROTOCOL_SERVER_HELLO_EVENT);
 }
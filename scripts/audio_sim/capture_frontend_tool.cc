@@ -0,0 +1,109 @@
+// 用录制的交织多声道 PCM（s16le）离线运行 CaptureFrontend，输出 16kHz 交织 PCM，
+// 并统计转换耗时和稳态下的缓冲容量变化，用于在主机上验证 Application::ReadAudio 的采集前端
+//   capture_frontend_tool in.pcm out.pcm --rate 24000 --channels 2 [--read-ms 32]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "capture_frontend.h"
+
+// 与 OpusResampler 输出长度一致（n * out / in）的线性插值重采样器，每声道独立保持相位
+class LinearResampler {
+public:
+    void Configure(int input_sample_rate, int output_sample_rate) {
+        input_sample_rate_ = input_sample_rate;
+        output_sample_rate_ = output_sample_rate;
+    }
+
+    size_t Process(const int16_t* src, size_t samples, int16_t* dst) {
+        size_t count = samples * output_sample_rate_ / input_sample_rate_;
+        for (size_t i = 0; i < count; i++) {
+            // 输出样本 i 对应的输入位置（Q16）
+            uint64_t position = ((uint64_t)i * input_sample_rate_ << 16) / output_sample_rate_;
+            size_t index = position >> 16;
+            int32_t fraction = (position & 0xFFFF) >> 1;
+            int32_t a = index == 0 ? previous_ : src[index - 1];
+            int32_t b = src[index < samples ? index : samples - 1];
+            dst[i] = (int16_t)(a + (((b - a) * fraction) >> 15));
+        }
+        previous_ = samples > 0 ? src[samples - 1] : previous_;
+        return count;
+    }
+
+private:
+    int input_sample_rate_ = 16000;
+    int output_sample_rate_ = 16000;
+    int32_t previous_ = 0;
+};
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s in.pcm out.pcm [--rate N] [--channels N] [--read-ms N]\n", argv[0]);
+        return 1;
+    }
+    int rate = 16000;
+    int channels = 1;
+    int read_ms = 32;
+    for (int i = 3; i + 1 < argc; i += 2) {
+        std::string option = argv[i];
+        if (option == "--rate") {
+            rate = atoi(argv[i + 1]);
+        } else if (option == "--channels") {
+            channels = atoi(argv[i + 1]);
+        } else if (option == "--read-ms") {
+            read_ms = atoi(argv[i + 1]);
+        }
+    }
+
+    FILE* in = fopen(argv[1], "rb");
+    FILE* out = fopen(argv[2], "wb");
+    if (in == nullptr || out == nullptr) {
+        fprintf(stderr, "cannot open input/output\n");
+        return 1;
+    }
+
+    std::vector<LinearResampler> resamplers(channels);
+    for (auto& resampler : resamplers) {
+        resampler.Configure(rate, 16000);
+    }
+    size_t output_samples = read_ms * 16000 / 1000 * channels;
+    CaptureFrontend frontend;
+    frontend.Configure(channels, rate, 16000, output_samples,
+        [&resamplers](int channel, const int16_t* src, size_t samples, int16_t* dst) {
+            return resamplers[channel].Process(src, samples, dst);
+        });
+
+    std::vector<int16_t> data;
+    size_t reads = 0;
+    size_t total_output = 0;
+    size_t capacity_changes = 0;
+    const int16_t* last_buffer = nullptr;
+    double busy_ns = 0;
+    while (true) {
+        size_t raw_samples;
+        int16_t* raw = frontend.PrepareRead(output_samples, raw_samples);
+        if (fread(raw, sizeof(int16_t), raw_samples, in) != raw_samples) {
+            break;
+        }
+        auto start = std::chrono::steady_clock::now();
+        frontend.Process(raw_samples, data);
+        busy_ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        // 第一次读取后输出缓冲不应再重新分配
+        if (data.data() != last_buffer) {
+            capacity_changes++;
+            last_buffer = data.data();
+        }
+        fwrite(data.data(), sizeof(int16_t), data.size(), out);
+        reads++;
+        total_output += data.size();
+    }
+    fclose(in);
+    fclose(out);
+
+    printf("reads=%zu output_samples=%zu buffer_reallocations=%zu ns_per_read=%.0f\n",
+        reads, total_output, capacity_changes, reads > 0 ? busy_ns / reads : 0.0);
+    return capacity_changes <= 1 ? 0 : 2;
+}
@@ -0,0 +1,339 @@
+// 下行解码流水线的回放对比：同一段码流（P3 文件或合成流，按固定模式丢包）分别经过
+// - 内联参考：单线程依次解码，丢失的帧按 PLC、用下一包 FEC 恢复、下一包本身的顺序补上，再经过有状态的后处理
+// - 流水线：与设备相同的 DownlinkScheduler 取包和补帧、DecodeSequencer 保序，解码任务在 N 个工作线程上执行，
+//   各阶段前后插入随机延迟打乱线程到达的顺序；后处理放在重采样阶段
+// 逐帧比较解码模式、输入载荷和输出 PCM，要求完全一致且顺序相同
+//   decode_order_tool [stream.p3] [--workers N] [--runs N] [--frames N] [--frame-ms N]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <esp_timer.h>
+
+#include "packet_ring.h"
+#include "jitter_buffer.h"
+#include "decode_sequencer.h"
+#include "downlink_scheduler.h"
+#include "job_slots.h"
+#include "pcm_pool.h"
+#include "fake_protocol.h"
+#include "sim_codecs.h"
+#include "task_pool.h"
+
+static const int kSampleRate = 16000;
+static const int kMaxInFlight = 4;        // AUDIO_DECODE_MAX_IN_FLIGHT
+static int g_failures = 0;
+
+#define CHECK(condition, ...)                                       \
+    do {                                                            \
+        if (!(condition)) {                                         \
+            fprintf(stderr, "%s:%d: check failed: %s: ", __FILE__, __LINE__, #condition); \
+            fprintf(stderr, __VA_ARGS__);                           \
+            fprintf(stderr, "\n");                                  \
+            g_failures++;                                           \
+        }                                                           \
+    } while (0)
+
+struct Frame {
+    int mode = DownlinkScheduler::kNormal;
+    uint32_t payload = 0;           // 解码输入的哈希，PLC 帧为空载荷的哈希
+    std::vector<int16_t> pcm;
+};
+
+static uint32_t Hash(const uint8_t* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// 代替设备上有状态的重采样器：输出依赖之前所有帧，帧的顺序错了结果就不同
+class PostFilter {
+public:
+    void Process(int16_t* pcm, size_t samples) {
+        for (size_t i = 0; i < samples; i++) {
+            state_ += (pcm[i] * 256 - state_) / 4;
+            pcm[i] = (int16_t)(state_ / 256);
+        }
+    }
+
+private:
+    int32_t state_ = 0;
+};
+
+// 固定的丢包模式：单包和 2~3 包的连续丢失，连续丢失不超过 JITTER_MAX_CONCEALED_FRAMES，第一个包不丢
+static std::vector<bool> LossPattern(size_t packets, bool loss) {
+    std::vector<bool> lost(packets, false);
+    if (!loss) {
+        return lost;
+    }
+    int run = 0;
+    for (size_t i = 1; i < packets; i++) {
+        bool drop = i % 17 == 5 || i % 29 == 11 || i % 29 == 12 || (i % 41 >= 20 && i % 41 <= 22);
+        run = drop ? run + 1 : 0;
+        lost[i] = drop && run <= 3;
+        if (!lost[i]) {
+            run = 0;
+        }
+    }
+    return lost;
+}
+
+static std::vector<Frame> DecodeInline(const std::vector<std::vector<uint8_t>>& packets, const std::vector<bool>& lost,
+    int frame_ms) {
+    SimDecoder decoder(kSampleRate, 1, frame_ms);
+    PostFilter filter;
+    std::vector<Frame> frames;
+    std::vector<int16_t> pcm(kSampleRate / 1000 * frame_ms);
+    auto output = [&](int mode, uint32_t payload, int samples) {
+        if (samples < 0) {
+            return;
+        }
+        filter.Process(pcm.data(), samples);
+        Frame frame;
+        frame.mode = mode;
+        frame.payload = payload;
+        frame.pcm.assign(pcm.begin(), pcm.begin() + samples);
+        frames.push_back(std::move(frame));
+    };
+    int missing = 0;
+    bool started = false;
+    for (size_t i = 0; i < packets.size(); i++) {
+        if (lost[i]) {
+            missing += started ? 1 : 0;
+            continue;
+        }
+        const auto& packet = packets[i];
+        uint32_t payload = Hash(packet.data(), packet.size());
+        for (int k = 0; k < missing; k++) {
+            if (k < missing - 1) {
+                output(DownlinkScheduler::kConceal, Hash(nullptr, 0), decoder.Conceal(pcm.data(), pcm.size()));
+            } else {
+                output(DownlinkScheduler::kFec, payload,
+                    decoder.DecodeFec(packet.data(), packet.size(), pcm.data(), pcm.size()));
+            }
+        }
+        output(DownlinkScheduler::kNormal, payload, decoder.Decode(packet.data(), packet.size(), pcm.data(), pcm.size()));
+        missing = 0;
+        started = true;
+    }
+    return frames;
+}
+
+// 0~max_us 的伪随机延迟，由序号和阶段决定
+static void Jitter(uint32_t sequence, int stage, int max_us) {
+    uint32_t x = (sequence * 2654435761u) ^ (stage * 40503u);
+    x ^= x >> 13;
+    x *= 0x5bd1e995u;
+    x ^= x >> 15;
+    int us = (int)(x % (uint32_t)(max_us + 1));
+    if (us > max_us / 2) {
+        std::this_thread::sleep_for(std::chrono::microseconds(us));
+    }
+}
+
+static std::vector<Frame> DecodePipelined(const std::vector<std::vector<uint8_t>>& packets, const std::vector<bool>& lost,
+    int frame_ms, int workers, uint32_t seed) {
+    PacketRing queue(64, 16 * 1024);
+    JitterBuffer jitter_buffer(frame_ms, 120, 600);
+    DecodeSequencer sequencer(kMaxInFlight);
+    DownlinkScheduler scheduler(queue, jitter_buffer, sequencer);
+    PcmPool pool(kMaxInFlight * 2 + 2, kSampleRate / 1000 * frame_ms);
+    SimDecoder decoder(kSampleRate, 1, frame_ms);
+    PostFilter filter;
+    std::mutex frames_mutex;
+    std::vector<Frame> frames;
+    JobSlots<DownlinkScheduler::Job> slots(kMaxInFlight);
+    std::atomic<bool> produced{false};
+    TaskPool task_pool(workers);
+
+    // 生产者：对应协议回调，队列满时稍后重试
+    std::thread producer([&]() {
+        for (size_t i = 0; i < packets.size(); i++) {
+            uint32_t timestamp = jitter_buffer.StampPacket((uint32_t)(i + 1) * frame_ms);
+            if (lost[i]) {
+                continue;
+            }
+            while (!queue.Push(packets[i].data(), packets[i].size(), timestamp, timestamp)) {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+            jitter_buffer.OnPacketArrived(esp_timer_get_time(), queue.Size());
+            if ((i + seed) % 7 == 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(300));
+            }
+        }
+        // 对应 tts stop：剩余帧不再等待预缓冲
+        jitter_buffer.Drain();
+        produced = true;
+    });
+
+    // 调度方：对应 OnAudioOutput，在途帧数不超过任务槽的数量
+    while (true) {
+        auto slot = slots.Acquire();
+        if (slot == nullptr) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            continue;
+        }
+        if (!scheduler.Next(*slot)) {
+            slots.Release(slot);
+            if (produced.load() && queue.Empty() && !scheduler.pending()) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            continue;
+        }
+        // 生产者突发写入，不是实时节奏，抖动缓冲不会要求时间压缩（参考解码中没有压缩）
+        CHECK(!slot->compress, "frame #%u should not be compressed", (unsigned)slot->sequence);
+        task_pool.Schedule([&, slot]() {
+            const auto& job = *slot;
+            uint32_t sequence = job.sequence;
+            PcmPool::Block pcm;
+            Jitter(sequence + seed, 0, 400);
+            sequencer.BeginTurn(DecodeSequencer::kStageDecode, sequence);
+            pcm = pool.Acquire(1000);
+            int samples = -1;
+            if (pcm) {
+                if (job.mode == DownlinkScheduler::kConceal) {
+                    samples = decoder.Conceal(pcm.data(), pcm.capacity());
+                } else if (job.mode == DownlinkScheduler::kFec) {
+                    samples = decoder.DecodeFec(job.data, job.size, pcm.data(), pcm.capacity());
+                } else {
+                    samples = decoder.Decode(job.data, job.size, pcm.data(), pcm.capacity());
+                }
+            }
+            if (samples < 0) {
+                pcm.reset();
+            } else {
+                pcm.resize(samples);
+            }
+            sequencer.EndTurn(DecodeSequencer::kStageDecode, sequence);
+
+            Jitter(sequence + seed, 1, 400);
+            sequencer.BeginTurn(DecodeSequencer::kStageResample, sequence);
+            if (!pcm.empty()) {
+                filter.Process(pcm.data(), pcm.size());
+            }
+            sequencer.EndTurn(DecodeSequencer::kStageResample, sequence);
+
+            Jitter(sequence + seed, 2, 400);
+            // 模式和载荷哈希随帧带到 sink
+            uint32_t payload = Hash(job.data, job.size);
+            int mode = job.mode;
+            pcm.set_trace_id(payload);
+            pcm.set_timestamp((uint32_t)mode);
+            sequencer.Complete(sequence, std::move(pcm), [&](PcmPool::Block&& block) {
+                Frame frame;
+                frame.mode = (int)block.timestamp();
+                frame.payload = block.trace_id();
+                frame.pcm.assign(block.data(), block.data() + block.size());
+                std::lock_guard<std::mutex> lock(frames_mutex);
+                frames.push_back(std::move(frame));
+            });
+            slots.Release(slot);
+        });
+    }
+    producer.join();
+    task_pool.WaitForCompletion();
+    return frames;
+}
+
+static const char* ModeName(int mode) {
+    return mode == DownlinkScheduler::kConceal ? "plc" : mode == DownlinkScheduler::kFec ? "fec" : "normal";
+}
+
+static void Compare(const std::vector<Frame>& expected, const std::vector<Frame>& actual, const char* label) {
+    CHECK(actual.size() == expected.size(), "%s: %zu frames, expected %zu", label, actual.size(), expected.size());
+    size_t count = std::min(actual.size(), expected.size());
+    for (size_t i = 0; i < count; i++) {
+        const auto& a = actual[i];
+        const auto& e = expected[i];
+        if (a.mode != e.mode || a.payload != e.payload) {
+            CHECK(false, "%s: frame %zu is %s/%08x, expected %s/%08x", label, i, ModeName(a.mode), (unsigned)a.payload,
+                ModeName(e.mode), (unsigned)e.payload);
+            return;
+        }
+        if (a.pcm != e.pcm) {
+            CHECK(false, "%s: frame %zu (%s) PCM differs from the inline decode", label, i, ModeName(e.mode));
+            return;
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string p3_path;
+    int max_workers = 4;
+    int runs = 3;
+    size_t synthetic_frames = 300;
+    int frame_ms = 60;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--workers" && i + 1 < argc) {
+            max_workers = atoi(argv[++i]);
+        } else if (arg == "--runs" && i + 1 < argc) {
+            runs = atoi(argv[++i]);
+        } else if (arg == "--frames" && i + 1 < argc) {
+            synthetic_frames = (size_t)atoi(argv[++i]);
+        } else if (arg == "--frame-ms" && i + 1 < argc) {
+            frame_ms = atoi(argv[++i]);
+        } else if (!arg.empty() && arg[0] != '-') {
+            p3_path = arg;
+        } else {
+            fprintf(stderr, "usage: %s [stream.p3] [--workers N] [--runs N] [--frames N] [--frame-ms N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    FakeProtocol::Config protocol_config;
+    protocol_config.frame_duration_ms = frame_ms;
+    FakeProtocol protocol(protocol_config);
+    if (!p3_path.empty()) {
+        if (!protocol.LoadP3(p3_path)) {
+            fprintf(stderr, "Failed to load %s\n", p3_path.c_str());
+            return 1;
+        }
+    } else {
+#if AUDIO_SIM_HAVE_OPUS
+        fprintf(stderr, "A P3 stream is required when built with libopus\n");
+        return 1;
+#else
+        protocol.LoadSynthetic(synthetic_frames, 120);
+        // 合成解码器的输出只取决于调用顺序，耗时调低以便多跑几轮
+        SimDecoder::SetCostUs(200);
+#endif
+    }
+    const auto& packets = protocol.packets();
+
+    for (bool loss : {false, true}) {
+        auto lost = LossPattern(packets.size(), loss);
+        auto expected = DecodeInline(packets, lost, frame_ms);
+        size_t concealed = 0;
+        for (const auto& frame : expected) {
+            concealed += frame.mode != DownlinkScheduler::kNormal ? 1 : 0;
+        }
+        printf("%zu packets%s: %zu reference frames (%zu concealed)\n", packets.size(), loss ? " with loss" : "",
+            expected.size(), concealed);
+        for (int workers = 1; workers <= max_workers; workers *= 2) {
+            for (int run = 0; run < runs; run++) {
+                char label[64];
+                snprintf(label, sizeof(label), "%s, %d workers, run %d", loss ? "loss" : "no loss", workers, run);
+                Compare(expected, DecodePipelined(packets, lost, frame_ms, workers, (uint32_t)run * 7919), label);
+            }
+            printf("  %d workers: %d runs compared\n", workers, runs);
+        }
+    }
+
+    if (g_failures > 0) {
+        printf("%d checks failed\n", g_failures);
+        return 3;
+    }
+    printf("self check: ok\n");
+    return 0;
+}
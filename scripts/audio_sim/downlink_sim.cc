@@ -0,0 +1,209 @@
+#include "downlink_sim.h"
+
+#include <chrono>
+
+#include <esp_timer.h>
+
+DownlinkSim::DownlinkSim(const Config& config, FakeCodec& codec)
+    : config_(config),
+      codec_(codec),
+      audio_decode_queue_(config.max_packets, config.slab_size),
+      jitter_buffer_(config.frame_duration_ms, config.min_prebuffer_ms, config.max_prebuffer_ms),
+      decode_sequencer_(config.max_in_flight),
+      playback_flow_control_(config.max_in_flight, config.max_playback_queue,
+          config.high_watermark, config.low_watermark),
+      downlink_scheduler_(audio_decode_queue_, jitter_buffer_, decode_sequencer_),
+      decode_slots_(config.max_in_flight),
+      opus_decoder_(config.sample_rate, 1, config.frame_duration_ms) {
+    // 与设备一致：PCM 块按最长帧分配，播放队列的帧数按协商后的帧时长换算
+    pcm_pool_ = std::make_unique<PcmPool>(config.pool_blocks, config.sample_rate / 1000 * config.base_frame_duration_ms);
+    playback_flow_control_.SetFrameDuration(config.frame_duration_ms, config.base_frame_duration_ms, config.pool_blocks - 2);
+    decode_task_ = std::make_unique<TaskPool>(config.decode_workers);
+}
+
+DownlinkSim::~DownlinkSim() {
+    running_ = false;
+    playback_cv_.notify_all();
+    if (audio_loop_.joinable()) {
+        audio_loop_.join();
+    }
+    if (playback_.joinable()) {
+        playback_.join();
+    }
+    decode_task_.reset();
+}
+
+void DownlinkSim::Start() {
+    running_ = true;
+    jitter_buffer_.Reset();
+    // AudioLoop：每次读取输入之后调用一次 OnAudioOutput
+    audio_loop_ = std::thread([this]() {
+        auto interval = std::chrono::duration<double, std::milli>(config_.loop_interval_ms / config_.speed);
+        while (running_) {
+            std::this_thread::sleep_for(interval);
+            OnAudioOutput();
+        }
+    });
+    if (!config_.dma_playback) {
+        playback_ = std::thread([this]() { PlaybackLoop(); });
+    }
+}
+
+void DownlinkSim::OnIncomingAudio(const uint8_t* data, size_t size, uint32_t timestamp) {
+    // 以包时间戳作为追踪 ID，输出时据此计算端到端延迟
+    uint32_t stamped = jitter_buffer_.StampPacket(timestamp);
+    if (audio_decode_queue_.Push(data, size, stamped, stamped)) {
+        jitter_buffer_.OnPacketArrived(esp_timer_get_time(), audio_decode_queue_.Size());
+    } else {
+        jitter_buffer_.OnPacketDropped();
+    }
+}
+
+void DownlinkSim::OnFrameOutput(std::function<void(uint32_t timestamp, double delay_ms)> callback) {
+    on_frame_output_ = std::move(callback);
+}
+
+void DownlinkSim::OnAudioOutput() {
+    size_t play_q_size;
+    {
+        std::lock_guard<std::mutex> plock(playback_mutex_);
+        play_q_size = audio_playback_queue_.size();
+    }
+    ring_depth_.Add(audio_decode_queue_.Size());
+    play_queue_depth_.Add(play_q_size);
+    if (!playback_flow_control_.Admit(play_q_size, (int)decode_slots_.in_use())) {
+        return;
+    }
+
+    auto job = decode_slots_.Acquire();
+    if (job == nullptr) {
+        return;
+    }
+    if (!downlink_scheduler_.Next(*job)) {
+        decode_slots_.Release(job);
+        return;
+    }
+    ScheduleDecode(job);
+}
+
+void DownlinkSim::ScheduleDecode(DownlinkScheduler::Job* slot) {
+    int in_flight = (int)decode_slots_.in_use();
+    int seen = max_in_flight_seen_.load();
+    while (in_flight > seen && !max_in_flight_seen_.compare_exchange_weak(seen, in_flight)) {
+    }
+    decode_task_->Schedule([this, slot]() {
+        const auto& job = *slot;
+        PcmPool::Block pcm;
+        uint32_t sequence = job.sequence;
+
+        decode_sequencer_.BeginTurn(DecodeSequencer::kStageDecode, sequence);
+        bool skip = decode_sequencer_.IsStale(sequence);
+        if (!skip) {
+            pcm = pcm_pool_->Acquire(config_.base_frame_duration_ms);
+            if (pcm) {
+                int64_t start_us = ThreadCpuUs();
+                int samples;
+                if (job.mode == DownlinkScheduler::kConceal) {
+                    samples = opus_decoder_.Conceal(pcm.data(), pcm.capacity());
+                } else if (job.mode == DownlinkScheduler::kFec) {
+                    samples = opus_decoder_.DecodeFec(job.data, job.size, pcm.data(), pcm.capacity());
+                } else {
+                    samples = opus_decoder_.Decode(job.data, job.size, pcm.data(), pcm.capacity());
+                }
+                int64_t us = ThreadCpuUs() - start_us;
+                decode_us_.Add(us);
+                decode_busy_us_ += us;
+                if (samples < 0) {
+                    pcm.reset();
+                } else {
+                    pcm.resize(samples);
+                }
+            }
+        }
+        decode_sequencer_.EndTurn(DecodeSequencer::kStageDecode, sequence);
+
+        if (job.compress && !pcm.empty()) {
+            pcm.resize(JitterBuffer::CompressPcm(pcm.data(), pcm.size(), pcm.size() / 10));
+        }
+
+        // 模拟器以输出采样率解码，重采样阶段只保留顺序
+        decode_sequencer_.BeginTurn(DecodeSequencer::kStageResample, sequence);
+        decode_sequencer_.EndTurn(DecodeSequencer::kStageResample, sequence);
+
+        // 只有正常解码的帧计入端到端延迟
+        pcm.set_trace_id(job.mode == DownlinkScheduler::kNormal ? job.trace_id : 0);
+        decode_sequencer_.Complete(sequence, std::move(pcm), [this](PcmPool::Block&& frame) {
+            if (config_.dma_playback) {
+                OutputFrame(std::move(frame));
+                return;
+            }
+            std::lock_guard<std::mutex> plock(playback_mutex_);
+            audio_playback_queue_.emplace_back(std::move(frame));
+            playback_cv_.notify_one();
+        });
+        decode_slots_.Release(slot);
+    });
+}
+
+void DownlinkSim::PlaybackLoop() {
+    while (true) {
+        std::unique_lock<std::mutex> lock(playback_mutex_);
+        playback_cv_.wait(lock, [this]() { return !running_ || !audio_playback_queue_.empty(); });
+        if (audio_playback_queue_.empty()) {
+            return;
+        }
+        auto pcm = std::move(audio_playback_queue_.front());
+        audio_playback_queue_.pop_front();
+        bool now_empty = audio_playback_queue_.empty();
+        lock.unlock();
+        OutputFrame(std::move(pcm));
+        if (now_empty) {
+            playback_cv_.notify_all();
+        }
+    }
+}
+
+void DownlinkSim::OutputFrame(PcmPool::Block&& frame) {
+    if (frame.trace_id() != 0 && on_frame_output_) {
+        on_frame_output_(frame.trace_id(), codec_.BufferedSamples() * 1000.0 / config_.sample_rate);
+    }
+    codec_.OutputData(frame.data(), frame.size());
+}
+
+void DownlinkSim::Finish() {
+    jitter_buffer_.Drain();
+    auto frame = std::chrono::duration<double, std::milli>(config_.frame_duration_ms / config_.speed);
+    while (!audio_decode_queue_.Empty() || downlink_scheduler_.pending()) {
+        std::this_thread::sleep_for(frame);
+    }
+    decode_task_->WaitForCompletion();
+    {
+        std::unique_lock<std::mutex> plock(playback_mutex_);
+        playback_cv_.wait(plock, [this]() { return audio_playback_queue_.empty(); });
+    }
+    while (codec_.BufferedSamples() > 0) {
+        std::this_thread::sleep_for(frame / 6);
+    }
+}
+
+DownlinkSim::Report DownlinkSim::GetReport() {
+    Report report;
+    report.decoded_frames = decode_us_.count();
+    report.decode_us_p50 = decode_us_.Percentile(50);
+    report.decode_us_p99 = decode_us_.Percentile(99);
+    report.decode_us_max = decode_us_.Max();
+    int64_t busy_us = decode_busy_us_.load();
+    report.decode_frames_per_sec = busy_us > 0 ? report.decoded_frames * 1e6 / busy_us : 0;
+    report.decode_busy_ms = busy_us / 1000.0;
+    report.ring_depth_mean = ring_depth_.Mean();
+    report.ring_depth_max = ring_depth_.Max();
+    report.play_queue_mean = play_queue_depth_.Mean();
+    report.play_queue_max = play_queue_depth_.Max();
+    report.reorder_high_water = decode_sequencer_.reorder_high_water();
+    report.max_in_flight = max_in_flight_seen_.load();
+    report.jitter = jitter_buffer_.GetStats();
+    report.pool = pcm_pool_->GetStats();
+    report.flow = playback_flow_control_.GetStats();
+    report.output = codec_.GetStats();
+    return report;
+}
@@ -0,0 +1,115 @@
+#ifndef AUDIO_SIM_DOWNLINK_SIM_H
+#define AUDIO_SIM_DOWNLINK_SIM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "packet_ring.h"
+#include "jitter_buffer.h"
+#include "decode_sequencer.h"
+#include "pcm_pool.h"
+#include "playback_flow_control.h"
+#include "downlink_scheduler.h"
+#include "job_slots.h"
+#include "sim_codecs.h"
+#include "sim_stats.h"
+#include "task_pool.h"
+#include "fake_codec.h"
+
+// Application 下行链路的主机版本：组件（环形队列、抖动缓冲、保序器、PCM 块池、准入控制、解码器）
+// 以及取包和丢包补偿的调度（DownlinkScheduler）与设备共用同一份代码，其余流程对应
+// Application::OnIncomingAudio / OnAudioOutput / ScheduleDecode 和播放任务
+// 模拟器直接以输出采样率解码，不经过重采样阶段
+class DownlinkSim {
+public:
+    struct Config {
+        int sample_rate = 24000;
+        int frame_duration_ms = 60;         // 协商后的帧时长（20/40/60）
+        int base_frame_duration_ms = 60;    // OPUS_FRAME_DURATION_MS：PCM 块大小和下面的帧数按它计
+        size_t max_packets = 200;           // MAX_AUDIO_PACKETS_IN_QUEUE
+        size_t slab_size = 24 * 1024;       // AUDIO_DECODE_SLAB_SIZE
+        int decode_workers = 1;             // AUDIO_DECODE_WORKERS
+        int max_in_flight = 4;              // AUDIO_DECODE_MAX_IN_FLIGHT
+        int max_playback_queue = 3;         // MAX_PLAYBACK_TASKS_IN_QUEUE
+        int high_watermark = 2;
+        int low_watermark = 1;
+        size_t pool_blocks = 8;             // AUDIO_PCM_POOL_BLOCKS
+        int min_prebuffer_ms = 120;
+        int max_prebuffer_ms = 600;
+        bool dma_playback = false;          // CONFIG_USE_DMA_CALLBACK_PLAYBACK
+        int loop_interval_ms = 10;          // AudioLoop 每次读取输入的间隔，决定 OnAudioOutput 的调用频率
+        double speed = 1.0;
+    };
+
+    struct Report {
+        size_t decoded_frames = 0;
+        double decode_us_p50 = 0;
+        double decode_us_p99 = 0;
+        double decode_us_max = 0;
+        double decode_frames_per_sec = 0;   // 解码线程的纯解码吞吐（帧/秒 CPU 时间）
+        double decode_busy_ms = 0;          // 解码占用的 CPU 时间合计
+        double ring_depth_mean = 0;
+        double ring_depth_max = 0;
+        double play_queue_mean = 0;
+        double play_queue_max = 0;
+        size_t reorder_high_water = 0;
+        int max_in_flight = 0;              // 观察到的在途解码帧数峰值，不应超过 Config::max_in_flight
+        JitterBuffer::Stats jitter;
+        PcmPool::Stats pool;
+        PlaybackFlowControl::Stats flow;
+        DmaPlaybackRing::Stats output;
+    };
+
+    DownlinkSim(const Config& config, FakeCodec& codec);
+    ~DownlinkSim();
+
+    void Start();
+    // 对应 Application::OnIncomingAudio 回调
+    void OnIncomingAudio(const uint8_t* data, size_t size, uint32_t timestamp);
+    // 每个正常解码的帧交给输出之前回调：timestamp 为包时间戳，delay_ms 为此刻输出缓冲中排在它前面的音频时长
+    void OnFrameOutput(std::function<void(uint32_t timestamp, double delay_ms)> callback);
+    // 对应 tts stop：排空抖动缓冲并等待所有帧播放完毕
+    void Finish();
+    Report GetReport();
+
+private:
+    Config config_;
+    FakeCodec& codec_;
+    PacketRing audio_decode_queue_;
+    JitterBuffer jitter_buffer_;
+    DecodeSequencer decode_sequencer_;
+    PlaybackFlowControl playback_flow_control_;
+    std::unique_ptr<PcmPool> pcm_pool_;
+    std::deque<PcmPool::Block> audio_playback_queue_;
+    std::mutex playback_mutex_;
+    std::condition_variable playback_cv_;
+    std::atomic<int> max_in_flight_seen_{0};
+    DownlinkScheduler downlink_scheduler_;
+    JobSlots<DownlinkScheduler::Job> decode_slots_;
+    SimDecoder opus_decoder_;
+    std::unique_ptr<TaskPool> decode_task_;
+
+    std::atomic<bool> running_{false};
+    std::thread audio_loop_;
+    std::thread playback_;
+
+    SampleStats decode_us_;
+    SampleStats ring_depth_;
+    SampleStats play_queue_depth_;
+    std::atomic<int64_t> decode_busy_us_{0};
+
+    void OnAudioOutput();
+    std::function<void(uint32_t timestamp, double delay_ms)> on_frame_output_;
+
+    void ScheduleDecode(DownlinkScheduler::Job* slot);
+    void OutputFrame(PcmPool::Block&& frame);
+    void PlaybackLoop();
+};
+
+#endif // AUDIO_SIM_DOWNLINK_SIM_H
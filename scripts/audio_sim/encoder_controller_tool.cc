@@ -0,0 +1,201 @@
+// EncoderController（上行 Opus 编码参数自适应）的主机自检
+// 按评估窗口喂入编码耗时和发送队列深度，逐窗口检查：
+// - CPU 过载（平均或单帧峰值）时复杂度立即降 2 档直到下限，负载居中时保持，持续空闲才每 recover_windows 个窗口升 1 档
+// - 发送积压、失败或丢帧时码率立即乘 0.75 并打开 DTX 和受限 VBR，持续通畅才逐步回升，回到上限后恢复配置的 DTX/VBR
+// - 拥塞和通畅交替时不回升（回升需要连续的通畅窗口）
+//   encoder_controller_tool [--verbose]
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "encoder_controller.h"
+
+static const int kFrameMs = 60;
+static bool g_verbose = false;
+static int g_failures = 0;
+
+#define CHECK(condition, ...)                                       \
+    do {                                                            \
+        if (!(condition)) {                                         \
+            fprintf(stderr, "%s:%d: check failed: %s: ", __FILE__, __LINE__, #condition); \
+            fprintf(stderr, __VA_ARGS__);                           \
+            fprintf(stderr, "\n");                                  \
+            g_failures++;                                           \
+        }                                                           \
+    } while (0)
+
+struct Window {
+    float load = 0.05f;         // 平均编码耗时 / 帧时长
+    float peak = 0;             // 窗口内单帧的最大负载，0 表示与平均相同
+    size_t depth = 1;           // 发送时的队列深度
+    bool send_failure = false;
+    bool dropped = false;
+};
+
+// 喂满一个评估窗口（1 秒音频）后评估，返回评估后的参数
+static EncoderController::Settings RunWindow(EncoderController& controller, const Window& window) {
+    int frames = 1000 / kFrameMs;
+    uint32_t frame_us = kFrameMs * 1000;
+    for (int i = 0; i < frames; i++) {
+        float load = (i == 0 && window.peak > 0) ? window.peak : window.load;
+        controller.OnFrameEncoded((uint32_t)(load * frame_us));
+        controller.OnSend(window.depth, !(window.send_failure && i == 0));
+    }
+    if (window.dropped) {
+        controller.OnDropped();
+    }
+    EncoderController::Settings settings;
+    bool changed = controller.Evaluate(settings);
+    settings = controller.settings();
+    if (g_verbose) {
+        printf("    load %.2f depth %zu -> complexity %d bitrate %d vbr %d cvbr %d dtx %d%s\n", window.load, window.depth,
+            settings.complexity, settings.bitrate, settings.vbr, settings.constrained_vbr, settings.dtx, changed ? " (changed)" : "");
+    }
+    return settings;
+}
+
+static EncoderController::Limits DefaultLimits() {
+    EncoderController::Limits limits;
+    limits.min_complexity = 0;
+    limits.max_complexity = 5;
+    limits.min_bitrate = 12000;
+    limits.max_bitrate = 24000;
+    limits.bitrate_step = 2000;
+    limits.vbr = true;
+    limits.dtx = false;
+    return limits;
+}
+
+static void TestComplexity() {
+    printf("complexity step-down and recovery\n");
+    auto limits = DefaultLimits();
+    EncoderController controller;
+    controller.Configure(limits, 5, kFrameMs);
+
+    // 未满一个窗口不评估
+    EncoderController::Settings settings;
+    controller.OnFrameEncoded(kFrameMs * 1000);
+    CHECK(!controller.Evaluate(settings), "evaluated before the window was full");
+
+    controller.Configure(limits, 5, kFrameMs);
+    Window overload;
+    overload.load = 0.4f;
+    CHECK(RunWindow(controller, overload).complexity == 3, "mean overload should drop 2 steps");
+    CHECK(RunWindow(controller, overload).complexity == 1, "second overload window should drop 2 more");
+    CHECK(RunWindow(controller, overload).complexity == 0, "should clamp at min_complexity");
+    CHECK(RunWindow(controller, overload).complexity == 0, "should stay at min_complexity");
+
+    // 负载居中（low_load 和 high_load 之间）：保持
+    Window middle;
+    middle.load = 0.18f;
+    for (int i = 0; i < limits.recover_windows * 2; i++) {
+        CHECK(RunWindow(controller, middle).complexity == 0, "middle load window %d should hold", i);
+    }
+
+    // 持续空闲：每 recover_windows 个窗口升 1 档，直到上限
+    Window idle;
+    idle.load = 0.05f;
+    for (int step = 1; step <= limits.max_complexity; step++) {
+        for (int i = 1; i < limits.recover_windows; i++) {
+            CHECK(RunWindow(controller, idle).complexity == step - 1, "recovered before %d idle windows", limits.recover_windows);
+        }
+        CHECK(RunWindow(controller, idle).complexity == step, "should recover to %d", step);
+    }
+    CHECK(RunWindow(controller, idle).complexity == limits.max_complexity, "should clamp at max_complexity");
+
+    // 单帧峰值过载也立即下调，之后空闲计数重新开始
+    Window spike;
+    spike.load = 0.05f;
+    spike.peak = 0.6f;
+    CHECK(RunWindow(controller, spike).complexity == limits.max_complexity - 2, "peak overload should drop 2 steps");
+    for (int i = 1; i < limits.recover_windows; i++) {
+        RunWindow(controller, idle);
+    }
+    CHECK(RunWindow(controller, idle).complexity == limits.max_complexity - 1, "should recover 1 step after the spike");
+
+    auto stats = controller.GetStats();
+    CHECK(stats.complexity_down == 4 && stats.complexity_up == 6, "stats down %u up %u", (unsigned)stats.complexity_down,
+        (unsigned)stats.complexity_up);
+}
+
+static void TestBitrate() {
+    printf("bitrate step-down and recovery\n");
+    auto limits = DefaultLimits();
+    EncoderController controller;
+    controller.Configure(limits, 0, kFrameMs);
+    auto settings = controller.settings();
+    CHECK(settings.bitrate == limits.max_bitrate && !settings.dtx && !settings.constrained_vbr, "should start at max bitrate");
+
+    Window congested;
+    congested.depth = limits.congested_depth;
+    settings = RunWindow(controller, congested);
+    CHECK(settings.bitrate == 18000, "backlog should cut bitrate to 0.75x, got %d", settings.bitrate);
+    CHECK(settings.dtx && settings.constrained_vbr, "backlog should enable DTX and constrained VBR");
+    settings = RunWindow(controller, congested);
+    CHECK(settings.bitrate == 13500, "second backlog window, got %d", settings.bitrate);
+    settings = RunWindow(controller, congested);
+    CHECK(settings.bitrate == limits.min_bitrate, "should clamp at min_bitrate, got %d", settings.bitrate);
+
+    // 发送失败和丢帧同样视为拥塞
+    controller.Configure(limits, 0, kFrameMs);
+    Window failure;
+    failure.send_failure = true;
+    CHECK(RunWindow(controller, failure).bitrate == 18000, "send failure should cut bitrate");
+    Window dropped;
+    dropped.dropped = true;
+    CHECK(RunWindow(controller, dropped).bitrate == 13500, "dropped frame should cut bitrate");
+
+    // 积压 2（介于通畅和拥塞之间）：不降也不升
+    Window busy;
+    busy.depth = 2;
+    for (int i = 0; i < limits.recover_windows * 2; i++) {
+        CHECK(RunWindow(controller, busy).bitrate == 13500, "depth 2 window %d should hold", i);
+    }
+
+    // 拥塞和通畅交替：通畅窗口不连续，不回升
+    Window clear;
+    for (int i = 0; i < limits.recover_windows * 2; i++) {
+        RunWindow(controller, clear);
+        RunWindow(controller, i % 2 == 0 ? busy : clear);
+    }
+    CHECK(controller.settings().bitrate == 13500, "alternating windows should not recover, got %d", controller.settings().bitrate);
+
+    // 持续通畅：每 recover_windows 个窗口回升 bitrate_step，回到上限后恢复 DTX/VBR 配置
+    controller.Configure(limits, 0, kFrameMs);
+    RunWindow(controller, congested);
+    RunWindow(controller, congested);
+    int expected = 13500;
+    while (expected < limits.max_bitrate) {
+        for (int i = 1; i < limits.recover_windows; i++) {
+            settings = RunWindow(controller, clear);
+            CHECK(settings.bitrate == expected, "recovered too early, got %d", settings.bitrate);
+        }
+        expected = std::min(expected + limits.bitrate_step, limits.max_bitrate);
+        settings = RunWindow(controller, clear);
+        CHECK(settings.bitrate == expected, "should recover to %d, got %d", expected, settings.bitrate);
+        if (expected < limits.max_bitrate) {
+            CHECK(settings.dtx && settings.constrained_vbr, "DTX/constrained VBR should stay on below max bitrate");
+        }
+    }
+    CHECK(!settings.dtx && !settings.constrained_vbr && settings.vbr, "configured DTX/VBR should be restored at max bitrate");
+    auto stats = controller.GetStats();
+    CHECK(stats.bitrate_down == 2 && stats.bitrate_up == 6, "stats down %u up %u", (unsigned)stats.bitrate_down,
+        (unsigned)stats.bitrate_up);
+}
+
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--verbose") == 0) {
+            g_verbose = true;
+        }
+    }
+    TestComplexity();
+    TestBitrate();
+    if (g_failures > 0) {
+        printf("%d checks failed\n", g_failures);
+        return 3;
+    }
+    printf("self check: ok\n");
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include "fake_codec.h"
+
+#include <chrono>
+#include <vector>
+
+FakeCodec::FakeCodec(int sample_rate, size_t dma_frame_samples, size_t buffer_samples, double speed)
+    : sample_rate_(sample_rate),
+      dma_frame_samples_(dma_frame_samples),
+      speed_(speed),
+      ring_(buffer_samples) {
+}
+
+FakeCodec::~FakeCodec() {
+    Stop();
+}
+
+void FakeCodec::Start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    thread_ = std::thread([this]() { ConsumerLoop(); });
+}
+
+void FakeCodec::Stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    space_cv_.notify_all();
+    thread_.join();
+}
+
+void FakeCodec::OutputData(const int16_t* pcm, size_t samples) {
+    while (samples > 0) {
+        size_t contiguous;
+        int32_t* dest = ring_.PrepareWrite(contiguous);
+        if (contiguous == 0) {
+            // 缓冲已满：等待消费线程腾出一个 DMA 帧
+            std::unique_lock<std::mutex> lock(mutex_);
+            space_cv_.wait_for(lock, std::chrono::milliseconds(10));
+            if (!running_) {
+                return;
+            }
+            continue;
+        }
+        size_t n = contiguous < samples ? contiguous : samples;
+        for (size_t i = 0; i < n; i++) {
+            dest[i] = pcm[i];
+        }
+        ring_.CommitWrite(n);
+        pcm += n;
+        samples -= n;
+    }
+}
+
+void FakeCodec::ConsumerLoop() {
+    std::vector<int32_t> dma_buffer(dma_frame_samples_);
+    auto period = std::chrono::duration<double>(dma_frame_samples_ / (double)sample_rate_ / speed_);
+    auto next = std::chrono::steady_clock::now();
+    while (running_) {
+        next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(period);
+        std::this_thread::sleep_until(next);
+        ring_.Fill(dma_buffer.data(), dma_buffer.size());
+        space_cv_.notify_all();
+    }
+}
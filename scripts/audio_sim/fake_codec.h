@@ -0,0 +1,45 @@
+#ifndef AUDIO_SIM_FAKE_CODEC_H
+#define AUDIO_SIM_FAKE_CODEC_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <cstdint>
+#include <cstddef>
+
+#include "dma_playback_ring.h"
+
+// 模拟 I2S 输出的编解码器：后台线程按采样率（乘以 speed）每次消费一个 DMA 帧的样本
+// 样本缓冲复用设备上的 DmaPlaybackRing：
+// - 播放任务模式：缓冲等于 DMA 描述符总长度，写满时 OutputData 阻塞，相当于 i2s_channel_write
+// - DMA 回调模式：缓冲为 AUDIO_CODEC_DMA_RING_MS 对应的长度，与 NoAudioCodec 的回调播放一致
+// 数据不足时输出静音，并由 DmaPlaybackRing 统计欠载
+class FakeCodec {
+public:
+    FakeCodec(int sample_rate, size_t dma_frame_samples, size_t buffer_samples, double speed);
+    ~FakeCodec();
+
+    void Start();
+    void Stop();
+
+    // 单生产者：写入样本，缓冲满时阻塞等待
+    void OutputData(const int16_t* pcm, size_t samples);
+    size_t BufferedSamples() const { return ring_.Size(); }
+    int sample_rate() const { return sample_rate_; }
+    DmaPlaybackRing::Stats GetStats() const { return ring_.GetStats(); }
+
+private:
+    const int sample_rate_;
+    const size_t dma_frame_samples_;
+    const double speed_;
+    DmaPlaybackRing ring_;
+    std::mutex mutex_;
+    std::condition_variable space_cv_;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+
+    void ConsumerLoop();
+};
+
+#endif // AUDIO_SIM_FAKE_CODEC_H
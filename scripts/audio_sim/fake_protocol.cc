@@ -0,0 +1,179 @@
+#include "fake_protocol.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <random>
+
+FakeProtocol::FakeProtocol(const Config& config) : config_(config), loopback_rng_(config.seed) {
+    uplink_batcher_.SetLatencyBudget(config.uplink_batch_ms);
+    uplink_publisher_ = [this](std::string& payload, int frames) {
+        return Publish(payload, frames);
+    };
+}
+
+FakeProtocol::~FakeProtocol() {
+    Join();
+}
+
+bool FakeProtocol::LoadP3(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    // BinaryProtocol3：type(1) + reserved(1) + payload_size(2，网络字节序) + payload
+    size_t offset = 0;
+    while (offset + 4 <= data.size()) {
+        size_t payload_size = (size_t(data[offset + 2]) << 8) | data[offset + 3];
+        if (offset + 4 + payload_size > data.size()) {
+            break;
+        }
+        packets_.emplace_back(data.begin() + offset + 4, data.begin() + offset + 4 + payload_size);
+        offset += 4 + payload_size;
+    }
+    return !packets_.empty();
+}
+
+void FakeProtocol::LoadSynthetic(size_t frames, size_t packet_size) {
+    packets_.assign(frames, std::vector<uint8_t>(packet_size, 0));
+    for (size_t i = 0; i < frames; i++) {
+        packets_[i][0] = (uint8_t)i;
+    }
+}
+
+void FakeProtocol::OnIncomingAudio(std::function<void(const uint8_t*, size_t, uint32_t)> callback) {
+    on_incoming_audio_ = callback;
+}
+
+void FakeProtocol::Start() {
+    if (config_.loopback) {
+        loopback_start_ = std::chrono::steady_clock::now();
+        thread_ = std::thread([this]() { LoopbackLoop(); });
+        return;
+    }
+    thread_ = std::thread([this]() {
+        std::mt19937 rng(config_.seed);
+        std::exponential_distribution<double> delay(config_.jitter_ms > 0 ? 1.0 / config_.jitter_ms : 1.0);
+        std::uniform_real_distribution<double> uniform(0, 1);
+
+        auto start = std::chrono::steady_clock::now();
+        double deliver_ms = 0;
+        for (size_t i = 0; i < packets_.size(); i++) {
+            double nominal_ms = i * config_.frame_duration_ms;
+            double jitter = config_.jitter_ms > 0 ? delay(rng) : 0;
+            // 有序传输：后发的包不会早于前一个包到达
+            deliver_ms = std::max(deliver_ms, nominal_ms + jitter);
+            if (config_.loss > 0 && uniform(rng) < config_.loss) {
+                lost_packets_++;
+                continue;
+            }
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double, std::milli>(deliver_ms / config_.speed)));
+            // 时间戳 0 表示传输层没有时间戳，因此从一帧时长开始计
+            uint32_t timestamp = config_.timestamps ? (uint32_t)(nominal_ms + config_.frame_duration_ms) : 0;
+            on_incoming_audio_(packets_[i].data(), packets_[i].size(), timestamp);
+        }
+    });
+}
+
+void FakeProtocol::Join() {
+    FlushAudio();
+    if (config_.loopback) {
+        std::lock_guard<std::mutex> lock(loopback_mutex_);
+        loopback_closing_ = true;
+        loopback_cv_.notify_all();
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+// 与 MqttProtocol::PublishOverhead 相同的估算：MQTT 固定头 + 主题（"stt/doll/<设备号>/zh"）+ TCP/IPv4 头
+static size_t PublishOverhead(size_t payload_size) {
+    const size_t topic_size = 27;
+    size_t remaining = 2 + topic_size + payload_size;
+    size_t length_bytes = remaining < 128 ? 1 : remaining < 16384 ? 2 : 3;
+    return 1 + length_bytes + 2 + topic_size + 40;
+}
+
+void FakeProtocol::SendAudio(std::vector<uint8_t>&& packet) {
+    sent_packets_++;
+    sent_bytes_ += packet.size();
+    unbatched_wire_bytes_ += packet.size() + PublishOverhead(packet.size());
+    std::lock_guard<std::mutex> lock(uplink_mutex_);
+    uplink_batcher_.Add(packet.data(), packet.size(), config_.frame_duration_ms, uplink_publisher_);
+}
+
+void FakeProtocol::FlushAudio() {
+    std::lock_guard<std::mutex> lock(uplink_mutex_);
+    uplink_batcher_.Flush(uplink_publisher_);
+}
+
+// 在 uplink_mutex_ 内调用，一次发布对应一个网络包
+bool FakeProtocol::Publish(const std::string& payload, int frames) {
+    publishes_++;
+    wire_bytes_ += payload.size() + PublishOverhead(payload.size());
+    uint32_t first_frame = uplink_frames_;
+    uplink_frames_ += frames;
+    if (!config_.loopback) {
+        return true;
+    }
+
+    // 与回放模式相同的网络模型：指数分布的延迟抖动、有序送达、随机丢包（整个容器一起丢）
+    std::exponential_distribution<double> delay(config_.jitter_ms > 0 ? 1.0 / config_.jitter_ms : 1.0);
+    std::uniform_real_distribution<double> uniform(0, 1);
+    std::lock_guard<std::mutex> lock(loopback_mutex_);
+    if (config_.loss > 0 && uniform(loopback_rng_) < config_.loss) {
+        lost_packets_ += frames;
+        return true;
+    }
+    double sent_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - loopback_start_).count() * config_.speed;
+    double jitter = config_.jitter_ms > 0 ? delay(loopback_rng_) : 0;
+    loopback_deliver_ms_ = std::max(loopback_deliver_ms_, sent_ms + jitter);
+    auto deliver_at = loopback_start_ + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double, std::milli>(loopback_deliver_ms_ / config_.speed));
+
+    // 服务端侧：攒包时拆开容器，各帧按原始顺序送回下行
+    uint32_t index = first_frame;
+    auto deliver = [&](const uint8_t* frame, size_t size) {
+        LoopbackPacket loopback;
+        loopback.payload.assign(frame, frame + size);
+        loopback.deliver_at = deliver_at;
+        loopback.timestamp = config_.timestamps ? (index + 1) * config_.frame_duration_ms : 0;
+        loopback_queue_.emplace_back(std::move(loopback));
+        index++;
+    };
+    auto data = reinterpret_cast<const uint8_t*>(payload.data());
+    if (uplink_batcher_.MaxFrames(config_.frame_duration_ms) > 1) {
+        if (!UplinkBatcher::Unpack(data, payload.size(), deliver)) {
+            fprintf(stderr, "invalid uplink container (%zu bytes)\n", payload.size());
+        }
+    } else {
+        deliver(data, payload.size());
+    }
+    loopback_cv_.notify_all();
+    return true;
+}
+
+void FakeProtocol::LoopbackLoop() {
+    std::unique_lock<std::mutex> lock(loopback_mutex_);
+    while (true) {
+        loopback_cv_.wait(lock, [this]() { return loopback_closing_ || !loopback_queue_.empty(); });
+        if (loopback_queue_.empty()) {
+            return;
+        }
+        auto deliver_at = loopback_queue_.front().deliver_at;
+        if (std::chrono::steady_clock::now() < deliver_at) {
+            loopback_cv_.wait_until(lock, deliver_at);
+            continue;
+        }
+        auto packet = std::move(loopback_queue_.front());
+        loopback_queue_.pop_front();
+        lock.unlock();
+        on_incoming_audio_(packet.payload.data(), packet.payload.size(), packet.timestamp);
+        lock.lock();
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef AUDIO_SIM_FAKE_PROTOCOL_H
+#define AUDIO_SIM_FAKE_PROTOCOL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "uplink_batcher.h"
+
+// 模拟下行协议：把抓取的 Opus 流（P3 文件）按帧间隔回放给 OnIncomingAudio 回调
+// - jitter_ms：每包附加指数分布的网络延迟（均值），TCP 语义下保持顺序（队头阻塞）
+// - loss：丢包概率，模拟 MQTT+UDP 音频通道；timestamps 为 true 时随包携带时间戳，否则为 0
+// 同时记录上行 SendAudio 的包数和字节数
+// loopback 为 true 时不回放 P3，而是把上行包经过同样的延迟/丢包模型原样送回下行（相当于回声服务器），
+// 用于测量端到端（口到耳）延迟
+// uplink_batch_ms > 0 时上行与 MqttProtocol 一样经 UplinkBatcher 攒包，网络模型按发布（容器）计，
+// 并统计发布次数和估算的空中字节数
+class FakeProtocol {
+public:
+    struct Config {
+        int frame_duration_ms = 60;
+        double speed = 1.0;
+        double jitter_ms = 0;
+        double loss = 0;
+        bool timestamps = true;
+        bool loopback = false;
+        int uplink_batch_ms = 0;
+        unsigned seed = 1;
+    };
+
+    explicit FakeProtocol(const Config& config);
+    ~FakeProtocol();
+
+    bool LoadP3(const std::string& path);
+    // 没有 Opus 时使用的合成流：frames 个大小为 packet_size 的包
+    void LoadSynthetic(size_t frames, size_t packet_size);
+    const std::vector<std::vector<uint8_t>>& packets() const { return packets_; }
+
+    void OnIncomingAudio(std::function<void(const uint8_t* data, size_t size, uint32_t timestamp)> callback);
+    void Start();
+    // 等待全部包发送完毕（相当于服务器发出 tts stop）；回环模式下等待已上行的包全部送回
+    void Join();
+
+    void SendAudio(std::vector<uint8_t>&& packet);
+    // 说话结束：发出攒着的帧（Join 时也会调用）
+    void FlushAudio();
+    size_t sent_packets() const { return sent_packets_; }
+    size_t sent_bytes() const { return sent_bytes_; }
+    size_t publishes() const { return publishes_; }
+    size_t wire_bytes() const { return wire_bytes_; }
+    size_t unbatched_wire_bytes() const { return unbatched_wire_bytes_; }
+    size_t lost_packets() const { return lost_packets_; }
+
+private:
+    Config config_;
+    std::vector<std::vector<uint8_t>> packets_;
+    std::function<void(const uint8_t*, size_t, uint32_t)> on_incoming_audio_;
+    std::thread thread_;
+    std::atomic<size_t> sent_packets_{0};
+    std::atomic<size_t> sent_bytes_{0};
+    size_t lost_packets_ = 0;
+
+    std::mutex uplink_mutex_;
+    UplinkBatcher uplink_batcher_{1024};
+    UplinkBatcher::Publisher uplink_publisher_;
+    uint32_t uplink_frames_ = 0;
+    std::atomic<size_t> publishes_{0};
+    std::atomic<size_t> wire_bytes_{0};
+    std::atomic<size_t> unbatched_wire_bytes_{0};
+    bool Publish(const std::string& payload, int frames);
+
+    // 回环模式：上行包按送达时间排队，由 thread_ 送回下行
+    struct LoopbackPacket {
+        std::vector<uint8_t> payload;
+        std::chrono::steady_clock::time_point deliver_at;
+        uint32_t timestamp;
+    };
+    std::mutex loopback_mutex_;
+    std::condition_variable loopback_cv_;
+    std::deque<LoopbackPacket> loopback_queue_;
+    bool loopback_closing_ = false;
+    std::chrono::steady_clock::time_point loopback_start_;
+    double loopback_deliver_ms_ = 0;
+    std::mt19937 loopback_rng_;
+    void LoopbackLoop();
+};
+
+#endif // AUDIO_SIM_FAKE_PROTOCOL_H
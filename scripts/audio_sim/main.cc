@@ -0,0 +1,305 @@
+// 主机音频流水线模拟器：在 Linux 上运行与设备相同的下行/上行调度逻辑，
+// 用假的编解码器按实时节奏消费 PCM，用假的协议回放抓取的 Opus 流（P3 文件），
+// 输出解码吞吐、队列深度和欠载等指标，便于在烧录前比较改动
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "downlink_sim.h"
+#include "uplink_sim.h"
+#include "fake_codec.h"
+#include "fake_protocol.h"
+
+static void PrintUsage(const char* program) {
+    fprintf(stderr,
+        "Usage: %s [options] [stream.p3]\n"
+        "  --speed N            时间倍速（默认 1，>1 加速回放和播放）\n"
+        "  --sample-rate N      解码/输出采样率（默认 24000）\n"
+        "  --jitter-ms N        网络延迟抖动均值（默认 0）\n"
+        "  --loss P             丢包率 0~1（默认 0）\n"
+        "  --no-timestamps      下行包不带时间戳（MQTT/WebSocket v1）\n"
+        "  --workers N          解码线程数（默认 1）\n"
+        "  --dma                模拟 DMA 回调播放（不使用播放任务）\n"
+        "  --loop-ms N          AudioLoop 调用 OnAudioOutput 的间隔（默认 10）\n"
+        "  --uplink             同时模拟上行采集与编码\n"
+        "  --frame-ms N         上下行帧时长 20/40/60（默认 60）\n"
+        "  --uplink-batch-ms N  上行按 N 毫秒的延迟预算攒包发布（默认 0，逐帧发布）\n"
+        "  --uplink-pause-ms N  上行每说 3 秒停顿 N 毫秒，按 VAD 静音抑制（默认 0，一直说话）\n"
+        "  --frames N           没有 P3 文件时合成的帧数（默认 500）\n"
+        "  --decode-cost-us N   合成解码器每帧耗时（仅无 libopus 时，默认 2000）\n"
+        "  --bench-decode       只测量解码吞吐后退出\n"
+        "  --bench-frame-durations\n"
+        "                       依次以 20/40/60ms 帧时长运行回环（上行编码 -> 网络 -> 下行播放），\n"
+        "                       输出每秒音频的 CPU 时间和口到耳延迟；不需要 P3 文件\n"
+        "  --seconds N          每个帧时长的回环时长（默认 20）\n",
+        program);
+}
+
+static void BenchDecode(const std::vector<std::vector<uint8_t>>& packets, int sample_rate, int frame_duration_ms) {
+    SimDecoder decoder(sample_rate, 1, frame_duration_ms);
+    std::vector<int16_t> pcm(decoder.frame_samples() * 2);
+    size_t frames = 0;
+    size_t samples = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& packet : packets) {
+        int n = decoder.Decode(packet.data(), packet.size(), pcm.data(), pcm.size());
+        if (n > 0) {
+            frames++;
+            samples += n;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double audio_seconds = (double)samples / sample_rate;
+    printf("decode: frames=%zu time=%.3fs throughput=%.0f frames/s realtime=%.1fx\n",
+        frames, seconds, seconds > 0 ? frames / seconds : 0, seconds > 0 ? audio_seconds / seconds : 0);
+}
+
+static double ProcessCpuMs() {
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// 回环测量：模拟麦克风按帧时长采集并编码上行，FakeProtocol 原样送回下行，经抖动缓冲、解码后播放
+// 口到耳延迟 = 帧的第一个样本被播放的时刻 - 它被采集的时刻（含编码、网络、抖动缓冲、解码和输出缓冲）
+static void BenchFrameDurations(const DownlinkSim::Config& downlink_base, const FakeProtocol::Config& protocol_base,
+    double seconds) {
+#if !AUDIO_SIM_HAVE_OPUS
+    // 没有 libopus：编解码是按帧时长建模的忙等，codec_ms/s 和 cpu_ms/s 中的编解码部分只是模型，不是实测
+    printf("note: synthetic codec, codec cost is MODELLED (busy-wait, --decode-cost-us), not measured\n");
+#endif
+    printf("frame_ms  cpu_ms/s  codec_ms/s  m2e_p50_ms  m2e_p99_ms  underruns  uplink_kbps  publishes/s  air_kbps\n");
+    for (int frame_ms : {20, 40, 60}) {
+        DownlinkSim::Config downlink = downlink_base;
+        downlink.frame_duration_ms = frame_ms;
+        FakeProtocol::Config protocol_config = protocol_base;
+        protocol_config.frame_duration_ms = frame_ms;
+        protocol_config.loopback = true;
+        UplinkSim::Config uplink_config;
+        uplink_config.frame_duration_ms = frame_ms;
+        uplink_config.speed = downlink.speed;
+
+        size_t dma_frame = 240;
+        size_t buffer = downlink.dma_playback ? (size_t)downlink.sample_rate * 120 / 1000 : dma_frame * 6;
+        FakeProtocol protocol(protocol_config);
+        FakeCodec codec(downlink.sample_rate, dma_frame, buffer, downlink.speed);
+        DownlinkSim sim(downlink, codec);
+        UplinkSim uplink(uplink_config, protocol);
+
+        SampleStats mouth_to_ear_ms;
+        sim.OnFrameOutput([&](uint32_t timestamp, double delay_ms) {
+            // 时间戳为 (k + 1) * 帧时长，对应上行第 k 帧
+            int64_t k = timestamp / frame_ms - 1;
+            auto captured = uplink.start_time() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double, std::milli>(k * frame_ms / downlink.speed));
+            double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - captured).count();
+            mouth_to_ear_ms.Add(elapsed_ms * downlink.speed + delay_ms);
+        });
+        protocol.OnIncomingAudio([&sim](const uint8_t* data, size_t size, uint32_t timestamp) {
+            sim.OnIncomingAudio(data, size, timestamp);
+        });
+
+        double cpu_start = ProcessCpuMs();
+        codec.Start();
+        sim.Start();
+        protocol.Start();
+        uplink.Start();
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds / downlink.speed));
+        uplink.Stop();
+        protocol.Join();
+        sim.Finish();
+        codec.Stop();
+        double cpu_ms = ProcessCpuMs() - cpu_start;
+
+        auto down = sim.GetReport();
+        auto up = uplink.GetReport();
+        printf("%8d  %8.1f  %10.1f  %10.1f  %10.1f  %9u  %11.1f  %11.1f  %8.1f\n",
+            frame_ms, cpu_ms / seconds, (down.decode_busy_ms + up.encode_busy_ms) / seconds,
+            mouth_to_ear_ms.Percentile(50), mouth_to_ear_ms.Percentile(99),
+            (unsigned)down.output.underruns, up.sent_bytes * 8 / seconds / 1000,
+            protocol.publishes() / seconds, protocol.wire_bytes() * 8 / seconds / 1000);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    DownlinkSim::Config downlink;
+    FakeProtocol::Config protocol_config;
+    std::string p3_path;
+    bool uplink = false;
+    bool bench_decode = false;
+    bool bench_frame_durations = false;
+    int uplink_batch_ms = 0;
+    int uplink_pause_ms = 0;
+    double bench_seconds = 20;
+    size_t synthetic_frames = 500;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                PrintUsage(argv[0]);
+                exit(1);
+            }
+            return argv[++i];
+        };
+        if (arg == "--speed") {
+            downlink.speed = atof(next());
+        } else if (arg == "--sample-rate") {
+            downlink.sample_rate = atoi(next());
+        } else if (arg == "--jitter-ms") {
+            protocol_config.jitter_ms = atof(next());
+        } else if (arg == "--loss") {
+            protocol_config.loss = atof(next());
+        } else if (arg == "--no-timestamps") {
+            protocol_config.timestamps = false;
+        } else if (arg == "--workers") {
+            downlink.decode_workers = atoi(next());
+        } else if (arg == "--dma") {
+            downlink.dma_playback = true;
+        } else if (arg == "--loop-ms") {
+            downlink.loop_interval_ms = atoi(next());
+        } else if (arg == "--uplink") {
+            uplink = true;
+        } else if (arg == "--frames") {
+            synthetic_frames = atoi(next());
+        } else if (arg == "--decode-cost-us") {
+#if !AUDIO_SIM_HAVE_OPUS
+            SimDecoder::SetCostUs(atoi(next()));
+#else
+            next();
+#endif
+        } else if (arg == "--frame-ms") {
+            downlink.frame_duration_ms = atoi(next());
+        } else if (arg == "--uplink-batch-ms") {
+            uplink_batch_ms = atoi(next());
+        } else if (arg == "--uplink-pause-ms") {
+            uplink_pause_ms = atoi(next());
+        } else if (arg == "--bench-decode") {
+            bench_decode = true;
+        } else if (arg == "--bench-frame-durations") {
+            bench_frame_durations = true;
+        } else if (arg == "--seconds") {
+            bench_seconds = atof(next());
+        } else if (arg == "-h" || arg == "--help") {
+            PrintUsage(argv[0]);
+            return 0;
+        } else if (!arg.empty() && arg[0] != '-') {
+            p3_path = arg;
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (downlink.speed <= 0) {
+        downlink.speed = 1;
+    }
+    protocol_config.speed = downlink.speed;
+    protocol_config.frame_duration_ms = downlink.frame_duration_ms;
+    protocol_config.uplink_batch_ms = uplink_batch_ms;
+
+    if (bench_frame_durations) {
+        BenchFrameDurations(downlink, protocol_config, bench_seconds);
+        return 0;
+    }
+
+    FakeProtocol protocol(protocol_config);
+    if (!p3_path.empty()) {
+        if (!protocol.LoadP3(p3_path)) {
+            fprintf(stderr, "Failed to load %s\n", p3_path.c_str());
+            return 1;
+        }
+    } else {
+#if AUDIO_SIM_HAVE_OPUS
+        fprintf(stderr, "A P3 stream is required when built with libopus\n");
+        return 1;
+#else
+        protocol.LoadSynthetic(synthetic_frames, 120);
+#endif
+    }
+
+    if (bench_decode) {
+        BenchDecode(protocol.packets(), downlink.sample_rate, downlink.frame_duration_ms);
+        return 0;
+    }
+
+    // DMA 帧与缓冲大小与 NoAudioCodec 一致：每帧 240 样本，播放任务模式 6 个描述符，回调模式 120ms 环
+    size_t dma_frame = 240;
+    size_t buffer = downlink.dma_playback ? (size_t)downlink.sample_rate * 120 / 1000 : dma_frame * 6;
+    FakeCodec codec(downlink.sample_rate, dma_frame, buffer, downlink.speed);
+    DownlinkSim sim(downlink, codec);
+    std::unique_ptr<UplinkSim> uplink_sim;
+    if (uplink) {
+        UplinkSim::Config uplink_config;
+        uplink_config.speed = downlink.speed;
+        uplink_config.frame_duration_ms = downlink.frame_duration_ms;
+        if (uplink_pause_ms > 0) {
+            uplink_config.gate_mode = UplinkGate::kModeVad;
+            uplink_config.pause_ms = uplink_pause_ms;
+        }
+        uplink_sim = std::make_unique<UplinkSim>(uplink_config, protocol);
+    }
+
+    protocol.OnIncomingAudio([&sim](const uint8_t* data, size_t size, uint32_t timestamp) {
+        sim.OnIncomingAudio(data, size, timestamp);
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    codec.Start();
+    sim.Start();
+    if (uplink_sim) {
+        uplink_sim->Start();
+    }
+    protocol.Start();
+    protocol.Join();
+    sim.Finish();
+    if (uplink_sim) {
+        uplink_sim->Stop();
+        protocol.FlushAudio();
+    }
+    codec.Stop();
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    auto report = sim.GetReport();
+    printf("stream: packets=%zu lost=%zu wall=%.2fs speed=%.1fx mode=%s workers=%d\n",
+        protocol.packets().size(), protocol.lost_packets(), wall, downlink.speed,
+        downlink.dma_playback ? "dma" : "task", downlink.decode_workers);
+    printf("decode: frames=%zu p50=%.0fus p99=%.0fus max=%.0fus throughput=%.0f frames/s\n",
+        report.decoded_frames, report.decode_us_p50, report.decode_us_p99, report.decode_us_max,
+        report.decode_frames_per_sec);
+    printf("queues: ring_mean=%.1f ring_max=%.0f play_q_mean=%.2f play_q_max=%.0f reorder_high_water=%zu in_flight_max=%d/%d\n",
+        report.ring_depth_mean, report.ring_depth_max, report.play_queue_mean, report.play_queue_max,
+        report.reorder_high_water, report.max_in_flight, downlink.max_in_flight);
+    printf("jitter: received=%u late=%u early=%u dropped=%u underruns=%u compressed=%u lost=%u concealed=%u jitter=%dms target=%dms\n",
+        (unsigned)report.jitter.received, (unsigned)report.jitter.late, (unsigned)report.jitter.early,
+        (unsigned)report.jitter.dropped, (unsigned)report.jitter.underruns, (unsigned)report.jitter.compressed,
+        (unsigned)report.jitter.lost, (unsigned)report.jitter.concealed, report.jitter.jitter_ms, report.jitter.target_ms);
+    printf("pool: blocks=%zu high_water=%zu exhausted=%u timeouts=%u\n",
+        report.pool.blocks, report.pool.high_water, (unsigned)report.pool.exhausted, (unsigned)report.pool.timeouts);
+    printf("flow: backpressure_events=%u throttled=%u play_q_high_water=%zu\n",
+        (unsigned)report.flow.backpressure_events, (unsigned)report.flow.throttled, report.flow.queue_high_water);
+    printf("output: underruns=%u silence=%.1fms played=%.2fs\n",
+        (unsigned)report.output.underruns, report.output.silence_words * 1000.0 / downlink.sample_rate,
+        (double)report.output.played_words / downlink.sample_rate);
+    if (uplink_sim) {
+        auto up = uplink_sim->GetReport();
+        printf("uplink: frames=%zu encode_p50=%.0fus encode_p99=%.0fus latency_p50=%.1fms latency_p99=%.1fms max_pending=%d bytes=%zu\n",
+            up.frames, up.encode_us_p50, up.encode_us_p99, up.latency_ms_p50, up.latency_ms_p99, up.max_pending, up.sent_bytes);
+        if (uplink_pause_ms > 0) {
+            printf("uplink gate: captured=%ums suppressed=%ums markers=%u\n", (unsigned)up.gate.captured_ms,
+                (unsigned)up.gate.suppressed_ms, (unsigned)up.gate.markers);
+        }
+        // 空中字节为估算值（MQTT 头 + TCP/IP 头），unbatched 为同样的帧逐帧发布时的值
+        double seconds = up.frames * downlink.frame_duration_ms / 1000.0;
+        if (seconds > 0) {
+            printf("uplink publish: publishes/s=%.1f (unbatched %.1f) air_bytes/s=%.0f (unbatched %.0f)\n",
+                protocol.publishes() / seconds, protocol.sent_packets() / seconds,
+                protocol.wire_bytes() / seconds, protocol.unbatched_wire_bytes() / seconds);
+        }
+    }
+    return 0;
+}
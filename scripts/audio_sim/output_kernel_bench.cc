@@ -0,0 +1,98 @@
+// NoAudioCodec::Write 输出路径的微基准：比较原先的实现（每次调用分配 vector、pow 计算音量、
+// int64 乘法加饱和）与 output_kernel 中的融合内核，输出每样本的周期数（x86 上用 rdtsc）和纳秒数
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline uint64_t Cycles() { return __rdtsc(); }
+#else
+static inline uint64_t Cycles() { return 0; }
+#endif
+
+#include "output_kernel.h"
+
+// 防止编译器把输出优化掉
+static volatile int32_t g_sink;
+
+static void ConsumeWords(const int32_t* words, size_t count) {
+    g_sink = g_sink + words[0] + words[count - 1];
+}
+
+// 原先的 NoAudioCodec::Write（去掉 i2s_channel_write）
+static void LegacyWrite(const int16_t* data, int samples, int volume) {
+    int32_t volume_factor = pow(double(volume) / 100.0, 2) * 65536;
+    std::vector<int32_t> buffer(samples);
+    for (int i = 0; i < samples; i++) {
+        int64_t temp = int64_t(data[i]) * volume_factor;
+        if (temp > INT32_MAX) {
+            buffer[i] = INT32_MAX;
+        } else if (temp < INT32_MIN) {
+            buffer[i] = INT32_MIN;
+        } else {
+            buffer[i] = static_cast<int32_t>(temp);
+        }
+    }
+    ConsumeWords(buffer.data(), samples);
+}
+
+// 新的写入路径：增益预先算好，按 DMA 帧分块转换到常驻缓冲
+static int32_t g_scratch[240];
+
+static void KernelWrite(const int16_t* data, int samples, int32_t gain) {
+    for (int written = 0; written < samples; written += 240) {
+        int count = samples - written < 240 ? samples - written : 240;
+        OutputConvert(data + written, g_scratch, count, gain);
+        ConsumeWords(g_scratch, count);
+    }
+}
+
+template<typename F>
+static void Run(const char* name, int samples, int iterations, F&& write) {
+    // 预热
+    for (int i = 0; i < iterations / 10 + 1; i++) {
+        write();
+    }
+    auto start = std::chrono::steady_clock::now();
+    uint64_t cycles_start = Cycles();
+    for (int i = 0; i < iterations; i++) {
+        write();
+    }
+    uint64_t cycles = Cycles() - cycles_start;
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    double total = (double)samples * iterations;
+    if (cycles > 0) {
+        printf("%-28s %8.3f cycles/sample %8.3f ns/sample\n", name, cycles / total, ns / total);
+    } else {
+        printf("%-28s %8.3f ns/sample\n", name, ns / total);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    // 默认一帧 60ms@24kHz
+    int samples = argc > 1 ? atoi(argv[1]) : 1440;
+    int iterations = argc > 2 ? atoi(argv[2]) : 20000;
+    int volume = 70;
+
+    std::vector<int16_t> pcm(samples);
+    for (int i = 0; i < samples; i++) {
+        pcm[i] = (int16_t)(20000 * sin(i * 0.01));
+    }
+
+    // 先确认两条路径的输出一致
+    int32_t gain = OutputGain(volume);
+    int32_t legacy_factor = pow(double(volume) / 100.0, 2) * 65536;
+    if (gain != legacy_factor) {
+        printf("gain mismatch: kernel=%d legacy=%d\n", (int)gain, (int)legacy_factor);
+        return 1;
+    }
+
+    printf("samples=%d iterations=%d volume=%d\n", samples, iterations, volume);
+    Run("legacy (alloc+pow+int64)", samples, iterations, [&]() { LegacyWrite(pcm.data(), samples, volume); });
+    Run("fused kernel", samples, iterations, [&]() { KernelWrite(pcm.data(), samples, gain); });
+    return 0;
+}
@@ -0,0 +1,315 @@
+// PacketRing（单生产者/单消费者无锁环形队列）的主机自检和基准
+// 单线程检查：包数上限和 slab 容量写满、空队列、slab 回绕写入、描述符槽位回绕、Clear 与在途包
+// 多线程压力：生产者写入按序号生成内容的变长包，消费者延迟若干包再按顺序 Release，
+// 取出时和 Release 前各校验一次内容（检测撕裂读和在途载荷被覆盖），可选第三个线程随机 Clear
+// 基准：单线程 Push+Acquire+Release 的每包耗时，以及生产者/消费者分属两个线程时的吞吐
+//   packet_ring_tool [--packets N] [--no-clear] [--bench]
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <thread>
+#include <vector>
+
+#include "packet_ring.h"
+
+static int g_failures = 0;
+
+#define CHECK(condition, ...)                                       \
+    do {                                                            \
+        if (!(condition)) {                                         \
+            fprintf(stderr, "%s:%d: check failed: %s: ", __FILE__, __LINE__, #condition); \
+            fprintf(stderr, __VA_ARGS__);                           \
+            fprintf(stderr, "\n");                                  \
+            g_failures++;                                           \
+        }                                                           \
+    } while (0)
+
+// 包内容由序号决定：前 4 字节是序号，其余字节由序号和位置生成
+static size_t PacketSize(uint32_t sequence) {
+    return 4 + (sequence * 2654435761u >> 20) % 400;
+}
+
+static void FillPacket(uint8_t* data, size_t size, uint32_t sequence) {
+    memcpy(data, &sequence, sizeof(sequence));
+    for (size_t i = 4; i < size; i++) {
+        data[i] = (uint8_t)(sequence * 31 + i);
+    }
+}
+
+static bool VerifyPacket(const PacketRing::Packet& packet, uint32_t* sequence) {
+    if (packet.size < 4) {
+        return false;
+    }
+    memcpy(sequence, packet.data, sizeof(*sequence));
+    if (packet.size != PacketSize(*sequence) || packet.timestamp != *sequence || packet.trace_id != ~*sequence) {
+        return false;
+    }
+    for (size_t i = 4; i < packet.size; i++) {
+        if (packet.data[i] != (uint8_t)(*sequence * 31 + i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void TestLimits() {
+    printf("full, empty and slab wraparound\n");
+    uint8_t data[256];
+    PacketRing::Packet packet;
+
+    // 包数上限
+    PacketRing ring(4, 1024);
+    CHECK(ring.Empty() && !ring.Acquire(packet), "new ring should be empty");
+    CHECK(!ring.Push(data, 0), "empty packet should be rejected");
+    CHECK(!ring.Push(data, 2048), "packet larger than the slab should be rejected");
+    for (int i = 0; i < 4; i++) {
+        CHECK(ring.Push(data, 16, i), "push %d should fit", i);
+    }
+    CHECK(!ring.Push(data, 16), "fifth packet should hit max_packets");
+    CHECK(ring.Size() == 4, "size %zu", ring.Size());
+    // 取走但未 Release 的包仍占着槽位
+    CHECK(ring.Acquire(packet) && packet.timestamp == 0, "acquire first packet");
+    CHECK(!ring.Push(data, 16), "in-flight packet should still hold its slot");
+    CHECK(ring.InFlight() == 1 && ring.Size() == 3, "in flight %zu size %zu", ring.InFlight(), ring.Size());
+    ring.Release();
+    CHECK(ring.Push(data, 16, 4), "released slot should be reusable");
+    for (uint32_t expected = 1; expected <= 4; expected++) {
+        CHECK(ring.Acquire(packet) && packet.timestamp == expected, "expected packet %u", expected);
+        ring.Release();
+    }
+    CHECK(ring.Empty() && !ring.Acquire(packet), "drained ring should be empty");
+
+    // slab 写满，以及尾部放不下时回绕到开头
+    PacketRing slab_ring(16, 1000);
+    for (int i = 0; i < 3; i++) {
+        CHECK(slab_ring.Push(data, 300, i), "push %d of 300 bytes", i);
+    }
+    CHECK(!slab_ring.Push(data, 200), "200 bytes should not fit in the remaining 100");
+    CHECK(slab_ring.Push(data, 100, 3), "100 bytes should fill the slab exactly");
+    CHECK(!slab_ring.Push(data, 1), "full slab should reject any packet");
+    CHECK(slab_ring.Acquire(packet) && packet.timestamp == 0, "acquire packet 0");
+    CHECK(!slab_ring.Push(data, 1), "acquired but unreleased payload should stay reserved");
+    slab_ring.Release();
+    CHECK(!slab_ring.Push(data, 301), "only 300 bytes are free at the head");
+    FillPacket(data, 256, 77);
+    CHECK(slab_ring.Push(data, 256, 4), "wrapped push should fit at offset 0");
+    for (uint32_t expected = 1; expected <= 4; expected++) {
+        CHECK(slab_ring.Acquire(packet) && packet.timestamp == expected, "expected packet %u", expected);
+        if (expected == 4) {
+            CHECK(packet.data[0] == data[0] && memcmp(packet.data, data, 256) == 0, "wrapped payload corrupted");
+        }
+        slab_ring.Release();
+    }
+
+    // 描述符槽位（序号取模 max_packets）多次回绕
+    PacketRing small(3, 64);
+    for (uint32_t i = 0; i < 1000; i++) {
+        FillPacket(data, 8, i);
+        CHECK(small.Push(data, 8, i), "push %u", i);
+        if (i % 2 == 1) {
+            for (int j = 0; j < 2; j++) {
+                uint32_t expected = i - 1 + j;
+                CHECK(small.Acquire(packet) && packet.timestamp == expected, "slot wraparound: expected %u", expected);
+                small.Release();
+            }
+        }
+    }
+}
+
+static void TestClear() {
+    printf("clear with packets in flight\n");
+    uint8_t data[64] = {};
+    PacketRing::Packet packet;
+    PacketRing ring(8, 256);
+    for (int i = 0; i < 4; i++) {
+        ring.Push(data, 32, i);
+    }
+    CHECK(ring.Acquire(packet) && packet.timestamp == 0, "acquire packet 0");
+    ring.Clear();
+    CHECK(ring.Size() == 0, "Clear should hide queued packets, size %zu", ring.Size());
+    // 在途的包 Release 之前不能跳过，否则生产者会覆盖正在读取的载荷
+    CHECK(!ring.Acquire(packet), "acquire should wait for the in-flight packet");
+    ring.Push(data, 32, 10);
+    ring.Release();
+    CHECK(ring.Acquire(packet) && packet.timestamp == 10, "packet written after Clear should survive, got %u",
+        (unsigned)packet.timestamp);
+    ring.Release();
+    CHECK(ring.Empty(), "ring should be empty");
+}
+
+static void TestStress(uint32_t packets, bool with_clear) {
+    printf("SPSC stress: %u packets%s\n", (unsigned)packets, with_clear ? ", concurrent Clear" : "");
+    PacketRing ring(32, 4096);
+    std::atomic<bool> done{false};
+    std::atomic<uint32_t> clears{0};
+    uint32_t push_failures = 0;
+
+    std::thread producer([&]() {
+        std::vector<uint8_t> data(512);
+        for (uint32_t sequence = 0; sequence < packets; sequence++) {
+            size_t size = PacketSize(sequence);
+            FillPacket(data.data(), size, sequence);
+            while (!ring.Push(data.data(), size, sequence, ~sequence)) {
+                push_failures++;
+                std::this_thread::yield();
+            }
+        }
+        done = true;
+    });
+
+    std::thread clearer;
+    if (with_clear) {
+        clearer = std::thread([&]() {
+            uint32_t seed = 12345;
+            while (!done.load()) {
+                seed = seed * 1103515245 + 12345;
+                std::this_thread::sleep_for(std::chrono::microseconds(50 + (seed >> 16) % 500));
+                ring.Clear();
+                clears++;
+            }
+        });
+    }
+
+    // 消费者：最多保留 8 个在途包，Release 前再校验一次
+    std::deque<PacketRing::Packet> in_flight;
+    uint32_t received = 0;
+    uint32_t bad = 0;
+    int64_t last = -1;
+    uint32_t seed = 42;
+    auto release_oldest = [&]() {
+        uint32_t sequence;
+        if (!VerifyPacket(in_flight.front(), &sequence)) {
+            bad++;
+        }
+        in_flight.pop_front();
+        ring.Release();
+    };
+    while (true) {
+        PacketRing::Packet packet;
+        if (ring.Acquire(packet)) {
+            uint32_t sequence;
+            if (!VerifyPacket(packet, &sequence)) {
+                bad++;
+            } else if ((int64_t)sequence <= last || (!with_clear && (int64_t)sequence != last + 1)) {
+                CHECK(false, "out of order: %u after %lld", (unsigned)sequence, (long long)last);
+            } else {
+                last = sequence;
+            }
+            received++;
+            in_flight.push_back(packet);
+            seed = seed * 1103515245 + 12345;
+            size_t keep = (seed >> 16) % 9;
+            while (in_flight.size() > keep) {
+                release_oldest();
+            }
+        } else {
+            while (!in_flight.empty()) {
+                release_oldest();
+            }
+            if (done.load() && ring.Empty()) {
+                break;
+            }
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    if (clearer.joinable()) {
+        clearer.join();
+    }
+
+    CHECK(bad == 0, "%u corrupted packets", (unsigned)bad);
+    if (!with_clear) {
+        CHECK(received == packets, "received %u of %u", (unsigned)received, (unsigned)packets);
+    }
+    CHECK(ring.InFlight() == 0, "in flight %zu after drain", ring.InFlight());
+    printf("  received %u, producer retries %u, clears %u\n", (unsigned)received, (unsigned)push_failures,
+        (unsigned)clears.load());
+}
+
+static double NowSeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void Benchmark() {
+    printf("benchmark\n");
+    const uint32_t iterations = 5000000;
+    for (size_t size : {64, 200, 1920}) {
+        PacketRing ring(64, 16 * 1024);
+        std::vector<uint8_t> data(size, 0x5a);
+        PacketRing::Packet packet;
+        uint64_t checksum = 0;
+        double start = NowSeconds();
+        for (uint32_t i = 0; i < iterations; i++) {
+            ring.Push(data.data(), size, i);
+            ring.Acquire(packet);
+            checksum += packet.data[size - 1];
+            ring.Release();
+        }
+        double elapsed = NowSeconds() - start;
+        printf("  single thread, %4zu bytes: %.1f ns/packet (checksum %llu)\n", size, elapsed * 1e9 / iterations,
+            (unsigned long long)checksum);
+    }
+
+    for (size_t size : {64, 1920}) {
+        PacketRing ring(64, 16 * 1024);
+        std::vector<uint8_t> data(size, 0x5a);
+        double start = NowSeconds();
+        std::thread producer([&]() {
+            for (uint32_t i = 0; i < iterations; i++) {
+                while (!ring.Push(data.data(), size, i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        PacketRing::Packet packet;
+        uint32_t received = 0;
+        while (received < iterations) {
+            if (ring.Acquire(packet)) {
+                received++;
+                ring.Release();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        producer.join();
+        double elapsed = NowSeconds() - start;
+        printf("  two threads,   %4zu bytes: %.1f ns/packet, %.1f MB/s\n", size, elapsed * 1e9 / iterations,
+            iterations * size / elapsed / 1e6);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t packets = 2000000;
+    bool with_clear = true;
+    bool bench = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--packets") == 0 && i + 1 < argc) {
+            packets = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--no-clear") == 0) {
+            with_clear = false;
+        } else if (strcmp(argv[i], "--bench") == 0) {
+            bench = true;
+        } else {
+            fprintf(stderr, "usage: %s [--packets N] [--no-clear] [--bench]\n", argv[0]);
+            return 1;
+        }
+    }
+    TestLimits();
+    TestClear();
+    TestStress(packets, false);
+    if (with_clear) {
+        TestStress(packets, true);
+    }
+    if (bench) {
+        Benchmark();
+    }
+    if (g_failures > 0) {
+        printf("%d checks failed\n", g_failures);
+        return 3;
+    }
+    printf("self check: ok\n");
+    return 0;
+}
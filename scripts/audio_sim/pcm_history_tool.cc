@@ -0,0 +1,137 @@
+// PcmHistory（AfeWakeWord 唤醒词前音频的环形缓冲）的主机自检和堆分配对比
+// - 自检：随机长度写入，与按样本保存的参考队列逐样本比较快照
+// - 堆分配：模拟设备空闲时持续检测，统计原先 list<vector> 的做法与 PcmHistory 的分配次数和字节数
+//   pcm_history_tool [--seconds 600] [--chunk 512] [--window-ms 2000]
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <list>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "pcm_history.h"
+
+static size_t g_allocations = 0;
+static size_t g_allocated_bytes = 0;
+
+void* operator new(size_t size) {
+    g_allocations++;
+    g_allocated_bytes += size;
+    void* p = malloc(size > 0 ? size : 1);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+static bool SelfCheck() {
+    std::mt19937 rng(1234);
+    for (int capacity_ms : {1, 7, 64, 2000}) {
+        PcmHistory history;
+        history.Configure(16000, capacity_ms);
+        std::deque<int16_t> reference;
+        int16_t next = 0;
+        for (int round = 0; round < 2000; round++) {
+            // 偶尔写入超过容量的一块，覆盖截断路径
+            size_t samples = rng() % 10 == 0 ? history.capacity() + rng() % 100 : rng() % 700;
+            std::vector<int16_t> chunk(samples);
+            for (auto& sample : chunk) {
+                sample = next++;
+                reference.push_back(sample);
+            }
+            history.Write(chunk.data(), chunk.size());
+            while (reference.size() > history.capacity()) {
+                reference.pop_front();
+            }
+            if (rng() % 50 == 0) {
+                history.Clear();
+                reference.clear();
+            }
+
+            auto snapshot = history.GetSnapshot();
+            if (snapshot.samples() != reference.size() || history.size() != reference.size()) {
+                fprintf(stderr, "capacity %dms round %d: size %zu, expected %zu\n",
+                    capacity_ms, round, snapshot.samples(), reference.size());
+                return false;
+            }
+            size_t index = 0;
+            for (const auto& span : {snapshot.first, snapshot.second}) {
+                for (size_t i = 0; i < span.samples; i++, index++) {
+                    if (span.data[i] != reference[index]) {
+                        fprintf(stderr, "capacity %dms round %d: sample %zu mismatch\n", capacity_ms, round, index);
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    int seconds = 600;
+    size_t chunk = 512;
+    int window_ms = 2000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string option = argv[i];
+        if (option == "--seconds") {
+            seconds = atoi(argv[i + 1]);
+        } else if (option == "--chunk") {
+            chunk = atoi(argv[i + 1]);
+        } else if (option == "--window-ms") {
+            window_ms = atoi(argv[i + 1]);
+        }
+    }
+
+    if (!SelfCheck()) {
+        return 2;
+    }
+    printf("self check: ok\n");
+
+    std::vector<int16_t> frame(chunk, 0);
+    size_t frames = (size_t)seconds * 16000 / chunk;
+
+    // 原先的做法：每帧分配一个 vector，保留约 window_ms / 30 帧
+    size_t allocations = g_allocations;
+    size_t bytes = g_allocated_bytes;
+    {
+        std::list<std::vector<int16_t>> pcm;
+        for (size_t i = 0; i < frames; i++) {
+            pcm.emplace_back(std::vector<int16_t>(frame.data(), frame.data() + frame.size()));
+            while (pcm.size() > (size_t)window_ms / 30) {
+                pcm.pop_front();
+            }
+        }
+    }
+    size_t list_allocations = g_allocations - allocations;
+    size_t list_bytes = g_allocated_bytes - bytes;
+
+    allocations = g_allocations;
+    bytes = g_allocated_bytes;
+    {
+        PcmHistory history;
+        history.Configure(16000, window_ms);
+        for (size_t i = 0; i < frames; i++) {
+            history.Write(frame.data(), frame.size());
+        }
+    }
+    size_t ring_allocations = g_allocations - allocations;
+    size_t ring_bytes = g_allocated_bytes - bytes;
+
+    printf("%d s idle detection, %zu frames of %zu samples:\n", seconds, frames, chunk);
+    printf("  list<vector>: %8zu allocations, %10zu bytes (%.1f allocations/s)\n",
+        list_allocations, list_bytes, list_allocations / (double)seconds);
+    printf("  PcmHistory:   %8zu allocations, %10zu bytes\n", ring_allocations, ring_bytes);
+    return ring_allocations <= 1 ? 0 : 3;
+}
@@ -0,0 +1,100 @@
+// PlaybackClock（服务端 AEC 的回声参考时间戳）的主机模拟
+// 模拟阻塞写入的 I2S 输出：DAC 时钟相对系统定时器有 ppm 级漂移，写入返回时间带调度抖动，
+// 中途有一次欠载；在随机采集时刻查询参考时间戳，与真实正在放出的下行时间戳比较
+//   playback_clock_tool [--seconds 300] [--ppm 200] [--jitter-us 4000] [--frame-ms 60]
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "playback_clock.h"
+
+int main(int argc, char* argv[]) {
+    int seconds = 300;
+    double ppm = 200;
+    int jitter_us = 4000;
+    int frame_ms = 60;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string option = argv[i];
+        if (option == "--seconds") {
+            seconds = atoi(argv[i + 1]);
+        } else if (option == "--ppm") {
+            ppm = atof(argv[i + 1]);
+        } else if (option == "--jitter-us") {
+            jitter_us = atoi(argv[i + 1]);
+        } else if (option == "--frame-ms") {
+            frame_ms = atoi(argv[i + 1]);
+        }
+    }
+
+    const int sample_rate = 24000;
+    const size_t frame_samples = (size_t)sample_rate * frame_ms / 1000;
+    const size_t dma_samples = 6 * 240;     // AUDIO_CODEC_DMA_DESC_NUM * AUDIO_CODEC_DMA_FRAME_NUM
+    // 以系统定时器计的真实样本时长
+    const double sample_us = 1e6 / (sample_rate * (1.0 + ppm * 1e-6));
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> jitter(0, jitter_us);
+
+    struct Frame {
+        uint32_t timestamp;
+        double start_us;
+        double end_us;
+    };
+    std::vector<Frame> frames;
+    PlaybackClock clock;
+    double dac_us = 1000000;        // 下一个样本开始放出的真实时间
+    uint32_t timestamp = 123456;
+    size_t total = (size_t)seconds * 1000 / frame_ms;
+    for (size_t i = 0; i < total; i++) {
+        if (i == total / 2) {
+            // 欠载：下行中断 500ms，时间戳同样跳过
+            dac_us += 500000;
+            timestamp += 500;
+        }
+        Frame frame{timestamp, dac_us, dac_us + frame_samples * sample_us};
+        frames.push_back(frame);
+        // 阻塞写入在 DMA 有空间放下本帧最后一个样本时返回，此后还有 dma_samples 个样本待放出
+        double return_us = frame.end_us - dma_samples * sample_us + jitter(rng);
+        clock.OnFrameWritten(timestamp, frame_samples, dma_samples, sample_rate, (uint32_t)(int64_t)return_us);
+        dac_us = frame.end_us;
+        timestamp += frame_ms;
+    }
+
+    // 在每帧内随机取一个采集时刻查询；查询发生在本帧写入之后，只能查到环中保留的帧
+    double total_error = 0;
+    double max_error = 0;
+    size_t queries = 0;
+    size_t misses = 0;
+    PlaybackClock replay;
+    for (size_t i = 0; i < frames.size(); i++) {
+        const Frame& frame = frames[i];
+        double return_us = frame.end_us - dma_samples * sample_us + jitter(rng);
+        replay.OnFrameWritten(frame.timestamp, frame_samples, dma_samples, sample_rate, (uint32_t)(int64_t)return_us);
+        if (i < 8) {
+            continue;
+        }
+        const Frame& target = frames[i - 4];
+        double t = target.start_us + (target.end_us - target.start_us) * (rng() % 1000) / 1000.0;
+        double expected = target.timestamp + (t - target.start_us) / 1000.0;
+        uint32_t actual = replay.Lookup((uint32_t)(int64_t)t);
+        queries++;
+        if (actual == 0) {
+            misses++;
+            continue;
+        }
+        double error = std::fabs((double)actual - expected);
+        total_error += error;
+        max_error = std::max(max_error, error);
+    }
+
+    auto stats = replay.GetStats();
+    printf("%d s playback, %zu frames of %dms, drift %.0f ppm, write jitter 0~%dus\n",
+        seconds, frames.size(), frame_ms, ppm, jitter_us);
+    printf("  resyncs %u, queries %zu, unmatched %zu\n", (unsigned)stats.resyncs, queries, misses);
+    printf("  reference error: mean %.2f ms, max %.2f ms\n",
+        queries > misses ? total_error / (queries - misses) : 0.0, max_error);
+    // 服务端按毫秒对齐参考信号，误差应明显小于 AEC 的滤波器长度（通常数十毫秒）
+    return misses * 100 < queries && max_error < 10 ? 0 : 3;
+}
@@ -0,0 +1,189 @@
+// DMA 回调播放路径的主机自检
+// - DmaPlaybackRing：写满后 PrepareWrite 不再给出空间、写入位置回绕、欠载计数（短中断算欠载，长于一个环的间隔不算）、
+//   Flush 丢弃已写入的样本且不算欠载、Flush 之后写入的样本保留
+// - DecodeSequencer：sink 在锁外执行，一个线程的 sink 阻塞（对应写满的 DMA 环）时其他线程的 Complete 不被阻塞，
+//   这些帧由阻塞的线程在 sink 返回后按序号交出
+//   playback_sink_tool
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "decode_sequencer.h"
+#include "dma_playback_ring.h"
+#include "pcm_pool.h"
+
+static int g_failures = 0;
+
+#define CHECK(condition, ...)                                       \
+    do {                                                            \
+        if (!(condition)) {                                         \
+            fprintf(stderr, "%s:%d: check failed: %s: ", __FILE__, __LINE__, #condition); \
+            fprintf(stderr, __VA_ARGS__);                           \
+            fprintf(stderr, "\n");                                  \
+            g_failures++;                                           \
+        }                                                           \
+    } while (0)
+
+// 写入 words 个从 first 开始递增的字，返回实际写入数（环满时停止）
+static size_t WriteWords(DmaPlaybackRing& ring, size_t words, int32_t first) {
+    size_t written = 0;
+    while (written < words) {
+        size_t contiguous;
+        int32_t* dest = ring.PrepareWrite(contiguous);
+        if (contiguous == 0) {
+            break;
+        }
+        size_t count = std::min(contiguous, words - written);
+        for (size_t i = 0; i < count; i++) {
+            dest[i] = first + (int32_t)(written + i);
+        }
+        ring.CommitWrite(count);
+        written += count;
+    }
+    return written;
+}
+
+static void TestRing() {
+    printf("DMA playback ring: fill, underrun and flush\n");
+    const size_t kCapacity = 480;
+    const size_t kDma = 240;
+    std::vector<int32_t> dma(kDma);
+
+    // 写满
+    DmaPlaybackRing ring(kCapacity);
+    CHECK(WriteWords(ring, 1000, 1) == kCapacity, "should accept exactly the capacity");
+    size_t contiguous;
+    ring.PrepareWrite(contiguous);
+    CHECK(contiguous == 0 && ring.Size() == kCapacity, "full ring: contiguous %zu size %zu", contiguous, ring.Size());
+    CHECK(ring.Fill(dma.data(), kDma) == kDma && dma[0] == 1 && dma[kDma - 1] == (int32_t)kDma, "first DMA buffer");
+    ring.PrepareWrite(contiguous);
+    CHECK(contiguous == kDma, "one DMA buffer should be free, got %zu", contiguous);
+
+    // 写入位置回绕：先写到环尾，再从头写
+    CHECK(WriteWords(ring, kDma, 1000) == kDma, "refill after one DMA buffer");
+    CHECK(ring.Fill(dma.data(), kDma) == kDma && dma[0] == (int32_t)kDma + 1, "second DMA buffer");
+    CHECK(ring.Fill(dma.data(), kDma) == kDma && dma[0] == 1000 && dma[kDma - 1] == 1000 + (int32_t)kDma - 1,
+        "wrapped data");
+    CHECK(ring.Size() == 0 && ring.GetStats().underruns == 0, "drained without underrun");
+
+    // 欠载：数据在一个环长度内恢复算一次欠载，缺口补静音
+    DmaPlaybackRing underrun(kCapacity);
+    WriteWords(underrun, 300, 1);
+    underrun.Fill(dma.data(), kDma);
+    CHECK(underrun.Fill(dma.data(), kDma) == 60 && dma[59] == 300 && dma[60] == 0 && dma[kDma - 1] == 0,
+        "partial buffer should be padded with silence");
+    WriteWords(underrun, kDma, 1);
+    underrun.Fill(dma.data(), kDma);
+    auto stats = underrun.GetStats();
+    CHECK(stats.underruns == 1 && stats.silence_words == 180, "underruns %u silence %u", (unsigned)stats.underruns,
+        (unsigned)stats.silence_words);
+    // 长于一个环的空闲是两段音频之间的间隔，不算欠载
+    for (int i = 0; i < 3; i++) {
+        underrun.Fill(dma.data(), kDma);
+    }
+    WriteWords(underrun, kDma, 1);
+    underrun.Fill(dma.data(), kDma);
+    CHECK(underrun.GetStats().underruns == 1, "idle gap counted as underrun: %u", (unsigned)underrun.GetStats().underruns);
+
+    // Flush：已写入的样本不再放出，也不算欠载；Flush 之后写入的样本保留
+    DmaPlaybackRing flush(kCapacity);
+    WriteWords(flush, kDma, 1);
+    flush.Fill(dma.data(), kDma / 2);
+    WriteWords(flush, 1000, 500);
+    flush.Flush();
+    CHECK(flush.Size() == 0, "flushed ring should report empty, size %zu", flush.Size());
+    CHECK(flush.Fill(dma.data(), kDma) == 0 && dma[0] == 0, "flushed samples should not be played");
+    CHECK(WriteWords(flush, 1000, 7000) == kCapacity, "flush should free the whole ring");
+    flush.Fill(dma.data(), kDma);
+    CHECK(dma[0] == 7000, "first sample after flush %d", (int)dma[0]);
+    CHECK(flush.GetStats().underruns == 0, "flush counted as underrun");
+
+    WriteWords(flush, 100, 0);
+    flush.Flush();
+    WriteWords(flush, 10, 9000);
+    CHECK(flush.Size() == 10, "samples written after Flush should stay, size %zu", flush.Size());
+    CHECK(flush.Fill(dma.data(), kDma) == 10 && dma[0] == 9000, "post-flush samples");
+}
+
+static void TestSequencerSink() {
+    printf("decode sequencer: blocking sink outside the lock\n");
+    PcmPool pool(8, 16);
+    DecodeSequencer sequencer(4);
+    std::mutex delivered_mutex;
+    std::vector<uint32_t> delivered;
+    std::atomic<bool> sink_blocked{false};
+    std::atomic<bool> unblock{false};
+    std::atomic<bool> lock_free_in_sink{false};
+
+    auto sink = [&](PcmPool::Block&& frame) {
+        if (frame.trace_id() == 0) {
+            sink_blocked = true;
+            // 锁外执行时可以再次进入保序器
+            sequencer.reorder_high_water();
+            lock_free_in_sink = true;
+            while (!unblock.load()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        std::lock_guard<std::mutex> lock(delivered_mutex);
+        delivered.push_back(frame.trace_id());
+    };
+    auto run_frame = [&](uint32_t sequence) {
+        auto pcm = pool.Acquire();
+        pcm.resize(16);
+        pcm.set_trace_id(sequence);
+        for (int stage = 0; stage < DecodeSequencer::kStageCount; stage++) {
+            sequencer.BeginTurn((DecodeSequencer::Stage)stage, sequence);
+            sequencer.EndTurn((DecodeSequencer::Stage)stage, sequence);
+        }
+        sequencer.Complete(sequence, std::move(pcm), sink);
+    };
+
+    for (int i = 0; i < 4; i++) {
+        sequencer.Next();
+    }
+    std::thread first([&]() { run_frame(0); });
+    while (!sink_blocked.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // 帧 0 的 sink 阻塞期间，其余帧仍能走完全部阶段并提交
+    std::atomic<int> completed{0};
+    std::thread others([&]() {
+        for (uint32_t sequence = 1; sequence < 4; sequence++) {
+            run_frame(sequence);
+            completed++;
+        }
+    });
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (completed.load() < 3 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(completed.load() == 3, "only %d frames completed while the sink was blocked", completed.load());
+    CHECK(lock_free_in_sink.load(), "sink should run without the sequencer lock");
+    {
+        std::lock_guard<std::mutex> lock(delivered_mutex);
+        CHECK(delivered.empty(), "later frames should wait for frame 0, %zu delivered", delivered.size());
+    }
+    unblock = true;
+    first.join();
+    others.join();
+    CHECK(delivered.size() == 4, "delivered %zu frames", delivered.size());
+    for (size_t i = 0; i < delivered.size(); i++) {
+        CHECK(delivered[i] == i, "frame %zu delivered as %u", i, (unsigned)delivered[i]);
+    }
+}
+
+int main() {
+    TestRing();
+    TestSequencerSink();
+    if (g_failures > 0) {
+        printf("%d checks failed\n", g_failures);
+        return 3;
+    }
+    printf("self check: ok\n");
+    return 0;
+}
@@ -0,0 +1,16 @@
+#ifndef AUDIO_SIM_ESP_HEAP_CAPS_H
+#define AUDIO_SIM_ESP_HEAP_CAPS_H
+
+// 主机模拟器用的 esp_heap_caps.h 替身：不区分内存类型
+#include <cstdlib>
+#include <cstdint>
+
+#define MALLOC_CAP_SPIRAM   (1 << 10)
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+static inline void* heap_caps_malloc(size_t size, uint32_t) { return malloc(size); }
+static inline void* heap_caps_calloc(size_t n, size_t size, uint32_t) { return calloc(n, size); }
+static inline void heap_caps_free(void* ptr) { free(ptr); }
+
+#endif // AUDIO_SIM_ESP_HEAP_CAPS_H
@@ -0,0 +1,12 @@
+#ifndef AUDIO_SIM_ESP_LOG_H
+#define AUDIO_SIM_ESP_LOG_H
+
+// 主机模拟器用的 esp_log.h 替身：输出到 stderr
+#include <cstdio>
+
+#define ESP_LOGE(tag, format, ...) fprintf(stderr, "E (%s) " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) fprintf(stderr, "W (%s) " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) fprintf(stderr, "I (%s) " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) do {} while (0)
+
+#endif // AUDIO_SIM_ESP_LOG_H
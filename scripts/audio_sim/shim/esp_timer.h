@@ -0,0 +1,13 @@
+#ifndef AUDIO_SIM_ESP_TIMER_H
+#define AUDIO_SIM_ESP_TIMER_H
+
+// 主机模拟器用的 esp_timer.h 替身：单调时钟，单位微秒
+#include <chrono>
+#include <cstdint>
+
+static inline int64_t esp_timer_get_time() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#endif // AUDIO_SIM_ESP_TIMER_H
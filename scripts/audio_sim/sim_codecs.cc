@@ -0,0 +1,110 @@
+#include "sim_codecs.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "sim_stats.h"
+
+#if AUDIO_SIM_HAVE_OPUS
+#include <opus.h>
+#else
+static int g_decode_cost_us = 2000;
+
+// 合成编解码器的耗时模型：g_decode_cost_us 为 60ms 帧的耗时，其中约 30% 为与帧长无关的固定开销，
+// 其余按帧时长线性缩放，使不同帧时长之间的 CPU 占用对比有意义
+static int FrameCostUs(int cost_us, int duration_ms) {
+    return cost_us * 3 / 10 + cost_us * 7 / 10 * duration_ms / 60;
+}
+
+static void BusyWait(int cost_us) {
+    auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(cost_us);
+    while (std::chrono::steady_clock::now() < end) {
+    }
+}
+
+SimDecoder::SimDecoder(int sample_rate, int channels, int duration_ms)
+    : sample_rate_(sample_rate),
+      duration_ms_(duration_ms),
+      frame_samples_(sample_rate / 1000 * duration_ms * channels) {
+}
+
+void SimDecoder::SetCostUs(int cost_us) {
+    g_decode_cost_us = cost_us;
+}
+
+int SimDecoder::Synthesize(int16_t* pcm, size_t max_samples) {
+    if ((size_t)frame_samples_ > max_samples) {
+        return -1;
+    }
+    BusyWait(FrameCostUs(g_decode_cost_us, duration_ms_));
+    for (int i = 0; i < frame_samples_; i++, phase_++) {
+        pcm[i] = (int16_t)(8000 * std::sin(2 * M_PI * 440 * phase_ / sample_rate_));
+    }
+    return frame_samples_;
+}
+
+int SimDecoder::Decode(const uint8_t*, size_t size, int16_t* pcm, size_t max_samples) {
+    return size > 0 ? Synthesize(pcm, max_samples) : -1;
+}
+
+int SimDecoder::DecodeFec(const uint8_t*, size_t, int16_t* pcm, size_t max_samples) {
+    return Synthesize(pcm, max_samples);
+}
+
+int SimDecoder::Conceal(int16_t* pcm, size_t max_samples) {
+    return Synthesize(pcm, max_samples);
+}
+#endif
+
+SimEncoder::SimEncoder(int sample_rate, int duration_ms)
+    : frame_samples_(sample_rate / 1000 * duration_ms),
+      duration_ms_(duration_ms) {
+#if AUDIO_SIM_HAVE_OPUS
+    int error;
+    encoder_ = opus_encoder_create(sample_rate, 1, OPUS_APPLICATION_VOIP, &error);
+    // 与 WiFi 开发板的上行编码配置一致
+    opus_encoder_ctl((OpusEncoder*)encoder_, OPUS_SET_COMPLEXITY(0));
+#endif
+    in_buffer_.reserve(frame_samples_);
+    out_buffer_.resize(1000);
+}
+
+SimEncoder::~SimEncoder() {
+#if AUDIO_SIM_HAVE_OPUS
+    if (encoder_ != nullptr) {
+        opus_encoder_destroy((OpusEncoder*)encoder_);
+    }
+#endif
+}
+
+void SimEncoder::Encode(const int16_t* pcm, size_t samples, const std::function<void(const uint8_t* opus, size_t size)>& handler) {
+    while (samples > 0) {
+        size_t count = std::min(samples, (size_t)frame_samples_ - in_buffer_.size());
+        in_buffer_.insert(in_buffer_.end(), pcm, pcm + count);
+        pcm += count;
+        samples -= count;
+        if (in_buffer_.size() < (size_t)frame_samples_) {
+            break;
+        }
+        int64_t start_us = ThreadCpuUs();
+#if AUDIO_SIM_HAVE_OPUS
+        int ret = opus_encode((OpusEncoder*)encoder_, in_buffer_.data(), frame_samples_, out_buffer_.data(), out_buffer_.size());
+#else
+        BusyWait(FrameCostUs(g_decode_cost_us * 2, duration_ms_));
+        int ret = 120;
+#endif
+        last_encode_us_ = (uint32_t)(ThreadCpuUs() - start_us);
+        in_buffer_.clear();
+        if (ret > 0) {
+            handler(out_buffer_.data(), ret);
+        }
+    }
+}
+
+void SimEncoder::ResetState() {
+#if AUDIO_SIM_HAVE_OPUS
+    opus_encoder_ctl((OpusEncoder*)encoder_, OPUS_RESET_STATE);
+#endif
+    in_buffer_.clear();
+}
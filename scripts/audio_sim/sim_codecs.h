@@ -0,0 +1,65 @@
+#ifndef AUDIO_SIM_CODECS_H
+#define AUDIO_SIM_CODECS_H
+
+#include <functional>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// 模拟器使用的编解码器：找到 libopus 时使用与设备相同的 OpusPlcDecoder 和真实的 Opus 编码器，
+// 否则退化为合成编解码器（固定耗时、输出正弦波），仍可用于测量队列和调度行为
+#if AUDIO_SIM_HAVE_OPUS
+#include "opus_plc_decoder.h"
+using SimDecoder = OpusPlcDecoder;
+#else
+class SimDecoder {
+public:
+    SimDecoder(int sample_rate, int channels, int duration_ms = 60);
+
+    int Decode(const uint8_t* data, size_t size, int16_t* pcm, size_t max_samples);
+    int DecodeFec(const uint8_t* next_data, size_t next_size, int16_t* pcm, size_t max_samples);
+    int Conceal(int16_t* pcm, size_t max_samples);
+    void ResetState() { phase_ = 0; }
+
+    int sample_rate() const { return sample_rate_; }
+    int duration_ms() const { return duration_ms_; }
+    int frame_samples() const { return frame_samples_; }
+
+    // 合成解码一个 60ms 帧的 CPU 耗时（忙等），默认 2ms；其他帧时长按固定开销加线性部分换算
+    static void SetCostUs(int cost_us);
+
+private:
+    int sample_rate_;
+    int duration_ms_;
+    int frame_samples_;
+    uint32_t phase_ = 0;
+
+    int Synthesize(int16_t* pcm, size_t max_samples);
+};
+#endif
+
+// 上行编码器：16kHz 单声道，接口与 OpusUplinkEncoder 相同（输入攒够一帧就编码并回调）
+class SimEncoder {
+public:
+    SimEncoder(int sample_rate, int duration_ms);
+    ~SimEncoder();
+    SimEncoder(const SimEncoder&) = delete;
+    SimEncoder& operator=(const SimEncoder&) = delete;
+
+    // handler 对每个输出包调用一次，opus 只在回调内有效
+    void Encode(const int16_t* pcm, size_t samples, const std::function<void(const uint8_t* opus, size_t size)>& handler);
+    void ResetState();
+    int frame_samples() const { return frame_samples_; }
+    // 最近一帧的编码耗时（线程 CPU 时间，微秒），在 handler 中读取
+    uint32_t last_encode_us() const { return last_encode_us_; }
+
+private:
+    int frame_samples_;
+    int duration_ms_;
+    void* encoder_ = nullptr;
+    std::vector<int16_t> in_buffer_;
+    std::vector<uint8_t> out_buffer_;
+    uint32_t last_encode_us_ = 0;
+};
+
+#endif // AUDIO_SIM_CODECS_H
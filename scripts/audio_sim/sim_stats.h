@@ -0,0 +1,64 @@
+#ifndef AUDIO_SIM_STATS_H
+#define AUDIO_SIM_STATS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <vector>
+
+// 当前线程消耗的 CPU 时间（微秒）。编解码耗时按它统计，线程被抢占的时间不计入，
+// 与进程 CPU 时间可以直接比较
+inline int64_t ThreadCpuUs() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+// 线程安全的样本收集器，用于输出 p50/p99 等统计
+class SampleStats {
+public:
+    void Add(double value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        values_.push_back(value);
+    }
+
+    size_t count() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return values_.size();
+    }
+
+    double Percentile(double p) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (values_.empty()) {
+            return 0;
+        }
+        std::vector<double> sorted(values_);
+        std::sort(sorted.begin(), sorted.end());
+        size_t index = std::min(sorted.size() - 1, (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5));
+        return sorted[index];
+    }
+
+    double Mean() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (values_.empty()) {
+            return 0;
+        }
+        double sum = 0;
+        for (double v : values_) {
+            sum += v;
+        }
+        return sum / values_.size();
+    }
+
+    double Max() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return values_.empty() ? 0 : *std::max_element(values_.begin(), values_.end());
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<double> values_;
+};
+
+#endif // AUDIO_SIM_STATS_H
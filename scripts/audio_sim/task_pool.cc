@@ -0,0 +1,53 @@
+#include "task_pool.h"
+
+TaskPool::TaskPool(int thread_count) {
+    for (int i = 0; i < thread_count; i++) {
+        threads_.emplace_back([this]() { Loop(); });
+    }
+}
+
+TaskPool::~TaskPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    condition_variable_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void TaskPool::Schedule(std::function<void()> callback) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        active_tasks_++;
+        tasks_.push_back(std::move(callback));
+    }
+    condition_variable_.notify_all();
+}
+
+void TaskPool::WaitForCompletion() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_variable_.wait(lock, [this]() { return active_tasks_ == 0; });
+}
+
+void TaskPool::Loop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_variable_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+            if (stop_ && tasks_.empty()) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            active_tasks_--;
+        }
+        condition_variable_.notify_all();
+    }
+}
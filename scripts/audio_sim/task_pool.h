@@ -0,0 +1,32 @@
+#ifndef AUDIO_SIM_TASK_POOL_H
+#define AUDIO_SIM_TASK_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// BackgroundTask 的主机版本：固定数量的工作线程按提交顺序取任务执行
+class TaskPool {
+public:
+    explicit TaskPool(int thread_count);
+    ~TaskPool();
+
+    void Schedule(std::function<void()> callback);
+    void WaitForCompletion();
+
+private:
+    std::mutex mutex_;
+    std::condition_variable condition_variable_;
+    std::list<std::function<void()>> tasks_;
+    std::vector<std::thread> threads_;
+    size_t active_tasks_ = 0;
+    bool stop_ = false;
+
+    void Loop();
+};
+
+#endif // AUDIO_SIM_TASK_POOL_H
@@ -0,0 +1,151 @@
+#include "uplink_sim.h"
+
+#include <cmath>
+
+#include <esp_timer.h>
+
+UplinkSim::UplinkSim(const Config& config, FakeProtocol& protocol)
+    : config_(config),
+      protocol_(protocol),
+      encoder_(config.sample_rate, config.frame_duration_ms),
+      pcm_ring_(config.max_chunks, config.slab_size) {
+    router_.Configure(config.gate_mode, config.hangover_ms, config.keepalive_ms, config.lookback_ms,
+        config.frame_duration_ms);
+}
+
+UplinkSim::~UplinkSim() {
+    Stop();
+}
+
+void UplinkSim::Start() {
+    running_ = true;
+    stop_encode_ = false;
+    router_.Reset();
+    start_time_ = std::chrono::steady_clock::now();
+    encode_ = std::thread([this]() { EncodeLoop(); });
+    capture_ = std::thread([this]() { CaptureLoop(); });
+}
+
+void UplinkSim::Stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    capture_.join();
+    // 采集线程退出之后再让编码线程处理完剩余的块
+    {
+        std::lock_guard<std::mutex> lock(notify_mutex_);
+        notified_ = true;
+        stop_encode_ = true;
+    }
+    notify_cv_.notify_one();
+    encode_.join();
+}
+
+void UplinkSim::CaptureLoop() {
+    auto period = std::chrono::duration<double, std::milli>(config_.frame_duration_ms / config_.speed);
+    auto next = start_time_;
+    uint32_t phase = 0;
+    int cycle_ms = config_.talk_ms + config_.pause_ms;
+    int elapsed_ms = 0;
+    std::vector<int16_t> pcm(encoder_.frame_samples());
+    while (running_) {
+        next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(period);
+        std::this_thread::sleep_until(next);
+
+        // 语音频段的合成信号，使编码器的码率接近真实语音；停顿期间为静音
+        bool speaking = config_.pause_ms <= 0 || elapsed_ms % cycle_ms < config_.talk_ms;
+        elapsed_ms += config_.frame_duration_ms;
+        for (auto& sample : pcm) {
+            double t = (double)phase++ / config_.sample_rate;
+            sample = speaking ? (int16_t)(6000 * std::sin(2 * M_PI * 220 * t) + 2000 * std::sin(2 * M_PI * 1330 * t)) : 0;
+        }
+        // 对应 OnAudioInput：写入 PCM 环形队列并唤醒编码任务，满了就丢弃本块；VAD 判定随块传递
+        uint32_t capture_us = (uint32_t)esp_timer_get_time();
+        if (!pcm_ring_.Push((const uint8_t*)pcm.data(), pcm.size() * sizeof(int16_t), capture_us,
+                speaking ? 1 : 0)) {
+            continue;
+        }
+        int pending = (int)pcm_ring_.Size();
+        if (pending > max_pending_) {
+            max_pending_ = pending;
+        }
+        {
+            std::lock_guard<std::mutex> lock(notify_mutex_);
+            notified_ = true;
+        }
+        notify_cv_.notify_one();
+    }
+}
+
+void UplinkSim::EncodeLoop() {
+    PacketRing::Packet chunk;
+    while (true) {
+        bool stop;
+        {
+            std::unique_lock<std::mutex> lock(notify_mutex_);
+            notify_cv_.wait(lock, [this]() { return notified_; });
+            notified_ = false;
+            stop = stop_encode_;
+        }
+        while (pcm_ring_.Acquire(chunk)) {
+            ProcessChunk((const int16_t*)chunk.data, chunk.size / sizeof(int16_t), chunk.timestamp, chunk.trace_id != 0);
+            pcm_ring_.Release();
+        }
+        if (stop) {
+            return;
+        }
+    }
+}
+
+void UplinkSim::ProcessChunk(const int16_t* pcm, size_t samples, uint32_t capture_us, bool speaking) {
+    // 与 Application::ProcessUplinkChunk 相同的路由
+    auto action = router_.OnCapture(speaking, pcm, samples);
+    if (action == UplinkGate::kMarker) {
+        uint8_t marker = UplinkGate::DtxMarker(config_.frame_duration_ms);
+        protocol_.SendAudio(std::vector<uint8_t>(1, marker));
+        return;
+    }
+    if (action == UplinkGate::kEnterSilence) {
+        protocol_.FlushAudio();
+        return;
+    }
+    if (action == UplinkGate::kSuppress) {
+        return;
+    }
+    if (action == UplinkGate::kResume) {
+        encoder_.ResetState();
+        auto& lookback = router_.lookback();
+        EncodeChunk(lookback.data(), lookback.size(), capture_us);
+    }
+    EncodeChunk(pcm, samples, capture_us);
+}
+
+void UplinkSim::EncodeChunk(const int16_t* pcm, size_t samples, uint32_t capture_us) {
+    encoder_.Encode(pcm, samples, [this, capture_us](const uint8_t* opus, size_t size) {
+        encode_us_.Add(encoder_.last_encode_us());
+        auto action = router_.gate().OnEncoded(size, config_.frame_duration_ms);
+        if (action == UplinkGate::kEnterSilence) {
+            protocol_.FlushAudio();
+        }
+        if (action != UplinkGate::kPass && action != UplinkGate::kMarker) {
+            return;
+        }
+        uint32_t now = (uint32_t)esp_timer_get_time();
+        latency_ms_.Add((now - capture_us) / 1000.0 * config_.speed);
+        protocol_.SendAudio(std::vector<uint8_t>(opus, opus + size));
+    });
+}
+
+UplinkSim::Report UplinkSim::GetReport() {
+    Report report;
+    report.frames = encode_us_.count();
+    report.encode_us_p50 = encode_us_.Percentile(50);
+    report.encode_us_p99 = encode_us_.Percentile(99);
+    report.latency_ms_p50 = latency_ms_.Percentile(50);
+    report.latency_ms_p99 = latency_ms_.Percentile(99);
+    report.max_pending = max_pending_;
+    report.sent_bytes = protocol_.sent_bytes();
+    report.encode_busy_ms = encode_us_.Mean() * encode_us_.count() / 1000.0;
+    report.gate = router_.gate().GetStats();
+    return report;
+}
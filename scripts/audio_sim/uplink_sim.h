@@ -0,0 +1,81 @@
+#ifndef AUDIO_SIM_UPLINK_SIM_H
+#define AUDIO_SIM_UPLINK_SIM_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "packet_ring.h"
+#include "uplink_router.h"
+#include "fake_protocol.h"
+#include "sim_codecs.h"
+#include "sim_stats.h"
+
+// Application 上行链路的主机版本：模拟麦克风按实时节奏产生 16kHz 采集块，写入 PCM 环形队列并唤醒编码线程
+// （对应 AudioEncodeLoop），编码线程经静音抑制路由（UplinkRouter，与设备共用）后编码，把包交给协议发送
+// 说话/停顿按 talk_ms/pause_ms 交替，停顿期间采集静音，模拟本地 VAD 的判定结果
+class UplinkSim {
+public:
+    struct Config {
+        int sample_rate = 16000;
+        int frame_duration_ms = 60;
+        size_t max_chunks = 32;             // AUDIO_UPLINK_PCM_RING_PACKETS
+        size_t slab_size = 16 * 1024;       // AUDIO_UPLINK_PCM_RING_SIZE
+        UplinkGate::Mode gate_mode = UplinkGate::kModeOff;
+        int hangover_ms = 600;              // AUDIO_UPLINK_HANGOVER_MS
+        int keepalive_ms = 1000;            // AUDIO_UPLINK_KEEPALIVE_MS
+        int lookback_ms = 120;              // AUDIO_UPLINK_LOOKBACK_MS
+        int talk_ms = 3000;
+        int pause_ms = 0;                   // 0 表示一直在说话
+        double speed = 1.0;
+    };
+
+    struct Report {
+        size_t frames = 0;
+        double encode_us_p50 = 0;
+        double encode_us_p99 = 0;
+        double latency_ms_p50 = 0;    // 采集完成到交给协议发送
+        double latency_ms_p99 = 0;
+        int max_pending = 0;          // PCM 环形队列中排队的最大块数
+        size_t sent_bytes = 0;
+        double encode_busy_ms = 0;    // 编码占用的 CPU 时间合计
+        UplinkGate::Stats gate;
+    };
+
+    UplinkSim(const Config& config, FakeProtocol& protocol);
+    ~UplinkSim();
+
+    void Start();
+    void Stop();
+    Report GetReport();
+    // 第 k 帧（从 0 开始）的第一个样本在 start_time() + k 个帧时长（除以 speed）时采集
+    std::chrono::steady_clock::time_point start_time() const { return start_time_; }
+
+private:
+    Config config_;
+    FakeProtocol& protocol_;
+    SimEncoder encoder_;
+    PacketRing pcm_ring_;
+    UplinkRouter router_;
+    std::atomic<bool> running_{false};
+    std::thread capture_;
+    std::thread encode_;
+    std::mutex notify_mutex_;
+    std::condition_variable notify_cv_;
+    bool notified_ = false;
+    bool stop_encode_ = false;
+    std::chrono::steady_clock::time_point start_time_;
+    std::atomic<int> max_pending_{0};
+    SampleStats encode_us_;
+    SampleStats latency_ms_;
+
+    void CaptureLoop();
+    void EncodeLoop();
+    void ProcessChunk(const int16_t* pcm, size_t samples, uint32_t capture_us, bool speaking);
+    void EncodeChunk(const int16_t* pcm, size_t samples, uint32_t capture_us);
+};
+
+#endif // AUDIO_SIM_UPLINK_SIM_H
@@ -0,0 +1,359 @@
+// VadEndpointer（NoAudioProcessor 的本地 VAD 和端点检测）的主机测试
+// - 语料：合成的带标注的对话轮次（前导静音 + 若干个词 + 2 秒尾部静音），词由浊音音节（基频脉冲经过两个共振峰）
+//   和可选的清辅音尾（高通噪声）组成，词间停顿短于 hangover；背景分别为安静、白噪声、50Hz 嗡声、
+//   中途变大的噪声，信噪比 5~25dB；另有只有背景没有语音的片段，检查误触发
+// - 端点延迟：说话结束判定时刻减去标注的最后一个语音样本，给出分布；判定早于标注结束即为截断
+//   vad_endpointer_tool [--hangover-ms 500] [--onset-ms 30] [--turns 40] [--dump dir]
+//   vad_endpointer_tool --pcm turn.pcm --labels turn.txt   （录音：16kHz 单声道 s16le，标注每行一个语音段 "开始ms 结束ms"）
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "vad_endpointer.h"
+
+static const int kSampleRate = 16000;
+static const int kChunkSamples = 480;  // NoAudioProcessor 每次送入 30ms
+
+struct Turn {
+    std::string name;
+    std::vector<int16_t> pcm;
+    int speech_start = -1;     // 标注的语音起止（样本），没有语音时为 -1
+    int speech_end = -1;
+};
+
+struct TurnResult {
+    bool started = false;
+    bool ended = false;
+    int onset_ms = 0;           // 开始判定相对标注开始
+    int endpoint_ms = 0;        // 结束判定相对标注结束
+    int starts = 0;
+};
+
+class Resonator {
+public:
+    Resonator(double freq, double bandwidth) {
+        double r = std::exp(-M_PI * bandwidth / kSampleRate);
+        a1_ = 2 * r * std::cos(2 * M_PI * freq / kSampleRate);
+        a2_ = -r * r;
+        gain_ = 1 - r;
+    }
+    double Process(double x) {
+        double y = gain_ * x + a1_ * y1_ + a2_ * y2_;
+        y2_ = y1_;
+        y1_ = y;
+        return y;
+    }
+
+private:
+    double a1_, a2_, gain_;
+    double y1_ = 0, y2_ = 0;
+};
+
+// 一个词：1~3 个浊音音节，音节间 30~80ms 停顿，可选 60~120ms 的清辅音尾（比浊音低约 12dB）
+static std::vector<double> MakeWord(std::mt19937& rng) {
+    std::uniform_real_distribution<double> uniform(0, 1);
+    std::vector<double> word;
+    int syllables = 1 + rng() % 3;
+    for (int s = 0; s < syllables; s++) {
+        if (s > 0) {
+            word.resize(word.size() + (30 + rng() % 50) * kSampleRate / 1000, 0);
+        }
+        int length = (120 + rng() % 180) * kSampleRate / 1000;
+        double f0 = 100 + 150 * uniform(rng);
+        Resonator f1(500 + 400 * uniform(rng), 80);
+        Resonator f2(1200 + 1200 * uniform(rng), 120);
+        double phase = 0;
+        for (int i = 0; i < length; i++) {
+            phase += f0 * (1 + 0.1 * std::sin(2 * M_PI * 3 * i / kSampleRate)) / kSampleRate;
+            double pulse = 0;
+            if (phase >= 1) {
+                phase -= 1;
+                pulse = 1;
+            }
+            double envelope = std::sin(M_PI * i / length);
+            word.push_back(envelope * (f1.Process(pulse) * 4 + f2.Process(pulse) * 2));
+        }
+    }
+    if (rng() % 2 == 0) {
+        std::normal_distribution<double> noise(0, 1);
+        int length = (60 + rng() % 60) * kSampleRate / 1000;
+        double previous = 0;
+        for (int i = 0; i < length; i++) {
+            double x = noise(rng);
+            double envelope = std::sin(M_PI * i / length);
+            word.push_back(0.05 * envelope * (x - previous));
+            previous = x;
+        }
+    }
+    return word;
+}
+
+static double Rms(const std::vector<double>& x) {
+    double sum = 0;
+    for (double v : x) {
+        sum += v * v;
+    }
+    return std::sqrt(sum / std::max<size_t>(1, x.size()));
+}
+
+// background：quiet | white | hum | step
+static Turn MakeTurn(std::mt19937& rng, const std::string& background, double snr_db, bool with_speech, int index) {
+    std::normal_distribution<double> noise(0, 1);
+    int lead = (300 + rng() % 700) * kSampleRate / 1000;
+    std::vector<double> speech;
+    if (with_speech) {
+        int words = 1 + rng() % 5;
+        for (int w = 0; w < words; w++) {
+            if (w > 0) {
+                speech.resize(speech.size() + (150 + rng() % 200) * kSampleRate / 1000, 0);
+            }
+            auto word = MakeWord(rng);
+            speech.insert(speech.end(), word.begin(), word.end());
+        }
+    }
+    int tail = 2 * kSampleRate;
+    size_t total = lead + speech.size() + tail;
+
+    double noise_rms = background == "quiet" ? 10 : 300;
+    double speech_rms = noise_rms * std::pow(10, snr_db / 20);
+    double scale = speech.empty() ? 0 : speech_rms / Rms(speech);
+
+    Turn turn;
+    char name[64];
+    snprintf(name, sizeof(name), "%s_%s_%02.0fdB_%02d", with_speech ? "turn" : "noise", background.c_str(), snr_db, index);
+    turn.name = name;
+    turn.pcm.resize(total);
+    double hum_phase = 0;
+    for (size_t i = 0; i < total; i++) {
+        double value = 0;
+        if (background == "hum") {
+            hum_phase += 50.0 / kSampleRate;
+            value = noise_rms * std::sqrt(2) * std::sin(2 * M_PI * hum_phase) + 0.1 * noise_rms * noise(rng);
+        } else if (background == "step") {
+            // 前导静音中途噪声从 1/4 跳到全量（例如开了风扇）
+            double level = i < (size_t)lead / 2 ? 0.25 : 1.0;
+            value = level * noise_rms * noise(rng);
+        } else {
+            value = noise_rms * noise(rng);
+        }
+        if (i >= (size_t)lead && i < lead + speech.size()) {
+            value += scale * speech[i - lead];
+        }
+        turn.pcm[i] = (int16_t)std::max(-32767.0, std::min(32767.0, value));
+    }
+    if (with_speech) {
+        // 标注到最后一个非零语音样本（清辅音尾的包络在末端为零）
+        int last = (int)speech.size() - 1;
+        while (last > 0 && std::fabs(speech[last]) * scale < 1) {
+            last--;
+        }
+        turn.speech_start = lead;
+        turn.speech_end = lead + last + 1;
+    }
+    return turn;
+}
+
+static TurnResult RunTurn(const Turn& turn, int hangover_ms, int onset_ms) {
+    VadEndpointer vad;
+    vad.Configure(kSampleRate, hangover_ms, onset_ms);
+    TurnResult result;
+    for (size_t offset = 0; offset < turn.pcm.size(); offset += kChunkSamples) {
+        size_t count = std::min<size_t>(kChunkSamples, turn.pcm.size() - offset);
+        auto event = vad.Process(turn.pcm.data() + offset, count);
+        // 事件在块末尾上报：判定时刻按块末尾计，与设备上回调的时机一致
+        int now = (int)(offset + count);
+        if (event == VadEndpointer::kSpeechStart) {
+            if (!result.started) {
+                result.started = true;
+                result.onset_ms = (now - turn.speech_start) * 1000 / kSampleRate;
+            }
+        } else if (event == VadEndpointer::kSpeechEnd && result.started && !result.ended && now >= turn.speech_end) {
+            // 标注结束之前的结束判定是句中截断，不算端点；只统计次数
+            result.ended = true;
+            result.endpoint_ms = (now - turn.speech_end) * 1000 / kSampleRate;
+        }
+    }
+    result.starts = vad.GetStats().starts;
+    return result;
+}
+
+static int Percentile(std::vector<int> values, int percent) {
+    if (values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, values.size() * percent / 100)];
+}
+
+static bool LoadTurn(const std::string& pcm_path, const std::string& labels_path, Turn& turn) {
+    FILE* f = fopen(pcm_path.c_str(), "rb");
+    if (!f) {
+        fprintf(stderr, "cannot open %s\n", pcm_path.c_str());
+        return false;
+    }
+    int16_t buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, sizeof(int16_t), 4096, f)) > 0) {
+        turn.pcm.insert(turn.pcm.end(), buffer, buffer + n);
+    }
+    fclose(f);
+    f = fopen(labels_path.c_str(), "r");
+    if (!f) {
+        fprintf(stderr, "cannot open %s\n", labels_path.c_str());
+        return false;
+    }
+    int start_ms, end_ms;
+    while (fscanf(f, "%d %d", &start_ms, &end_ms) == 2) {
+        if (turn.speech_start < 0) {
+            turn.speech_start = start_ms * kSampleRate / 1000;
+        }
+        turn.speech_end = end_ms * kSampleRate / 1000;
+    }
+    fclose(f);
+    turn.name = pcm_path;
+    return true;
+}
+
+static void DumpTurn(const std::string& dir, const Turn& turn) {
+    std::string base = dir + "/" + turn.name;
+    FILE* f = fopen((base + ".pcm").c_str(), "wb");
+    if (f) {
+        fwrite(turn.pcm.data(), sizeof(int16_t), turn.pcm.size(), f);
+        fclose(f);
+    }
+    f = fopen((base + ".txt").c_str(), "w");
+    if (f) {
+        if (turn.speech_start >= 0) {
+            fprintf(f, "%d %d\n", turn.speech_start * 1000 / kSampleRate, turn.speech_end * 1000 / kSampleRate);
+        }
+        fclose(f);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int hangover_ms = 500;
+    int onset_ms = 30;
+    int turns_per_condition = 40;
+    std::string dump_dir;
+    std::string pcm_path;
+    std::string labels_path;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string option = argv[i];
+        if (option == "--hangover-ms") {
+            hangover_ms = atoi(argv[i + 1]);
+        } else if (option == "--onset-ms") {
+            onset_ms = atoi(argv[i + 1]);
+        } else if (option == "--turns") {
+            turns_per_condition = atoi(argv[i + 1]);
+        } else if (option == "--dump") {
+            dump_dir = argv[i + 1];
+        } else if (option == "--pcm") {
+            pcm_path = argv[i + 1];
+        } else if (option == "--labels") {
+            labels_path = argv[i + 1];
+        }
+    }
+
+    std::vector<Turn> corpus;
+    if (!pcm_path.empty()) {
+        Turn turn;
+        if (!LoadTurn(pcm_path, labels_path, turn)) {
+            return 1;
+        }
+        corpus.push_back(std::move(turn));
+    } else {
+        std::mt19937 rng(2024);
+        struct Condition {
+            const char* background;
+            double snr_db;
+        };
+        const Condition conditions[] = {
+            {"quiet", 25}, {"white", 20}, {"white", 10}, {"white", 5}, {"hum", 10}, {"step", 10},
+        };
+        for (const auto& condition : conditions) {
+            for (int i = 0; i < turns_per_condition; i++) {
+                corpus.push_back(MakeTurn(rng, condition.background, condition.snr_db, true, i));
+            }
+            for (int i = 0; i < turns_per_condition / 4; i++) {
+                corpus.push_back(MakeTurn(rng, condition.background, condition.snr_db, false, i));
+            }
+        }
+    }
+    if (!dump_dir.empty()) {
+        for (const auto& turn : corpus) {
+            DumpTurn(dump_dir, turn);
+        }
+        printf("corpus written to %s (%zu turns, 16kHz mono s16le + labels)\n", dump_dir.c_str(), corpus.size());
+    }
+
+    printf("hangover %dms, onset %dms, %zu turns\n", hangover_ms, onset_ms, corpus.size());
+    printf("  %-22s %6s %6s %6s %8s %8s %8s %8s\n", "condition", "turns", "missed", "split", "false", "onset50", "end50", "end90");
+    std::vector<int> all_endpoints;
+    int missed = 0;
+    int split = 0;
+    int false_starts = 0;
+    size_t begin = 0;
+    while (begin < corpus.size()) {
+        // 按名称中的背景和信噪比分组（录音单独一组）
+        std::string group = corpus[begin].name.substr(0, corpus[begin].name.rfind('_'));
+        group = group.substr(group.find('_') + 1);
+        std::vector<int> onsets;
+        std::vector<int> endpoints;
+        int group_turns = 0;
+        int group_missed = 0;
+        int group_split = 0;
+        int group_false = 0;
+        size_t end = begin;
+        for (; end < corpus.size(); end++) {
+            std::string name = corpus[end].name.substr(0, corpus[end].name.rfind('_'));
+            if (name.substr(name.find('_') + 1) != group) {
+                break;
+            }
+            const auto& turn = corpus[end];
+            auto result = RunTurn(turn, hangover_ms, onset_ms);
+            if (turn.speech_start < 0) {
+                group_false += result.starts;
+                continue;
+            }
+            group_turns++;
+            if (!result.started || !result.ended) {
+                group_missed++;
+                continue;
+            }
+            // 一个轮次内多次开始：句中停顿被判为说话结束（本地自动停止时会截断）
+            if (result.starts > 1) {
+                group_split++;
+            }
+            onsets.push_back(result.onset_ms);
+            endpoints.push_back(result.endpoint_ms);
+        }
+        printf("  %-22s %6d %6d %6d %8d %8d %8d %8d\n", group.c_str(), group_turns, group_missed, group_split, group_false,
+            Percentile(onsets, 50), Percentile(endpoints, 50), Percentile(endpoints, 90));
+        all_endpoints.insert(all_endpoints.end(), endpoints.begin(), endpoints.end());
+        missed += group_missed;
+        split += group_split;
+        false_starts += group_false;
+        begin = end;
+    }
+
+    printf("endpoint latency after labelled end of speech (%zu turns):\n", all_endpoints.size());
+    printf("  p50 %dms, p90 %dms, p99 %dms, max %dms\n", Percentile(all_endpoints, 50), Percentile(all_endpoints, 90),
+        Percentile(all_endpoints, 99), Percentile(all_endpoints, 100));
+    // 以 hangover 为起点按 50ms 分桶
+    const int kBuckets = 8;
+    int buckets[kBuckets] = {};
+    for (int latency : all_endpoints) {
+        int bucket = std::max(0, std::min(kBuckets - 1, (latency - hangover_ms) / 50));
+        buckets[bucket]++;
+    }
+    printf("  distribution:");
+    for (int i = 0; i < kBuckets; i++) {
+        printf(i < kBuckets - 1 ? " <%dms:%d" : " >=%dms:%d", hangover_ms + (i < kBuckets - 1 ? (i + 1) * 50 : i * 50), buckets[i]);
+    }
+    printf("\n  missed %d, split %d, false starts %d\n", missed, split, false_starts);
+    return missed == 0 && split == 0 && false_starts == 0 ? 0 : 3;
+}
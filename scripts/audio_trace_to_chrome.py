@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+# 把设备导出的音频延迟追踪（self.audio.dump_trace 各页返回值拼接后的文本，或串口日志）转换为 Chrome/Perfetto trace JSON
+# 用法：python audio_trace_to_chrome.py trace.txt -o trace.json，然后在 chrome://tracing 或 ui.perfetto.dev 中打开
+import argparse
+import json
+import re
+import sys
+
+# 与 main/audio_processing/audio_trace.h 中的 AudioTrace::Event 保持一致
+EV_RX = 1
+EV_RX_DROP = 2
+EV_DECODE_START = 3
+EV_DECODE_END = 4
+EV_RESAMPLE_END = 5
+EV_ENQUEUE = 6
+EV_OUTPUT_START = 7
+EV_OUTPUT_END = 8
+EV_UPLINK_CAPTURE = 9
+EV_UPLINK_ENCODE_START = 10
+EV_UPLINK_ENCODE_END = 11
+EV_UPLINK_SEND_START = 12
+EV_UPLINK_SEND_END = 13
+
+DECODE_MODES = {0: "normal", 1: "fec", 2: "conceal", 3: "pcm16", 4: "adpcm"}
+
+# (阶段名, 起点事件, 终点事件, 显示的线程号)
+STAGES = [
+    ("wait_decode", EV_RX, EV_DECODE_START, 1),
+    ("decode", EV_DECODE_START, EV_DECODE_END, 2),
+    ("resample", EV_DECODE_END, EV_RESAMPLE_END, 3),
+    ("wait_output", EV_ENQUEUE, EV_OUTPUT_START, 4),
+    ("i2s_write", EV_OUTPUT_START, EV_OUTPUT_END, 5),
+    ("end_to_end", EV_RX, EV_OUTPUT_END, 6),
+    # 上行：编码出的帧沿用完成该帧的采集块的 ID
+    ("up_wait_encode", EV_UPLINK_CAPTURE, EV_UPLINK_ENCODE_START, 7),
+    ("up_encode", EV_UPLINK_ENCODE_START, EV_UPLINK_ENCODE_END, 8),
+    ("up_wait_send", EV_UPLINK_ENCODE_END, EV_UPLINK_SEND_START, 9),
+    ("up_send", EV_UPLINK_SEND_START, EV_UPLINK_SEND_END, 10),
+    ("up_end_to_end", EV_UPLINK_CAPTURE, EV_UPLINK_SEND_END, 11),
+]
+
+LINE_RE = re.compile(r"AT,(\d+),(\d+),(\d+),(\d+)")
+
+
+def parse(lines):
+    events = []
+    last_raw = None
+    offset = 0
+    for line in lines:
+        m = LINE_RE.search(line)
+        if not m:
+            continue
+        raw, trace_id, event, arg = (int(x) for x in m.groups())
+        # 设备时间是 32 位微秒计数，回绕时补上 2^32
+        if last_raw is not None and raw < last_raw and last_raw - raw > (1 << 31):
+            offset += 1 << 32
+        last_raw = raw
+        events.append((raw + offset, trace_id, event, arg))
+    return events
+
+
+def percentile(values, p):
+    values = sorted(values)
+    index = min(len(values) - 1, int(round(p / 100.0 * (len(values) - 1))))
+    return values[index]
+
+
+def convert(events):
+    trace_events = []
+    for name, _, _, tid in STAGES:
+        trace_events.append({"ph": "M", "name": "thread_name", "pid": 1, "tid": tid, "args": {"name": name}})
+
+    # 同一 ID 可能有多次解码（FEC/PLC 帧与正常帧共用 ID），终点事件与最近一次起点配对
+    starts = {}
+    durations = {name: [] for name, _, _, _ in STAGES}
+    for time_us, trace_id, event, arg in events:
+        if event == EV_RX_DROP:
+            trace_events.append({"ph": "i", "name": "rx_drop", "pid": 1, "tid": 1, "ts": time_us,
+                                 "s": "t", "args": {"id": trace_id, "bytes": arg}})
+            continue
+        for name, start_event, end_event, tid in STAGES:
+            if event == end_event and (trace_id, start_event) in starts:
+                start_us = starts[(trace_id, start_event)]
+                args = {"id": trace_id}
+                if event in (EV_DECODE_END, EV_RESAMPLE_END, EV_OUTPUT_END):
+                    args["samples"] = arg
+                elif event == EV_UPLINK_ENCODE_END:
+                    args["bytes"] = arg
+                elif event == EV_UPLINK_SEND_END:
+                    args["success"] = arg
+                trace_events.append({"ph": "X", "name": name, "pid": 1, "tid": tid, "ts": start_us,
+                                     "dur": time_us - start_us, "args": args})
+                durations[name].append((time_us - start_us) / 1000.0)
+        starts[(trace_id, event)] = time_us
+        if event == EV_DECODE_START:
+            trace_events.append({"ph": "i", "name": DECODE_MODES.get(arg, str(arg)), "pid": 1, "tid": 2,
+                                 "ts": time_us, "s": "t", "args": {"id": trace_id}})
+        elif event == EV_ENQUEUE:
+            trace_events.append({"ph": "C", "name": "playback_queue", "pid": 1, "ts": time_us,
+                                 "args": {"frames": arg}})
+    return trace_events, durations
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("input", help="导出的追踪文本或串口日志")
+    parser.add_argument("-o", "--output", default="audio_trace.json", help="输出的 trace JSON 路径")
+    args = parser.parse_args()
+
+    with open(args.input, "r", encoding="utf-8", errors="ignore") as f:
+        events = parse(f)
+    if not events:
+        print("No trace records found", file=sys.stderr)
+        sys.exit(1)
+
+    trace_events, durations = convert(events)
+    with open(args.output, "w", encoding="utf-8") as f:
+        json.dump({"traceEvents": trace_events, "displayTimeUnit": "ms"}, f)
+
+    print(f"{len(events)} records -> {args.output}")
+    for name, values in durations.items():
+        if values:
+            print(f"{name:14s} n={len(values):5d}  p50={percentile(values, 50):7.1f}ms  "
+                  f"p95={percentile(values, 95):7.1f}ms  p99={percentile(values, 99):7.1f}ms  max={max(values):7.1f}ms")
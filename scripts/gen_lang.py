@@ -28,7 +28,18 @@ namespace Lang {{
 }}
 """
 
-def generate_header(input_path, output_path):
+def sound_declaration(base_name, predecoded):
+    # 预解码的提示音嵌入的是 gen_prompt_pcm.py 生成的 .pcm 文件，常量名保持不变
+    ext = 'pcm' if base_name in predecoded else 'p3'
+    return f'''
+        extern const char p3_{base_name}_start[] asm("_binary_{base_name}_{ext}_start");
+        extern const char p3_{base_name}_end[] asm("_binary_{base_name}_{ext}_end");
+        static const std::string_view P3_{base_name.upper()} {{
+        static_cast<const char*>(p3_{base_name}_start),
+        static_cast<size_t>(p3_{base_name}_end - p3_{base_name}_start)
+        }};'''
+
+def generate_header(input_path, output_path, predecoded=()):
     with open(input_path, 'r', encoding='utf-8') as f:
         data = json.load(f)
 
@@ -48,26 +59,12 @@ def generate_header(input_path, output_path):
     # 生成音效常量
     for file in os.listdir(os.path.dirname(input_path)):
         if file.endswith('.p3'):
-            base_name = os.path.splitext(file)[0]
-            sounds.append(f'''
-        extern const char p3_{base_name}_start[] asm("_binary_{base_name}_p3_start");
-        extern const char p3_{base_name}_end[] asm("_binary_{base_name}_p3_end");
-        static const std::string_view P3_{base_name.upper()} {{
-        static_cast<const char*>(p3_{base_name}_start),
-        static_cast<size_t>(p3_{base_name}_end - p3_{base_name}_start)
-        }};''')
+            sounds.append(sound_declaration(os.path.splitext(file)[0], predecoded))
     
     # 生成公共音效
     for file in os.listdir(os.path.join(os.path.dirname(output_path), 'common')):
         if file.endswith('.p3'):
-            base_name = os.path.splitext(file)[0]
-            sounds.append(f'''
-        extern const char p3_{base_name}_start[] asm("_binary_{base_name}_p3_start");
-        extern const char p3_{base_name}_end[] asm("_binary_{base_name}_p3_end");
-        static const std::string_view P3_{base_name.upper()} {{
-        static_cast<const char*>(p3_{base_name}_start),
-        static_cast<size_t>(p3_{base_name}_end - p3_{base_name}_start)
-        }};''')
+            sounds.append(sound_declaration(os.path.splitext(file)[0], predecoded))
 
     # 填充模板
     content = HEADER_TEMPLATE.format(
@@ -86,6 +83,7 @@ if __name__ == "__main__":
     parser = argparse.ArgumentParser()
     parser.add_argument("--input", required=True, help="输入JSON文件路径")
     parser.add_argument("--output", required=True, help="输出头文件路径")
+    parser.add_argument("--predecoded", default="", help="以空格分隔的预解码提示音名称（不含扩展名）")
     args = parser.parse_args()
 
-    generate_header(args.input, args.output)
\ No newline at end of file
+    generate_header(args.input, args.output, set(args.predecoded.split()))
\ No newline at end of file
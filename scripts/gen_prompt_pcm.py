@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+# 构建时把 .p3（Opus）提示音预解码为 PCM16 或 IMA-ADPCM，播放时无需 Opus 解码
+#
+# 输出格式（小端）：
+#   头部 16 字节：magic "PCMP", format(1=PCM16, 2=IMA-ADPCM), channels(1), block_samples(u16),
+#                 sample_rate(u32), total_samples(u32)
+#   PCM16：total_samples 个 int16
+#   IMA-ADPCM：若干块，每块 predictor(i16) + step_index(u8) + reserved(u8) + block_samples/2 字节，
+#              低半字节在前；最后一块可以不足 block_samples，样本数总是偶数
+import argparse
+import struct
+
+import numpy as np
+import opuslib
+
+FORMAT_PCM16 = 1
+FORMAT_ADPCM = 2
+
+OPUS_SAMPLE_RATES = (8000, 12000, 16000, 24000, 48000)
+
+IMA_INDEX_TABLE = [-1, -1, -1, -1, 2, 4, 6, 8] * 2
+IMA_STEP_TABLE = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+    11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+    32767,
+]
+
+
+def decode_p3(input_file, sample_rate):
+    # Opus 可以直接解码到 8/12/16/24/48kHz，其它采样率先解码到 48kHz 再插值
+    decode_rate = sample_rate if sample_rate in OPUS_SAMPLE_RATES else 48000
+    decoder = opuslib.Decoder(decode_rate, 1)
+    max_frame_size = decode_rate * 120 // 1000
+
+    frames = []
+    with open(input_file, 'rb') as f:
+        data = f.read()
+    offset = 0
+    while offset + 4 <= len(data):
+        _, _, payload_size = struct.unpack('>BBH', data[offset:offset + 4])
+        offset += 4
+        payload = data[offset:offset + payload_size]
+        offset += payload_size
+        if len(payload) != payload_size:
+            break
+        pcm = decoder.decode(payload, max_frame_size)
+        frames.append(np.frombuffer(pcm, dtype=np.int16))
+
+    audio = np.concatenate(frames) if frames else np.zeros(0, dtype=np.int16)
+    if decode_rate != sample_rate and len(audio) > 0:
+        target_len = int(len(audio) * sample_rate / decode_rate)
+        x = np.linspace(0, len(audio) - 1, target_len)
+        audio = np.interp(x, np.arange(len(audio)), audio.astype(np.float32))
+        audio = np.clip(np.round(audio), -32768, 32767).astype(np.int16)
+    return audio
+
+
+def encode_adpcm_block(samples, predictor, index):
+    out = bytearray(struct.pack('<hBB', predictor, index, 0))
+    nibbles = []
+    for sample in samples:
+        step = IMA_STEP_TABLE[index]
+        diff = int(sample) - predictor
+        code = 0
+        if diff < 0:
+            code = 8
+            diff = -diff
+        delta = step >> 3
+        if diff >= step:
+            code |= 4
+            diff -= step
+            delta += step
+        step >>= 1
+        if diff >= step:
+            code |= 2
+            diff -= step
+            delta += step
+        step >>= 1
+        if diff >= step:
+            code |= 1
+            delta += step
+        predictor = predictor - delta if code & 8 else predictor + delta
+        predictor = max(-32768, min(32767, predictor))
+        index = max(0, min(88, index + IMA_INDEX_TABLE[code]))
+        nibbles.append(code)
+    for i in range(0, len(nibbles), 2):
+        out.append(nibbles[i] | (nibbles[i + 1] << 4))
+    return bytes(out), predictor, index
+
+
+def generate(input_file, output_file, fmt, sample_rate, block_ms):
+    audio = decode_p3(input_file, sample_rate)
+    block_samples = sample_rate * block_ms // 1000
+    block_samples -= block_samples % 2
+    if len(audio) % 2:
+        audio = np.append(audio, np.int16(0))
+
+    with open(output_file, 'wb') as f:
+        f.write(b'PCMP')
+        f.write(struct.pack('<BBHII', fmt, 1, block_samples, sample_rate, len(audio)))
+        if fmt == FORMAT_PCM16:
+            f.write(audio.astype('<i2').tobytes())
+            return
+        predictor, index = 0, 0
+        for i in range(0, len(audio), block_samples):
+            block, predictor, index = encode_adpcm_block(audio[i:i + block_samples], predictor, index)
+            f.write(block)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--input", required=True, help="输入 .p3 文件路径")
+    parser.add_argument("--output", required=True, help="输出 .pcm 文件路径")
+    parser.add_argument("--format", choices=["pcm16", "adpcm"], default="pcm16")
+    parser.add_argument("--sample-rate", type=int, default=24000, help="输出采样率，需与编解码器输出采样率一致")
+    parser.add_argument("--block-ms", type=int, default=60, help="每次送入播放的块时长（毫秒）")
+    args = parser.parse_args()
+
+    generate(args.input, args.output,
+             FORMAT_PCM16 if args.format == "pcm16" else FORMAT_ADPCM,
+             args.sample_rate, args.block_ms)